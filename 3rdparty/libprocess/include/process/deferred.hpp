@@ -17,6 +17,7 @@
 
 #include <process/dispatch.hpp>
 #include <process/pid.hpp>
+#include <process/trace.hpp>
 
 #include <stout/preprocessor.hpp>
 
@@ -82,10 +83,12 @@ struct _Deferred
     // We need to explicitly copy the members otherwise we'll
     // implicitly copy 'this' which might not exist at invocation.
     Option<UPID> pid_ = pid;
+    uint64_t span_ = span;
     F&& f_ = std::forward<F>(f);
 
     return std::function<void()>(
         [=]() {
+          trace::Scope scope(span_);
           dispatch(pid_.get(), f_);
         });
   }
@@ -97,10 +100,12 @@ struct _Deferred
     }
 
     Option<UPID> pid_ = pid;
+    uint64_t span_ = span;
     F&& f_ = std::forward<F>(f);
 
     return std::function<void()>(
         [=]() {
+          trace::Scope scope(span_);
           dispatch(pid_.get(), f_);
         });
   }
@@ -112,10 +117,12 @@ struct _Deferred
     }
 
     Option<UPID> pid_ = pid;
+    uint64_t span_ = span;
 
     return lambda::CallableOnce<void()>(
         lambda::partial(
-            [pid_](typename std::decay<F>::type&& f_) {
+            [pid_, span_](typename std::decay<F>::type&& f_) {
+              trace::Scope scope(span_);
               dispatch(pid_.get(), std::move(f_));
             },
             std::forward<F>(f)));
@@ -129,10 +136,12 @@ struct _Deferred
     }
 
     Option<UPID> pid_ = pid;
+    uint64_t span_ = span;
     F&& f_ = std::forward<F>(f);
 
     return std::function<R()>(
         [=]() {
+          trace::Scope scope(span_);
           return dispatch(pid_.get(), f_);
         });
   }
@@ -145,10 +154,12 @@ struct _Deferred
     }
 
     Option<UPID> pid_ = pid;
+    uint64_t span_ = span;
     F&& f_ = std::forward<F>(f);
 
     return std::function<R()>(
         [=]() {
+          trace::Scope scope(span_);
           return dispatch(pid_.get(), f_);
         });
   }
@@ -161,10 +172,12 @@ struct _Deferred
     }
 
     Option<UPID> pid_ = pid;
+    uint64_t span_ = span;
 
     return lambda::CallableOnce<R()>(
         lambda::partial(
-          [pid_](typename std::decay<F>::type&& f_) {
+          [pid_, span_](typename std::decay<F>::type&& f_) {
+            trace::Scope scope(span_);
             return dispatch(pid_.get(), std::move(f_));
           },
           std::forward<F>(f)));
@@ -191,6 +204,7 @@ struct _Deferred
     }                                                                    \
                                                                          \
     Option<UPID> pid_ = pid;                                             \
+    uint64_t span_ = span;                                               \
     F&& f_ = std::forward<F>(f);                                         \
                                                                          \
     return std::function<void(ENUM_PARAMS(N, P))>(                       \
@@ -198,6 +212,7 @@ struct _Deferred
           std::function<void()> f__([=]() {                              \
             f_(ENUM_PARAMS(N, p));                                       \
           });                                                            \
+          trace::Scope scope(span_);                                     \
           dispatch(pid_.get(), f__);                                     \
         });                                                              \
   }                                                                      \
@@ -210,6 +225,7 @@ struct _Deferred
     }                                                                    \
                                                                          \
     Option<UPID> pid_ = pid;                                             \
+    uint64_t span_ = span;                                               \
     F&& f_ = std::forward<F>(f);                                         \
                                                                          \
     return std::function<void(ENUM_PARAMS(N, P))>(                       \
@@ -217,6 +233,7 @@ struct _Deferred
           std::function<void()> f__([=]() {                              \
             f_(ENUM_PARAMS(N, p));                                       \
           });                                                            \
+          trace::Scope scope(span_);                                     \
           dispatch(pid_.get(), f__);                                     \
         });                                                              \
   }                                                                      \
@@ -230,13 +247,15 @@ struct _Deferred
     }                                                                    \
                                                                          \
     Option<UPID> pid_ = pid;                                             \
+    uint64_t span_ = span;                                               \
                                                                          \
     return lambda::CallableOnce<void(ENUM_PARAMS(N, P))>(                \
         lambda::partial(                                                 \
-            [pid_](typename std::decay<F>::type&& f_,                    \
-                   ENUM_BINARY_PARAMS(N, P, &&p)) {                      \
+            [pid_, span_](typename std::decay<F>::type&& f_,             \
+                          ENUM_BINARY_PARAMS(N, P, &&p)) {               \
               lambda::CallableOnce<void()> f__(                          \
                   lambda::partial(std::move(f_), ENUM(N, FORWARD, _)));  \
+              trace::Scope scope(span_);                                 \
               dispatch(pid_.get(), std::move(f__));                      \
             },                                                           \
             std::forward<F>(f),                                          \
@@ -255,6 +274,7 @@ struct _Deferred
     }                                                                   \
                                                                         \
     Option<UPID> pid_ = pid;                                            \
+    uint64_t span_ = span;                                              \
     F&& f_ = std::forward<F>(f);                                        \
                                                                         \
     return std::function<R(ENUM_PARAMS(N, P))>(                         \
@@ -262,6 +282,7 @@ struct _Deferred
           std::function<R()> f__([=]() {                                \
             return f_(ENUM_PARAMS(N, p));                               \
           });                                                           \
+          trace::Scope scope(span_);                                    \
           return dispatch(pid_.get(), f__);                             \
         });                                                             \
   }                                                                     \
@@ -274,6 +295,7 @@ struct _Deferred
     }                                                                   \
                                                                         \
     Option<UPID> pid_ = pid;                                            \
+    uint64_t span_ = span;                                              \
     F&& f_ = std::forward<F>(f);                                        \
                                                                         \
     return std::function<R(ENUM_PARAMS(N, P))>(                         \
@@ -281,6 +303,7 @@ struct _Deferred
           std::function<R()> f__([=]() {                                \
             return f_(ENUM_PARAMS(N, p));                               \
           });                                                           \
+          trace::Scope scope(span_);                                    \
           return dispatch(pid_.get(), f__);                             \
         });                                                             \
   }                                                                     \
@@ -294,13 +317,15 @@ struct _Deferred
     }                                                                   \
                                                                         \
     Option<UPID> pid_ = pid;                                            \
+    uint64_t span_ = span;                                              \
                                                                         \
     return lambda::CallableOnce<R(ENUM_PARAMS(N, P))>(                  \
         lambda::partial(                                                \
-            [pid_](typename std::decay<F>::type&& f_,                   \
-                   ENUM_BINARY_PARAMS(N, P, &&p)) {                     \
+            [pid_, span_](typename std::decay<F>::type&& f_,            \
+                          ENUM_BINARY_PARAMS(N, P, &&p)) {              \
               lambda::CallableOnce<R()> f__(                            \
                   lambda::partial(std::move(f_), ENUM(N, FORWARD, _))); \
+              trace::Scope scope(span_);                                \
               return dispatch(pid_.get(), std::move(f__));              \
         },                                                              \
         std::forward<F>(f),                                             \
@@ -373,12 +398,17 @@ private:
 #undef TEMPLATE
 #undef FORWARD
 
-  _Deferred(const UPID& pid, F&& f) : pid(pid), f(std::forward<F>(f)) {}
+  _Deferred(const UPID& pid, F&& f)
+    : pid(pid), f(std::forward<F>(f)), span(trace::current()) {}
 
-  /*implicit*/ _Deferred(F&& f) : f(std::forward<F>(f)) {}
+  /*implicit*/ _Deferred(F&& f) : f(std::forward<F>(f)), span(0) {}
 
   Option<UPID> pid;
   F f;
+
+  // The span that created this deferred, which becomes the parent of
+  // the dispatch (see `trace::Scope`).
+  uint64_t span;
 };
 
 } // namespace process {
@@ -13,6 +13,7 @@
 #ifndef __PROCESS_EVENT_HPP__
 #define __PROCESS_EVENT_HPP__
 
+#include <chrono>
 #include <memory> // TODO(benh): Replace shared_ptr with unique_ptr.
 
 #include <process/future.hpp>
@@ -57,6 +58,16 @@ struct EventConsumer
 };
 
 
+// Priority with which a process serves an event, see
+// `ProcessBase::prioritize`.
+enum class EventPriority
+{
+  HIGH,
+  NORMAL,
+  LOW,
+};
+
+
 struct Event
 {
   virtual ~Event() {}
@@ -97,6 +108,14 @@ struct Event
 
   // JSON representation for an Event.
   operator JSON::Object() const;
+
+  // When the event was enqueued, used to profile how long events wait
+  // before they are served. Uses a steady clock rather than `Clock`
+  // so that it is unaffected by pausing the clock.
+  std::chrono::steady_clock::time_point enqueued;
+
+  // The span during which the event was enqueued, see `trace::current`.
+  uint64_t parent = 0;
 };
 
 
@@ -179,7 +198,7 @@ struct DispatchEvent : Event
 {
   DispatchEvent(
       const UPID& _pid,
-      std::unique_ptr<lambda::CallableOnce<void(ProcessBase*)>> _f,
+      lambda::CallableOnce<void(ProcessBase*)>&& _f,
       const Option<const std::type_info*>& _functionType)
     : pid(_pid),
       f(std::move(_f)),
@@ -204,8 +223,10 @@ struct DispatchEvent : Event
   // PID receiving the dispatch.
   UPID pid;
 
-  // Function to get invoked as a result of this dispatch event.
-  std::unique_ptr<lambda::CallableOnce<void(ProcessBase*)>> f;
+  // Function to get invoked as a result of this dispatch event. Small
+  // functions are stored inline so that a dispatch only allocates the
+  // event itself.
+  lambda::CallableOnce<void(ProcessBase*)> f;
 
   Option<const std::type_info*> functionType;
 };
@@ -66,6 +66,41 @@ struct wrap;
 template <typename T>
 struct unwrap;
 
+
+// A list of callbacks that stores the first callback inline and only
+// allocates once more callbacks get added, since most futures only
+// ever get a single callback of each kind (e.g., `Future::then`
+// registers a single `onAny` and `onAbandoned` callback).
+template <typename C>
+class CallbackList
+{
+public:
+  void add(C&& callback)
+  {
+    if (first.isNone()) {
+      first = std::move(callback);
+    } else {
+      rest.emplace_back(std::move(callback));
+    }
+  }
+
+  template <typename... Arguments>
+  void run(Arguments&&... arguments) &&
+  {
+    if (first.isSome()) {
+      std::move(first.get())(std::forward<Arguments>(arguments)...);
+
+      for (size_t i = 0; i < rest.size(); ++i) {
+        std::move(rest[i])(std::forward<Arguments>(arguments)...);
+      }
+    }
+  }
+
+private:
+  Option<C> first;
+  std::vector<C> rest;
+};
+
 } // namespace internal {
 
 
@@ -530,9 +565,28 @@ private:
 
   struct Data
   {
+    // The callbacks registered while the future is pending. The kinds
+    // of callbacks that get registered by the combinators (e.g.,
+    // `then`, `repair`, `recover`) store their first callback inline;
+    // the remaining kinds are rarely used.
+    struct Callbacks
+    {
+      internal::CallbackList<AbandonedCallback> onAbandoned;
+      internal::CallbackList<DiscardCallback> onDiscard;
+      std::vector<ReadyCallback> onReady;
+      std::vector<FailedCallback> onFailed;
+      std::vector<DiscardedCallback> onDiscarded;
+      internal::CallbackList<AnyCallback> onAny;
+    };
+
     Data();
     ~Data() = default;
 
+    // Returns the callbacks of this future, allocating them if this
+    // is the first callback being registered. Expects `lock` to be
+    // held.
+    Callbacks& getCallbacks();
+
     void clearAllCallbacks();
 
     std::atomic_flag lock = ATOMIC_FLAG_INIT;
@@ -547,12 +601,10 @@ private:
     //   3. Error, the state is FAILED; 'error()' stores the message.
     Result<T> result;
 
-    std::vector<AbandonedCallback> onAbandonedCallbacks;
-    std::vector<DiscardCallback> onDiscardCallbacks;
-    std::vector<ReadyCallback> onReadyCallbacks;
-    std::vector<FailedCallback> onFailedCallbacks;
-    std::vector<DiscardedCallback> onDiscardedCallbacks;
-    std::vector<AnyCallback> onAnyCallbacks;
+    // Allocated when the first callback gets registered and released
+    // once the future has transitioned out of PENDING, so a completed
+    // future only holds on to its result.
+    std::unique_ptr<Callbacks> callbacks;
   };
 
   // Abandons this future. Returns false if the future is already
@@ -625,6 +677,13 @@ void run(std::vector<C>&& callbacks, Arguments&&... arguments)
   }
 }
 
+
+template <typename C, typename... Arguments>
+void run(CallbackList<C>&& callbacks, Arguments&&... arguments)
+{
+  std::move(callbacks).run(std::forward<Arguments>(arguments)...);
+}
+
 } // namespace internal {
 
 
@@ -1020,10 +1079,12 @@ bool Promise<T>::discard(Future<T> future)
     // ourselves from one of the callbacks erroneously deleting the
     // future. In `Future::_set()` and `Future::fail()` we have to
     // explicitly take a copy to protect ourselves.
-    internal::run(std::move(future.data->onDiscardedCallbacks));
-    internal::run(std::move(future.data->onAnyCallbacks), future);
+    if (future.data->callbacks) {
+      internal::run(std::move(future.data->callbacks->onDiscarded));
+      internal::run(std::move(future.data->callbacks->onAny), future);
 
-    future.data->clearAllCallbacks();
+      future.data->clearAllCallbacks();
+    }
   }
 
   return result;
@@ -1048,21 +1109,27 @@ Future<T>::Data::Data()
     result(None()) {}
 
 
+template <typename T>
+typename Future<T>::Data::Callbacks& Future<T>::Data::getCallbacks()
+{
+  if (!callbacks) {
+    callbacks.reset(new Callbacks());
+  }
+
+  return *callbacks;
+}
+
+
 template <typename T>
 void Future<T>::Data::clearAllCallbacks()
 {
-  onAbandonedCallbacks.clear();
-  onAnyCallbacks.clear();
-  onDiscardCallbacks.clear();
-  onDiscardedCallbacks.clear();
-  onFailedCallbacks.clear();
-  onReadyCallbacks.clear();
+  callbacks.reset();
 }
 
 
 template <typename T>
 Future<T>::Future()
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   data->abandoned = true;
 }
@@ -1070,7 +1137,7 @@ Future<T>::Future()
 
 template <typename T>
 Future<T>::Future(const T& _t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(_t);
 }
@@ -1078,7 +1145,7 @@ Future<T>::Future(const T& _t)
 
 template <typename T>
 Future<T>::Future(T&& _t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(std::move(_t));
 }
@@ -1087,7 +1154,7 @@ Future<T>::Future(T&& _t)
 template <typename T>
 template <typename U>
 Future<T>::Future(const U& u)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   set(u);
 }
@@ -1095,7 +1162,7 @@ Future<T>::Future(const U& u)
 
 template <typename T>
 Future<T>::Future(const Failure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -1103,7 +1170,7 @@ Future<T>::Future(const Failure& failure)
 
 template <typename T>
 Future<T>::Future(const ErrnoFailure& failure)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   fail(failure.message);
 }
@@ -1112,7 +1179,7 @@ Future<T>::Future(const ErrnoFailure& failure)
 template <typename T>
 template <typename E>
 Future<T>::Future(const Try<T, E>& t)
-  : data(new Data())
+  : data(std::make_shared<Data>())
 {
   if (t.isSome()){
     set(t.get());
@@ -1126,7 +1193,7 @@ Future<T>::Future(const Try<T, E>& t)
 template <typename T>
 template <typename E>
 Future<T>::Future(const Try<Future<T>, E>& t)
-  : data(t.isSome() ? t->data : std::shared_ptr<Data>(new Data()))
+  : data(t.isSome() ? t->data : std::make_shared<Data>())
 {
   if (!t.isSome()) {
     // TODO(chhsiao): Consider preserving the error type. See MESOS-8925.
@@ -1161,12 +1228,14 @@ bool Future<T>::discard()
 {
   bool result = false;
 
-  std::vector<DiscardCallback> callbacks;
+  internal::CallbackList<DiscardCallback> callbacks;
   synchronized (data->lock) {
     if (!data->discard && data->state == PENDING) {
       result = data->discard = true;
 
-      callbacks.swap(data->onDiscardCallbacks);
+      if (data->callbacks) {
+        std::swap(callbacks, data->callbacks->onDiscard);
+      }
     }
   }
 
@@ -1186,14 +1255,16 @@ bool Future<T>::abandon(bool propagating)
 {
   bool result = false;
 
-  std::vector<AbandonedCallback> callbacks;
+  internal::CallbackList<AbandonedCallback> callbacks;
   synchronized (data->lock) {
     if (!data->abandoned &&
         data->state == PENDING &&
         (!data->associated || propagating)) {
       result = data->abandoned = true;
 
-      callbacks.swap(data->onAbandonedCallbacks);
+      if (data->callbacks) {
+        std::swap(callbacks, data->callbacks->onAbandoned);
+      }
     }
   }
 
@@ -1281,7 +1352,8 @@ bool Future<T>::await(const Duration& duration) const
   synchronized (data->lock) {
     if (data->state == PENDING) {
       pending = true;
-      data->onAnyCallbacks.push_back(lambda::bind(&internal::awaited, latch));
+      data->getCallbacks().onAny.add(
+          lambda::bind(&internal::awaited, latch));
     }
   }
 
@@ -1340,7 +1412,7 @@ const Future<T>& Future<T>::onAbandoned(AbandonedCallback&& callback) const
     if (data->abandoned) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onAbandonedCallbacks.emplace_back(std::move(callback));
+      data->getCallbacks().onAbandoned.add(std::move(callback));
     }
   }
 
@@ -1362,7 +1434,7 @@ const Future<T>& Future<T>::onDiscard(DiscardCallback&& callback) const
     if (data->discard) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardCallbacks.emplace_back(std::move(callback));
+      data->getCallbacks().onDiscard.add(std::move(callback));
     }
   }
 
@@ -1384,7 +1456,7 @@ const Future<T>& Future<T>::onReady(ReadyCallback&& callback) const
     if (data->state == READY) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onReadyCallbacks.emplace_back(std::move(callback));
+      data->getCallbacks().onReady.emplace_back(std::move(callback));
     }
   }
 
@@ -1406,7 +1478,7 @@ const Future<T>& Future<T>::onFailed(FailedCallback&& callback) const
     if (data->state == FAILED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onFailedCallbacks.emplace_back(std::move(callback));
+      data->getCallbacks().onFailed.emplace_back(std::move(callback));
     }
   }
 
@@ -1428,7 +1500,7 @@ const Future<T>& Future<T>::onDiscarded(DiscardedCallback&& callback) const
     if (data->state == DISCARDED) {
       run = true;
     } else if (data->state == PENDING) {
-      data->onDiscardedCallbacks.emplace_back(std::move(callback));
+      data->getCallbacks().onDiscarded.emplace_back(std::move(callback));
     }
   }
 
@@ -1448,7 +1520,7 @@ const Future<T>& Future<T>::onAny(AnyCallback&& callback) const
 
   synchronized (data->lock) {
     if (data->state == PENDING) {
-      data->onAnyCallbacks.emplace_back(std::move(callback));
+      data->getCallbacks().onAny.add(std::move(callback));
     } else {
       run = true;
     }
@@ -1785,10 +1857,12 @@ bool Future<T>::_set(U&& u)
     // Grab a copy of `data` just in case invoking the callbacks
     // erroneously attempts to delete this future.
     std::shared_ptr<typename Future<T>::Data> copy = data;
-    internal::run(std::move(copy->onReadyCallbacks), copy->result.get());
-    internal::run(std::move(copy->onAnyCallbacks), *this);
+    if (copy->callbacks) {
+      internal::run(std::move(copy->callbacks->onReady), copy->result.get());
+      internal::run(std::move(copy->callbacks->onAny), *this);
 
-    copy->clearAllCallbacks();
+      copy->clearAllCallbacks();
+    }
   }
 
   return result;
@@ -1815,10 +1889,13 @@ bool Future<T>::fail(const std::string& _message)
     // Grab a copy of `data` just in case invoking the callbacks
     // erroneously attempts to delete this future.
     std::shared_ptr<typename Future<T>::Data> copy = data;
-    internal::run(std::move(copy->onFailedCallbacks), copy->result.error());
-    internal::run(std::move(copy->onAnyCallbacks), *this);
+    if (copy->callbacks) {
+      internal::run(
+          std::move(copy->callbacks->onFailed), copy->result.error());
+      internal::run(std::move(copy->callbacks->onAny), *this);
 
-    copy->clearAllCallbacks();
+      copy->clearAllCallbacks();
+    }
   }
 
   return result;
@@ -32,6 +32,7 @@
 #include <process/pid.hpp>
 #include <process/socket.hpp>
 
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/ip.hpp>
@@ -1175,15 +1176,44 @@ Request createRequest(
  * Asynchronously sends an HTTP request to the process and
  * returns the HTTP response once the entire response is received.
  *
+ * If 'request.keepAlive' is set, the request is sent over a pooled
+ * persistent connection to the same scheme, host and port: an idle
+ * connection is reused when available, a new one is opened while
+ * below the pool limits, and otherwise the request is pipelined
+ * onto the least loaded connection. See `setConnectionPoolLimits`.
+ *
  * @param streamedResponse Being true indicates the HTTP response will
  *     be 'PIPE' type, and caller must read the response body from the
  *     Pipe::Reader, otherwise, the HTTP response will be 'BODY' type.
+ *     Streamed responses are never sent over pooled connections.
  */
 Future<Response> request(
     const Request& request,
     bool streamedResponse = false);
 
 
+/**
+ * Limits applied to the connection pool used by `request` for
+ * keep-alive requests.
+ */
+struct ConnectionPoolLimits
+{
+  // Maximum number of connections kept open per destination.
+  size_t maxConnections = 4;
+
+  // Connections left idle for this long are closed.
+  Duration idleTimeout = Seconds(60);
+};
+
+
+/**
+ * Updates the limits of the connection pool used by `request`.
+ * Already open connections in excess of a lowered limit are
+ * closed as they become idle.
+ */
+void setConnectionPoolLimits(const ConnectionPoolLimits& limits);
+
+
 // TODO(Yongqiao Wang): Refactor other functions
 // (such as post/get/requestDelete) to use the 'request' function.
 
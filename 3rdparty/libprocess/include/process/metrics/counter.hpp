@@ -13,16 +13,26 @@
 #ifndef __PROCESS_METRICS_COUNTER_HPP__
 #define __PROCESS_METRICS_COUNTER_HPP__
 
+#include <stddef.h>
+
+#include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 
 #include <process/metrics/metric.hpp>
 
+#include <stout/foreach.hpp>
+
 namespace process {
 namespace metrics {
 
 // A Metric that represents an integer value that can be incremented and
 // decremented.
+//
+// The value is spread across several shards so that threads which
+// increment the same counter concurrently do not contend on a single
+// cache line. Reading the value sums the shards.
 class Counter : public Metric
 {
 public:
@@ -33,19 +43,28 @@ public:
     : Metric(name, window),
       data(new Data())
   {
-    push(static_cast<double>(data->value.load()));
+    push(static_cast<double>(data->value()));
   }
 
   virtual ~Counter() {}
 
   virtual Future<double> value() const
   {
-    return static_cast<double>(data->value.load());
+    return static_cast<double>(data->value());
   }
 
+  virtual Option<double> peek(const Option<Duration>&) const
+  {
+    return static_cast<double>(data->value());
+  }
+
+  // NOTE: Increments that race with a reset may survive it.
   void reset()
   {
-    data->value.store(0);
+    foreach (Data::Shard& shard, data->shards) {
+      shard.value.store(0);
+    }
+
     push(0);
   }
 
@@ -63,17 +82,49 @@ public:
 
   Counter& operator+=(int64_t v)
   {
-    int64_t prev = data->value.fetch_add(v);
-    push(static_cast<double>(prev + v));
+    data->shards[shard()].value.fetch_add(v, std::memory_order_relaxed);
+
+    if (tracking()) {
+      push(static_cast<double>(data->value()));
+    }
+
     return *this;
   }
 
 private:
-  struct Data
+  static constexpr size_t SHARDS = 8;
+
+  // Returns the shard for the calling thread. Threads are assigned to
+  // shards round-robin when they first increment a counter.
+  static size_t shard()
   {
-    explicit Data() : value(0) {}
+    static std::atomic<size_t> next(0);
+    static thread_local size_t index = next++ % SHARDS;
+    return index;
+  }
 
-    std::atomic<int64_t> value;
+  struct Data
+  {
+    // Padded to keep the values of different shards on different
+    // cache lines.
+    struct Shard
+    {
+      Shard() : value(0) {}
+
+      std::atomic<int64_t> value;
+      char padding[64 - sizeof(std::atomic<int64_t>)];
+    };
+
+    int64_t value() const
+    {
+      int64_t sum = 0;
+      foreach (const Shard& shard, shards) {
+        sum += shard.value.load(std::memory_order_relaxed);
+      }
+      return sum;
+    }
+
+    std::array<Shard, SHARDS> shards;
   };
 
   std::shared_ptr<Data> data;
@@ -0,0 +1,129 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_METRICS_HISTOGRAM_HPP__
+#define __PROCESS_METRICS_HISTOGRAM_HPP__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+namespace process {
+namespace metrics {
+
+// Counts observed values into a fixed set of buckets. Unlike the
+// `TimeSeries` used for `Statistics`, the memory used is constant and
+// reading the histogram requires no sorting. Histograms with the same
+// buckets can be merged by adding up their counts.
+//
+// Observations are lock-free and may be made from any thread.
+class Histogram
+{
+public:
+  // A point in time copy of the counts of a histogram.
+  struct Snapshot
+  {
+    // Adds the counts of 'that', which must have the same buckets.
+    Snapshot& operator+=(const Snapshot& that)
+    {
+      CHECK(bounds == that.bounds);
+
+      for (size_t i = 0; i < counts.size(); ++i) {
+        counts[i] += that.counts[i];
+      }
+
+      sum += that.sum;
+      count += that.count;
+
+      return *this;
+    }
+
+    // The inclusive upper bounds of the buckets, in increasing order.
+    std::vector<double> bounds;
+
+    // The number of values in each bucket, i.e., the values greater
+    // than the previous bound and at most the bound. The last entry
+    // counts the values greater than the last bound.
+    std::vector<uint64_t> counts;
+
+    double sum = 0.0;
+    uint64_t count = 0;
+
+    // The unit of the bounds and the sum (e.g., "ms" for a
+    // `Timer<Milliseconds>`), or empty if the values have no unit.
+    std::string unit;
+  };
+
+  // 'bounds' are the inclusive upper bounds of the buckets, which must
+  // be in increasing order. Values above the last bound are counted in
+  // an additional overflow bucket.
+  explicit Histogram(const std::vector<double>& _bounds)
+    : bounds(_bounds),
+      counts(new std::atomic<uint64_t>[_bounds.size() + 1]),
+      sum(0.0),
+      count(0)
+  {
+    CHECK(std::is_sorted(bounds.begin(), bounds.end()));
+
+    for (size_t i = 0; i <= bounds.size(); ++i) {
+      counts[i].store(0);
+    }
+  }
+
+  void add(double value)
+  {
+    size_t bucket =
+      std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    double current = sum.load(std::memory_order_relaxed);
+    while (!sum.compare_exchange_weak(current, current + value)) {}
+
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // NOTE: The snapshot is not atomic with respect to concurrent calls
+  // to `add`, so the counts of the buckets may briefly disagree with
+  // the total count.
+  Snapshot snapshot() const
+  {
+    Snapshot snapshot;
+    snapshot.bounds = bounds;
+
+    for (size_t i = 0; i <= bounds.size(); ++i) {
+      snapshot.counts.push_back(counts[i].load(std::memory_order_relaxed));
+    }
+
+    snapshot.sum = sum.load(std::memory_order_relaxed);
+    snapshot.count = count.load(std::memory_order_relaxed);
+
+    return snapshot;
+  }
+
+private:
+  const std::vector<double> bounds;
+  std::unique_ptr<std::atomic<uint64_t>[]> counts;
+  std::atomic<double> sum;
+  std::atomic<uint64_t> count;
+};
+
+} // namespace metrics {
+} // namespace process {
+
+#endif // __PROCESS_METRICS_HISTOGRAM_HPP__
@@ -22,6 +22,8 @@
 #include <process/statistics.hpp>
 #include <process/timeseries.hpp>
 
+#include <process/metrics/histogram.hpp>
+
 #include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/synchronized.hpp>
@@ -36,6 +38,22 @@ public:
 
   virtual Future<double> value() const = 0;
 
+  // Returns the value if it can be read right away, i.e., without
+  // computing it (possibly by dispatching to a `Process`). This lets
+  // a snapshot avoid a future for most metrics. For metrics that are
+  // computed on demand, 'staleness' bounds the age of a previously
+  // computed value that may be returned instead.
+  virtual Option<double> peek(const Option<Duration>& staleness) const
+  {
+    return None();
+  }
+
+  // Returns the distribution of the values, for metrics that track one.
+  virtual Option<Histogram::Snapshot> histogram() const
+  {
+    return None();
+  }
+
   const std::string& name() const
   {
     return data->name;
@@ -59,6 +77,13 @@ protected:
   Metric(const std::string& name, const Option<Duration>& window)
     : data(new Data(name, window)) {}
 
+  // Returns true if history is kept for this metric, in which case
+  // every new value must be passed to `push`.
+  bool tracking() const
+  {
+    return data->history.isSome();
+  }
+
   // Inserts 'value' into the history for this metric.
   void push(double value) {
     if (data->history.isSome()) {
@@ -50,12 +50,15 @@ protected:
 
 private:
   static std::string help();
+  static std::string prometheusHelp();
 
   MetricsProcess(
       const Option<Owned<RateLimiter>>& _limiter,
+      const Option<Duration>& _staleness,
       const Option<std::string>& _authenticationRealm)
     : ProcessBase("metrics"),
       limiter(_limiter),
+      staleness(_staleness),
       authenticationRealm(_authenticationRealm)
   {}
 
@@ -67,12 +70,21 @@ private:
       const http::Request& request,
       const Option<http::authentication::Principal>&);
 
+  Future<http::Response> prometheus(
+      const http::Request& request,
+      const Option<http::authentication::Principal>&);
+
+  // Returns the values of all metrics, omitting those that fail or
+  // that are not computed within 'timeout'.
+  Future<std::map<std::string, double>> evaluate(
+      const Option<Duration>& timeout);
+
   // TODO(bmahler): Make this static once we can move
   // capture with C++14.
-  Future<std::map<std::string, double>> __snapshot(
+  Future<std::map<std::string, double>> _evaluate(
       const Option<Duration>& timeout,
-      hashmap<std::string, Future<double>>&& metrics,
-      hashmap<std::string, Option<Statistics<double>>>&& statistics);
+      std::map<std::string, double>&& ready,
+      hashmap<std::string, Future<double>>&& metrics);
 
   // The Owned<Metric> is an explicit copy of the Metric passed to 'add'.
   hashmap<std::string, Owned<Metric>> metrics;
@@ -80,6 +92,10 @@ private:
   // Used to rate limit the snapshot endpoint.
   Option<Owned<RateLimiter>> limiter;
 
+  // How old a previously computed value of a pull gauge may be for it
+  // to be included in a snapshot without computing it again.
+  const Option<Duration> staleness;
+
   // The authentication realm that metrics HTTP endpoints are installed into.
   const Option<std::string> authenticationRealm;
 };
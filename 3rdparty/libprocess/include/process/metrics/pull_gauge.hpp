@@ -13,12 +13,21 @@
 #ifndef __PROCESS_METRICS_PULL_GAUGE_HPP__
 #define __PROCESS_METRICS_PULL_GAUGE_HPP__
 
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
+
+#include <process/clock.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metric.hpp>
 
+#include <stout/duration.hpp>
+#include <stout/option.hpp>
+#include <stout/synchronized.hpp>
+
 namespace process {
 namespace metrics {
 
@@ -53,19 +62,69 @@ public:
   // The user of `Gauge` must ensure that `f` is safe to execute up until
   // the removal of the `Gauge` (via `process::metrics::remove(...)`) is
   // complete.
-  PullGauge(const std::string& name, const std::function<Future<double>()>& f)
-    : Metric(name, None()), data(new Data(f)) {}
+  //
+  // 'staleness' is how old the last computed value may be for it to
+  // be reported by a snapshot in place of calling 'f' again. If None,
+  // the default of the metrics process applies (see
+  // `LIBPROCESS_METRICS_PULL_GAUGE_MAX_STALENESS`).
+  PullGauge(
+      const std::string& name,
+      const std::function<Future<double>()>& f,
+      const Option<Duration>& staleness = None())
+    : Metric(name, None()), data(new Data(f, staleness)) {}
 
   virtual ~PullGauge() {}
 
-  virtual Future<double> value() const { return data->f(); }
+  virtual Future<double> value() const
+  {
+    std::shared_ptr<Data> data = this->data;
+
+    return data->f()
+      .onReady([data](double value) {
+        Time now = Clock::now();
+
+        synchronized (data->lock) {
+          data->last = std::make_pair(value, now);
+        }
+      });
+  }
+
+  virtual Option<double> peek(const Option<Duration>& staleness) const
+  {
+    Option<Duration> bound =
+      data->staleness.isSome() ? data->staleness : staleness;
+
+    if (bound.isNone()) {
+      return None();
+    }
+
+    Option<std::pair<double, Time>> last;
+
+    synchronized (data->lock) {
+      last = data->last;
+    }
+
+    if (last.isNone() || Clock::now() - last->second > bound.get()) {
+      return None();
+    }
+
+    return last->first;
+  }
 
 private:
   struct Data
   {
-    explicit Data(const std::function<Future<double>()>& _f) : f(_f) {}
+    Data(const std::function<Future<double>()>& _f,
+         const Option<Duration>& _staleness)
+      : f(_f), staleness(_staleness) {}
 
     const std::function<Future<double>()> f;
+    const Option<Duration> staleness;
+
+    std::atomic_flag lock = ATOMIC_FLAG_INIT;
+
+    // The last computed value and when it was computed.
+    Option<std::pair<double, Time>> last;
   };
 
   std::shared_ptr<Data> data;
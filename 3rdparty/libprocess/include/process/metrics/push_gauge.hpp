@@ -58,6 +58,11 @@ public:
     return static_cast<double>(data->value.load());
   }
 
+  virtual Option<double> peek(const Option<Duration>&) const
+  {
+    return static_cast<double>(data->value.load());
+  }
+
   PushGauge& operator=(int64_t v)
   {
     data->value.store(v);
@@ -16,10 +16,12 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
 
+#include <process/metrics/histogram.hpp>
 #include <process/metrics/metric.hpp>
 
 #include <stout/duration.hpp>
@@ -33,14 +35,24 @@ namespace metrics {
 
 // A Metric that represents a timed event. It is templated on a Duration
 // subclass that specifies the unit to use for the Timer.
+//
+// Besides the last value, a Timer counts all values into a histogram
+// with fixed buckets.
 template <class T>
 class Timer : public Metric
 {
 public:
   // The Timer name will have a unit suffix added automatically.
-  Timer(const std::string& name, const Option<Duration>& window = None())
+  //
+  // 'buckets' are the upper bounds of the histogram buckets, in the
+  // unit of the Timer. By default, they range from 1 to 10000 units.
+  Timer(
+      const std::string& name,
+      const Option<Duration>& window = None(),
+      const std::vector<double>& buckets =
+        {1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000})
     : Metric(name + "_" + T::units(), window),
-      data(new Data()) {}
+      data(new Data(buckets)) {}
 
   Future<double> value() const
   {
@@ -57,6 +69,24 @@ public:
     return value;
   }
 
+  Option<double> peek(const Option<Duration>&) const
+  {
+    Option<double> value;
+
+    synchronized (data->lock) {
+      value = data->lastValue;
+    }
+
+    return value;
+  }
+
+  Option<Histogram::Snapshot> histogram() const
+  {
+    Histogram::Snapshot snapshot = data->histogram.snapshot();
+    snapshot.unit = T::units();
+    return snapshot;
+  }
+
   // Start the Timer.
   void start()
   {
@@ -82,6 +112,8 @@ public:
       value = data->lastValue.get();
     }
 
+    data->histogram.add(value);
+
     push(value);
 
     return t;
@@ -101,10 +133,11 @@ public:
 
 private:
   struct Data {
-    Data() = default;
+    explicit Data(const std::vector<double>& buckets) : histogram(buckets) {}
     std::atomic_flag lock = ATOMIC_FLAG_INIT;
     Time start;
     Option<double> lastValue;
+    Histogram histogram;
   };
 
   static void _time(Time start, Timer that)
@@ -118,6 +151,8 @@ private:
       value = that.data->lastValue.get();
     }
 
+    that.data->histogram.add(value);
+
     that.push(value);
   }
 
@@ -42,6 +42,7 @@ namespace process {
 
 // Forward declaration.
 class EventQueue;
+struct ProcessProfile;
 class Gate;
 class Logging;
 class Sequence;
@@ -215,10 +216,7 @@ protected:
    */
   void install(
       const std::string& name,
-      const MessageHandler& handler)
-  {
-    handlers.message[name] = handler;
-  }
+      const MessageHandler& handler);
 
   /**
    * @copydoc process::ProcessBase::install
@@ -244,6 +242,24 @@ protected:
     delegates[name] = pid;
   }
 
+  /**
+   * Sets the priority with which this process serves the messages
+   * with the specified name or, if the name starts with a '/', the
+   * HTTP requests for the specified endpoint (e.g., "/state").
+   *
+   * Queued events with a higher priority are served before queued
+   * events with a lower priority, while events with the same priority
+   * are served in the order in which they were enqueued. All other
+   * events have `EventPriority::NORMAL`.
+   *
+   * NOTE: Messages from the same sender are no longer guaranteed to
+   * be served in order if they have a different priority.
+   *
+   * NOTE: This must only be called while the process is running,
+   * e.g., from `initialize`.
+   */
+  void prioritize(const std::string& name, EventPriority priority);
+
   /**
    * Any function which takes a `process::http::Request` and returns a
    * `process::http::Response`.
@@ -417,6 +433,30 @@ private:
   // Flag for indicating that a terminate event has been injected.
   std::atomic<bool> termination = ATOMIC_VAR_INIT(false);
 
+  // Accounting of how this process has been scheduled onto the
+  // worker threads, exposed via the /__processes__ route. Only
+  // accessed while the process is running.
+  struct
+  {
+    // Number of times this process has been resumed.
+    uint64_t resumes = 0;
+
+    // Number of events served.
+    uint64_t events = 0;
+
+    // Number of times this process yielded to other processes because
+    // it exhausted its quantum with events still queued.
+    uint64_t preemptions = 0;
+
+    // Index of the worker thread that last ran this process, or -1 if
+    // it has not run yet (or the run queue does not track workers).
+    // Passed to the run queue when enqueueing the process so that the
+    // work stealing run queue can keep running the process on the same
+    // worker thread. Unlike the above this is also read by the threads
+    // enqueueing the process, hence atomic.
+    std::atomic<int> worker = ATOMIC_VAR_INIT(-1);
+  } scheduling;
+
   // Enqueue the specified message, request, or function call.
   void enqueue(Event* event);
 
@@ -481,6 +521,10 @@ private:
   // a pointer so we can hide the implementation of `EventQueue`.
   std::unique_ptr<EventQueue> events;
 
+  // Profile of how long events wait in the queue and take to serve,
+  // exposed via the /__processes__ route and as metrics.
+  std::unique_ptr<ProcessProfile> profile;
+
   // NOTE: this is a shared pointer to a _pointer_, hence this is not
   // responsible for the ProcessBase itself.
   std::shared_ptr<ProcessBase*> reference;
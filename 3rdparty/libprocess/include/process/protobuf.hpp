@@ -20,7 +20,9 @@
 #include <google/protobuf/repeated_field.h>
 
 #include <iterator>
+#include <memory>
 #include <set>
+#include <string>
 #include <vector>
 
 #include <process/defer.hpp>
@@ -30,6 +32,7 @@
 
 #include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/option.hpp>
 
 
 // Provides an implementation of process::post that for a protobuf.
@@ -53,6 +56,76 @@ inline void post(const process::UPID& from,
   post(from, to, message.GetTypeName(), data.data(), data.size());
 }
 
+namespace internal {
+
+// An arena that an incoming message is parsed into. If given a block
+// size, the arena starts out with a block of memory of the calling
+// thread that is reused across messages, so that parsing a message
+// which fits into the block does not allocate. Only one arena at a
+// time uses the block: a nested arena (e.g., of a handler that waited
+// for a process that got run on the same thread) uses the heap.
+class MessageArena
+{
+public:
+  explicit MessageArena(const Option<size_t>& blockSize)
+    : block(blockSize.isSome() ? Block::acquire(blockSize.get()) : nullptr),
+      arena(options(block.get())) {}
+
+  template <typename M>
+  M* create()
+  {
+    return CHECK_NOTNULL(google::protobuf::Arena::CreateMessage<M>(&arena));
+  }
+
+private:
+  struct Block
+  {
+    // Returns the block of the calling thread, grown to at least
+    // 'size' bytes, or nullptr if it is already in use.
+    static Block* acquire(size_t size)
+    {
+      static thread_local Block block;
+
+      if (block.used) {
+        return nullptr;
+      }
+
+      if (block.memory.size() < size) {
+        block.memory.resize(size);
+      }
+
+      block.used = true;
+      return &block;
+    }
+
+    std::vector<char> memory;
+    bool used = false;
+  };
+
+  struct Release
+  {
+    void operator()(Block* block) const { block->used = false; }
+  };
+
+  static google::protobuf::ArenaOptions options(Block* block)
+  {
+    google::protobuf::ArenaOptions options;
+
+    if (block != nullptr) {
+      options.initial_block = block->memory.data();
+      options.initial_block_size = block->memory.size();
+    }
+
+    return options;
+  }
+
+  // NOTE: This is declared before the arena so that the block is
+  // only released once the arena has been destroyed.
+  std::unique_ptr<Block, Release> block;
+  google::protobuf::Arena arena;
+};
+
+} // namespace internal {
 } // namespace process {
 
 
@@ -250,6 +323,21 @@ protected:
 
   using process::Process<T>::install;
 
+  // Parses the incoming messages into an arena that starts out with a
+  // block of 'blockSize' bytes which is reused across messages (one
+  // per worker thread), instead of allocating the message and all of
+  // its fields from the heap. This saves most allocations when parsing
+  // large messages with many nested or repeated fields.
+  //
+  // NOTE: This also passes messages that live on the arena to the
+  // handlers taking an rvalue (`M&&`). Moving such a message into a
+  // message that is not on the arena copies it, so processes whose
+  // handlers keep the messages they receive should not enable this.
+  void enableArenaParsing(size_t blockSize = 64 * 1024)
+  {
+    arenaBlockSize = blockSize;
+  }
+
 private:
   // Handlers that take the sender as the first argument.
   template <typename M>
@@ -259,8 +347,8 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
-    google::protobuf::Arena arena;
-    M* m = CHECK_NOTNULL(google::protobuf::Arena::CreateMessage<M>(&arena));
+    process::internal::MessageArena arena(t->arenaBlockSize);
+    M* m = arena.template create<M>();
     m->ParseFromString(data);
 
     if (m->IsInitialized()) {
@@ -278,6 +366,21 @@ private:
       const process::UPID& sender,
       const std::string& data)
   {
+    if (t->arenaBlockSize.isSome()) {
+      process::internal::MessageArena arena(t->arenaBlockSize);
+      M* m = arena.template create<M>();
+      m->ParseFromString(data);
+
+      if (m->IsInitialized()) {
+        (t->*method)(sender, std::move(*m));
+      } else {
+        LOG(WARNING) << "Initialization errors: "
+                     << m->InitializationErrorString();
+      }
+
+      return;
+    }
+
     M m;
     m.ParseFromString(data);
 
@@ -307,8 +410,8 @@ private:
       const std::string& data,
       MessageProperty<M, P>... p)
   {
-    google::protobuf::Arena arena;
-    M* m = CHECK_NOTNULL(google::protobuf::Arena::CreateMessage<M>(&arena));
+    process::internal::MessageArena arena(t->arenaBlockSize);
+    M* m = arena.template create<M>();
     m->ParseFromString(data);
 
     if (m->IsInitialized()) {
@@ -327,8 +430,8 @@ private:
       const process::UPID&,
       const std::string& data)
   {
-    google::protobuf::Arena arena;
-    M* m = CHECK_NOTNULL(google::protobuf::Arena::CreateMessage<M>(&arena));
+    process::internal::MessageArena arena(t->arenaBlockSize);
+    M* m = arena.template create<M>();
     m->ParseFromString(data);
 
     if (m->IsInitialized()) {
@@ -346,6 +449,21 @@ private:
       const process::UPID&,
       const std::string& data)
   {
+    if (t->arenaBlockSize.isSome()) {
+      process::internal::MessageArena arena(t->arenaBlockSize);
+      M* m = arena.template create<M>();
+      m->ParseFromString(data);
+
+      if (m->IsInitialized()) {
+        (t->*method)(std::move(*m));
+      } else {
+        LOG(WARNING) << "Initialization errors: "
+                     << m->InitializationErrorString();
+      }
+
+      return;
+    }
+
     M m;
     m.ParseFromString(data);
 
@@ -375,8 +493,8 @@ private:
       const std::string& data,
       MessageProperty<M, P>... p)
   {
-    google::protobuf::Arena arena;
-    M* m = CHECK_NOTNULL(google::protobuf::Arena::CreateMessage<M>(&arena));
+    process::internal::MessageArena arena(t->arenaBlockSize);
+    M* m = arena.template create<M>();
     m->ParseFromString(data);
 
     if (m->IsInitialized()) {
@@ -391,6 +509,9 @@ private:
       void(const process::UPID&, const std::string&)> handler;
   hashmap<std::string, handler> protobufHandlers;
 
+  // Size of the reused arena block, if enabled (see above).
+  Option<size_t> arenaBlockSize;
+
   // Sender of "current" message, inaccessible by subclasses.
   // This is only used for reply().
   process::UPID from;
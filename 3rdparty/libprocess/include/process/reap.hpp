@@ -19,6 +19,7 @@
 #include <process/id.hpp>
 #include <process/process.hpp>
 
+#include <stout/hashset.hpp>
 #include <stout/multihashmap.hpp>
 #include <stout/option.hpp>
 #include <stout/result.hpp>
@@ -42,12 +43,21 @@ protected:
 
   void wait();
 
+  // Starts watching for the exit of `pid` through the event loop if
+  // supported, otherwise the pid is left to be polled in `wait()`.
+  void watch(pid_t pid);
+  void _watch(pid_t pid, int_fd pidfd);
+
   void notify(pid_t pid, Result<int> status);
 
 private:
   const Duration interval();
 
   multihashmap<pid_t, Owned<Promise<Option<int>>>> promises;
+
+  // Pids that are polled in `wait()` rather than watched, which also
+  // determines the poll interval.
+  hashset<pid_t> polled;
 };
 
 
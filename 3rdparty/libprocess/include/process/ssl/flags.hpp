@@ -50,6 +50,8 @@ public:
   bool enable_tls_v1_0;
   bool enable_tls_v1_1;
   bool enable_tls_v1_2;
+  bool enable_session_resumption;
+  Option<std::string> session_ticket_key_file;
 };
 
 
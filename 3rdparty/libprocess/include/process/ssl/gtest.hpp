@@ -131,6 +131,8 @@ protected:
     os::unsetenv("LIBPROCESS_SSL_ENABLE_TLS_V1_0");
     os::unsetenv("LIBPROCESS_SSL_ENABLE_TLS_V1_1");
     os::unsetenv("LIBPROCESS_SSL_ENABLE_TLS_V1_2");
+    os::unsetenv("LIBPROCESS_SSL_ENABLE_SESSION_RESUMPTION");
+    os::unsetenv("LIBPROCESS_SSL_SESSION_TICKET_KEY_FILE");
 
     // Copy the given map into the clean slate.
     foreachpair (
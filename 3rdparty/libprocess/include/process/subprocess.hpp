@@ -357,7 +357,9 @@ using OutputFileDescriptors = Subprocess::IO::OutputFileDescriptors;
  *     subprocess or if None (the default) then the new subprocess
  *     will inherit the environment of the current process.
  * @param clone Function to be invoked in order to fork/clone the
- *     subprocess.
+ *     subprocess. If None (the default) and no hooks are given, the
+ *     subprocess is started with `posix_spawn` where possible, which
+ *     avoids copying the page tables of the current process.
  * @param parent_hooks Hooks that will be executed in the parent
  *     before the child execs.
  * @param child_hooks Hooks that will be executed in the child
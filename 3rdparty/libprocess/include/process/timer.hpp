@@ -24,6 +24,11 @@
 
 namespace process {
 
+// Forward declaration.
+namespace clock {
+class Timers;
+} // namespace clock {
+
 // Timer represents a delayed thunk, that can get created (scheduled)
 // and canceled using the Clock.
 
@@ -59,6 +64,7 @@ public:
 
 private:
   friend class Clock;
+  friend class clock::Timers;
 
   Timer(uint64_t _id,
         const Timeout& _t,
@@ -0,0 +1,59 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_TRACE_HPP__
+#define __PROCESS_TRACE_HPP__
+
+#include <stdint.h>
+
+namespace process {
+namespace trace {
+
+// Libprocess can record a span for every event (i.e., message,
+// dispatch or HTTP request) that a process serves: when the event got
+// enqueued, when it started being served and for how long. Each span
+// also refers to its parent, the span during which the event was
+// enqueued, so that a chain of dispatches can be followed across
+// processes.
+//
+// Recording is enabled by setting `LIBPROCESS_TRACE_BUFFER_SIZE` to
+// the number of spans to keep per worker thread. Older spans are
+// overwritten, which bounds the memory used. The spans are exported
+// in the Chrome trace event format via the `/__trace__` endpoint.
+
+
+// Returns the ID of the span of the event being served by the calling
+// thread, or 0 if there is none (or recording is disabled).
+uint64_t current();
+
+
+// Makes a span the parent of the events enqueued by the calling thread
+// while in scope. This is used to attribute a deferred dispatch to the
+// span that deferred it rather than to whichever span completes the
+// future that triggers the dispatch.
+class Scope
+{
+public:
+  explicit Scope(uint64_t span);
+  ~Scope();
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  const uint64_t previous;
+};
+
+} // namespace trace {
+} // namespace process {
+
+#endif // __PROCESS_TRACE_HPP__
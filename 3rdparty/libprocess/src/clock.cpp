@@ -12,6 +12,8 @@
 
 #include <glog/logging.h>
 
+#include <algorithm>
+#include <limits>
 #include <list>
 #include <map>
 #include <mutex>
@@ -25,6 +27,7 @@
 
 #include <stout/duration.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/synchronized.hpp>
 #include <stout/try.hpp>
@@ -39,10 +42,317 @@ using std::set;
 
 namespace process {
 
-// We store the timers in a map of lists indexed by the timeout of the
-// timer so that we can have two timers that have the same timeout. We
-// exploit that the map is SORTED!
-static map<Time, list<Timer>>* timers = new map<Time, list<Timer>>();
+namespace clock {
+
+// The pending timers, kept in a hierarchical timing wheel so that
+// adding and canceling a timer takes constant time no matter how many
+// timers are pending (the master and agent keep very many timers
+// around, e.g., for offer timeouts, pings and filters).
+//
+// Timeouts are bucketed into ticks of a millisecond and the wheel has
+// `LEVELS` levels of `SLOTS` slots each. A timer is stored on the
+// lowest level at which its tick agrees with all the higher digits of
+// the wheel's current tick (`cursor`). Level 0 thus holds the timers
+// of the current `SLOTS` ticks, level 1 those of the current
+// `SLOTS * SLOTS` ticks, etc., and timers further out are kept in
+// `overflow`. As the cursor advances, the slots of the higher levels
+// get cascaded down to the lower levels once their range is reached.
+class Timers
+{
+public:
+  Timers() : cursor(0), dirty(false) {}
+
+  bool empty() const
+  {
+    return locations.empty();
+  }
+
+  void add(const Timer& timer)
+  {
+    const Time time = timer.timeout().time();
+
+    list<Timer>& slot = this->slot(tick(time));
+
+    Location location;
+    location.slot = &slot;
+    location.iterator = slot.insert(slot.end(), timer);
+
+    locations[timer.id] = location;
+
+    if (!dirty && (earliest.isNone() || time < earliest.get())) {
+      earliest = time;
+    }
+  }
+
+  bool remove(const Timer& timer)
+  {
+    auto iterator = locations.find(timer.id);
+    if (iterator == locations.end()) {
+      return false;
+    }
+
+    iterator->second.slot->erase(iterator->second.iterator);
+    locations.erase(iterator);
+
+    if (earliest.isSome() && earliest.get() == timer.timeout().time()) {
+      dirty = true;
+    }
+
+    return true;
+  }
+
+  // Removes and returns all the timers that have timed out at `now`,
+  // and advances the wheel up to `now`.
+  list<Timer> expire(const Time& now)
+  {
+    list<Timer> timedout;
+
+    rebase(now);
+
+    const uint64_t target = tick(now);
+
+    // Visit the slots in order, expiring the timers of the slots on
+    // level 0 and cascading the slots of the higher levels, until the
+    // next slot starts after `now`.
+    Option<Slot> next = first();
+
+    while (next.isSome() && next->start <= target) {
+      const uint64_t previous = cursor;
+      cursor = next->start;
+
+      if (next->level == 0) {
+        list<Timer>* slot = next->slot;
+
+        for (auto iterator = slot->begin(); iterator != slot->end();) {
+          if (iterator->timeout().time() <= now) {
+            locations.erase(iterator->id);
+            timedout.splice(timedout.end(), *slot, iterator++);
+          } else {
+            ++iterator;
+          }
+        }
+
+        // The remaining timers time out later within the current
+        // tick, so there is nothing else to expire yet.
+        if (!slot->empty()) {
+          break;
+        }
+      } else {
+        cascade(previous);
+      }
+
+      next = first();
+    }
+
+    // All the remaining timers time out after `now`.
+    if (cursor < target) {
+      const uint64_t previous = cursor;
+      cursor = target;
+      cascade(previous);
+    }
+
+    if (!timedout.empty()) {
+      dirty = true;
+    }
+
+    return timedout;
+  }
+
+  // Returns the earliest timeout of the pending timers, if any.
+  Option<Time> next()
+  {
+    if (dirty) {
+      earliest = None();
+
+      Option<Slot> slot = first();
+      if (slot.isSome()) {
+        foreach (const Timer& timer, *slot->slot) {
+          if (earliest.isNone() || timer.timeout().time() < earliest.get()) {
+            earliest = timer.timeout().time();
+          }
+        }
+      }
+
+      dirty = false;
+    }
+
+    return earliest;
+  }
+
+  // Moves the wheel back to `now` if it has been advanced past it,
+  // which happens when the clock was advanced while paused and then
+  // resumed (or libprocess was reinitialized). Otherwise new timers
+  // would be put in the slot of the cursor and never expire.
+  void rebase(const Time& now)
+  {
+    const uint64_t target = tick(now);
+
+    if (target >= cursor) {
+      return;
+    }
+
+    list<Timer> timers;
+
+    for (size_t level = 0; level < LEVELS; level++) {
+      for (size_t index = 0; index < SLOTS; index++) {
+        timers.splice(timers.end(), slots[level][index]);
+      }
+    }
+
+    timers.splice(timers.end(), overflow);
+
+    cursor = target;
+
+    cascade(&timers);
+  }
+
+  void clear()
+  {
+    for (size_t level = 0; level < LEVELS; level++) {
+      for (size_t index = 0; index < SLOTS; index++) {
+        slots[level][index].clear();
+      }
+    }
+
+    overflow.clear();
+    locations.clear();
+    cursor = 0;
+    earliest = None();
+    dirty = false;
+  }
+
+private:
+  static constexpr size_t BITS = 8;
+  static constexpr size_t SLOTS = 1 << BITS;
+  static constexpr size_t LEVELS = 4;
+
+  struct Location
+  {
+    list<Timer>* slot;
+    list<Timer>::iterator iterator;
+  };
+
+  struct Slot
+  {
+    uint64_t start; // The first tick covered by the slot.
+    size_t level; // `LEVELS` for the overflow.
+    list<Timer>* slot;
+  };
+
+  static uint64_t tick(const Time& time)
+  {
+    return time.duration().ns() / Milliseconds(1).ns();
+  }
+
+  static size_t digit(uint64_t tick, size_t level)
+  {
+    return (tick >> (BITS * level)) & (SLOTS - 1);
+  }
+
+  // Returns the slot that a timer timing out at `tick` belongs in.
+  // Timers that have already timed out go into the current slot.
+  list<Timer>& slot(uint64_t tick)
+  {
+    tick = std::max(tick, cursor);
+
+    const uint64_t difference = tick ^ cursor;
+
+    size_t level = 0;
+    while (level < LEVELS && (difference >> (BITS * (level + 1))) != 0) {
+      level++;
+    }
+
+    if (level == LEVELS) {
+      return overflow;
+    }
+
+    return slots[level][digit(tick, level)];
+  }
+
+  // Returns the earliest nonempty slot. This relies on each level
+  // only holding timers that time out after those of the levels
+  // below it.
+  Option<Slot> first()
+  {
+    for (size_t level = 0; level < LEVELS; level++) {
+      const size_t shift = BITS * level;
+
+      for (size_t index = digit(cursor, level); index < SLOTS; index++) {
+        if (!slots[level][index].empty()) {
+          Slot slot;
+          slot.start = (cursor >> (shift + BITS) << (shift + BITS)) |
+                       (static_cast<uint64_t>(index) << shift);
+          slot.start = std::max(slot.start, cursor);
+          slot.level = level;
+          slot.slot = &slots[level][index];
+          return slot;
+        }
+      }
+    }
+
+    if (!overflow.empty()) {
+      Slot slot;
+      slot.start = std::numeric_limits<uint64_t>::max();
+      slot.level = LEVELS;
+      slot.slot = &overflow;
+
+      foreach (const Timer& timer, overflow) {
+        slot.start = std::min(slot.start, tick(timer.timeout().time()));
+      }
+
+      slot.start = std::max(slot.start, cursor);
+      return slot;
+    }
+
+    return None();
+  }
+
+  // Moves the timers whose range the cursor has reached since
+  // `previous` down to the lower levels.
+  void cascade(uint64_t previous)
+  {
+    if ((cursor >> (BITS * LEVELS)) != (previous >> (BITS * LEVELS))) {
+      cascade(&overflow);
+    }
+
+    for (size_t level = LEVELS - 1; level > 0; level--) {
+      cascade(&slots[level][digit(cursor, level)]);
+    }
+  }
+
+  void cascade(list<Timer>* slot)
+  {
+    list<Timer> timers;
+    timers.splice(timers.end(), *slot);
+
+    while (!timers.empty()) {
+      const Timer& timer = timers.front();
+
+      list<Timer>& slot = this->slot(tick(timer.timeout().time()));
+
+      // Splicing keeps the iterator of the timer valid.
+      locations.at(timer.id).slot = &slot;
+      slot.splice(slot.end(), timers, timers.begin());
+    }
+  }
+
+  list<Timer> slots[LEVELS][SLOTS];
+  list<Timer> overflow;
+
+  // The tick up to which the wheel has been advanced.
+  uint64_t cursor;
+
+  hashmap<uint64_t, Location> locations;
+
+  // Cached earliest timeout, recomputed by `next()` when `dirty`.
+  Option<Time> earliest;
+  bool dirty;
+};
+
+} // namespace clock {
+
+
+static clock::Timers* timers = new clock::Timers();
 static recursive_mutex* timers_mutex = new recursive_mutex();
 
 
@@ -82,13 +392,12 @@ set<Time>* ticks = new set<Time>();
 // timers are expired. Note that we don't manipulate 'timers' directly
 // so that it's clear from the callsite that the use of 'timers' is
 // within a 'synchronized' block.
-//
-// TODO(benh): Create a generic 'Timers' abstraction which hides this
-// and more away (i.e., all manipulations of 'timers' below).
-Option<Time> next(const map<Time, list<Timer>>& timers)
+Option<Time> next(Timers* timers)
 {
-  if (!timers.empty()) {
-    Time first = timers.begin()->first;
+  const Option<Time> earliest = timers->next();
+
+  if (earliest.isSome()) {
+    const Time& first = earliest.get();
 
     // If the clock is paused and no timers are expired, the
     // timers cannot fire until the clock is advanced, so we
@@ -116,7 +425,7 @@ void tick(const Time& time);
 // a 'synchronized' block.
 // TODO(bmahler): Consider taking an optional 'now' to avoid
 // excessive syscalls via Clock::now(nullptr).
-void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
+void scheduleTick(Timers* timers, set<Time>* ticks)
 {
   // Determine when the next 'tick' should fire.
   const Option<Time> next = clock::next(timers);
@@ -151,28 +460,19 @@ void tick(const Time& time)
 
     VLOG(3) << "Handling timers up to " << now;
 
-    foreachkey (const Time& timeout, *timers) {
-      if (timeout > now) {
-        break;
-      }
-
-      VLOG(3) << "Have timeout(s) at " << timeout;
+    timedout = timers->expire(now);
 
-      // Need to toggle 'settling' so that we don't prematurely say
-      // we're settled until after the timers are executed below,
-      // outside of the critical section.
-      if (clock::paused) {
-        clock::settling = true;
-      }
+    VLOG(3) << "Have " << timedout.size() << " timeout(s)";
 
-      timedout.splice(timedout.end(), (*timers)[timeout]);
+    // Need to toggle 'settling' so that we don't prematurely say
+    // we're settled until after the timers are executed below,
+    // outside of the critical section.
+    if (clock::paused && !timedout.empty()) {
+      clock::settling = true;
     }
 
-    // Now erase the range of timers that timed out.
-    timers->erase(timers->begin(), timers->upper_bound(now));
-
     // Okay, so the timeout for the next timer should not have fired.
-    CHECK(timers->empty() || (timers->begin()->first > now));
+    CHECK(timers->next().isNone() || timers->next().get() > now);
 
     // Remove this tick from the scheduled 'ticks', it may have
     // been removed already if the clock was paused / manipulated
@@ -180,7 +480,7 @@ void tick(const Time& time)
     ticks->erase(time);
 
     // Schedule another "tick" if necessary.
-    scheduleTick(*timers, ticks);
+    scheduleTick(timers, ticks);
   }
 
   (*clock::callback)(timedout);
@@ -192,8 +492,8 @@ void tick(const Time& time)
   // executing expired timers.
   synchronized (timers_mutex) {
     if (clock::paused &&
-        (timers->size() == 0 ||
-         timers->begin()->first > *clock::current)) {
+        (timers->next().isNone() ||
+         timers->next().get() > *clock::current)) {
       VLOG(3) << "Clock has settled";
       clock::settling = false;
     }
@@ -220,8 +520,8 @@ void Clock::finalize()
 
     // This, along with the `timers_mutex`, is all that is required to clean
     // up any pending timers.  Timers are triggered via "ticks".  However,
-    // we do not need to clear `ticks` because a "tick" with an empty `timers`
-    // map will effectively be a no-op.
+    // we do not need to clear `ticks` because a "tick" with no pending
+    // `timers` will effectively be a no-op.
     timers->clear();
   }
 }
@@ -281,17 +581,13 @@ Timer Clock::timer(
 
   // Add the timer.
   synchronized (timers_mutex) {
-    if (timers->size() == 0 ||
-        timer.timeout().time() < timers->begin()->first) {
-      // Need to interrupt the loop to update/set timer repeat.
-      (*timers)[timer.timeout().time()].push_back(timer);
+    const Option<Time> next = timers->next();
 
-      // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
-    } else {
-      // Timer repeat is adequate, just add the timeout.
-      CHECK(timers->size() >= 1);
-      (*timers)[timer.timeout().time()].push_back(timer);
+    timers->add(timer);
+
+    if (next.isNone() || timer.timeout().time() < next.get()) {
+      // Need to interrupt the loop to update/set timer repeat.
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 
@@ -301,22 +597,12 @@ Timer Clock::timer(
 
 bool Clock::cancel(const Timer& timer)
 {
-  bool canceled = false;
   synchronized (timers_mutex) {
-    // Check if the timeout is still pending, and if so, erase it. In
-    // addition, erase an empty list if we just removed the last
-    // timeout.
-    Time time = timer.timeout().time();
-    if (timers->count(time) > 0) {
-      canceled = true;
-      (*timers)[time].remove(timer);
-      if ((*timers)[time].empty()) {
-        timers->erase(time);
-      }
-    }
+    // Erase the timer if it is still pending.
+    return timers->remove(timer);
   }
 
-  return canceled;
+  UNREACHABLE();
 }
 
 
@@ -364,8 +650,10 @@ void Clock::resume()
       clock::settling = false;
       clock::currents->clear();
 
+      timers->rebase(Clock::now(nullptr));
+
       // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 }
@@ -383,7 +671,7 @@ void Clock::advance(const Duration& duration)
       // Schedule another "tick" if necessary. Only "ticks" that
       // fire immediately will be scheduled here, since the clock
       // is paused.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 }
@@ -420,7 +708,7 @@ void Clock::update(const Time& time)
         // Schedule another "tick" if necessary. Only "ticks" that
         // fire immediately will be scheduled here, since the clock
         // is paused.
-        clock::scheduleTick(*timers, clock::ticks);
+        clock::scheduleTick(timers, clock::ticks);
       }
     }
   }
@@ -460,8 +748,8 @@ bool Clock::settled()
     if (clock::settling) {
       VLOG(3) << "Clock still not settled";
       return false;
-    } else if (timers->size() == 0 ||
-               timers->begin()->first > *clock::current) {
+    } else if (timers->next().isNone() ||
+               timers->next().get() > *clock::current) {
       VLOG(3) << "Clock is settled";
       return true;
     }
@@ -19,20 +19,26 @@
 #include <http_parser.h>
 #undef flags
 
+#include <string.h>
+
 #include <glog/logging.h>
 
+#include <algorithm>
 #include <deque>
 #include <limits>
 #include <string>
 #include <vector>
 
 #include <process/http.hpp>
+#include <process/message.hpp>
 
 #include <stout/foreach.hpp>
 #include <stout/gzip.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
 
+#include "encoder.hpp"
+
 
 #if !(HTTP_PARSER_VERSION_MAJOR >= 2)
 #error HTTP Parser version >= 2 required.
@@ -1105,6 +1111,141 @@ private:
   std::deque<http::Request*> requests;
 };
 
+
+// The largest frame that `FrameDecoder` accepts by default. A peer
+// could otherwise make the decoder buffer up to 4GB for a single frame
+// by sending a bogus length.
+const size_t MAXIMUM_FRAME_LENGTH = 256 * 1024 * 1024;
+
+
+// Decodes messages sent using the binary framing, see `FrameEncoder`.
+// The data is expected to start with the `FRAMING_PREFACE`. Note that
+// the returned messages only carry the id of the receiver, the caller
+// is responsible for filling in the address. A frame longer than
+// `maximum` fails the decoder.
+class FrameDecoder
+{
+public:
+  explicit FrameDecoder(size_t _maximum = MAXIMUM_FRAME_LENGTH)
+    : maximum(_maximum), failure(false), prefaced(false) {}
+
+  std::deque<Message> decode(const char* data, size_t length)
+  {
+    std::deque<Message> result;
+
+    if (failure) {
+      return result;
+    }
+
+    // Only buffer the data when a previous call left a partial frame
+    // behind, otherwise decode straight out of the caller's data.
+    if (!buffer.empty()) {
+      buffer.append(data, length);
+      data = buffer.data();
+      length = buffer.size();
+    }
+
+    size_t index = 0;
+
+    if (!prefaced) {
+      const size_t size = std::min(length, FRAMING_PREFACE_LENGTH);
+      if (memcmp(data, FRAMING_PREFACE, size) != 0) {
+        failure = true;
+        return result;
+      }
+
+      if (size == FRAMING_PREFACE_LENGTH) {
+        prefaced = true;
+        index = size;
+      }
+    }
+
+    while (prefaced && length - index >= sizeof(uint32_t)) {
+      const size_t frame = get(data + index);
+
+      if (frame > maximum) {
+        failure = true;
+        break;
+      }
+
+      if (length - index - sizeof(uint32_t) < frame) {
+        break; // Wait for the rest of the frame.
+      }
+
+      Option<Message> message =
+        parse(data + index + sizeof(uint32_t), frame);
+
+      if (message.isNone()) {
+        failure = true;
+        break;
+      }
+
+      result.push_back(std::move(message.get()));
+      index += sizeof(uint32_t) + frame;
+    }
+
+    // Hold on to any partial frame until more data arrives.
+    if (data == buffer.data()) {
+      buffer.erase(0, index);
+    } else {
+      buffer.assign(data + index, length - index);
+    }
+
+    return result;
+  }
+
+  bool failed() const
+  {
+    return failure;
+  }
+
+private:
+  static size_t get(const char* data)
+  {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+
+    return (static_cast<size_t>(bytes[0]) << 24) |
+           (static_cast<size_t>(bytes[1]) << 16) |
+           (static_cast<size_t>(bytes[2]) << 8) |
+           static_cast<size_t>(bytes[3]);
+  }
+
+  static Option<Message> parse(const char* data, size_t length)
+  {
+    std::string fields[3];
+
+    size_t index = 0;
+    for (size_t i = 0; i < 3; i++) {
+      if (length - index < sizeof(uint32_t)) {
+        return None();
+      }
+
+      const size_t size = get(data + index);
+      index += sizeof(uint32_t);
+
+      if (length - index < size) {
+        return None();
+      }
+
+      fields[i].assign(data + index, size);
+      index += size;
+    }
+
+    Message message;
+    message.name = std::move(fields[0]);
+    message.from = UPID(fields[1]);
+    message.to.id = std::move(fields[2]);
+    message.body.assign(data + index, length - index);
+
+    return std::move(message);
+  }
+
+  const size_t maximum;
+  bool failure;
+  bool prefaced;
+  std::string buffer;
+};
+
 }  // namespace process {
 
 #endif // __DECODER_HPP__
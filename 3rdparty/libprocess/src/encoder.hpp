@@ -14,11 +14,17 @@
 #define __ENCODER_HPP__
 
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 
 #include <limits>
 #include <map>
+#include <queue>
 #include <sstream>
+#include <string>
+#include <utility>
+
+#include <glog/logging.h>
 
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -28,12 +34,53 @@
 #include <stout/hashmap.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
+#include <stout/stringify.hpp>
 
 
 namespace process {
 
 const uint32_t GZIP_MINIMUM_BODY_LENGTH = 1024;
 
+// Bodies at least this large are gzipped in chunks of
+// `GZIP_STREAMING_CHUNK_LENGTH` bytes and streamed to the client using
+// chunked transfer encoding, rather than compressed all at once.
+const size_t GZIP_STREAMING_MINIMUM_BODY_LENGTH = 4 * 1024 * 1024;
+const size_t GZIP_STREAMING_CHUNK_LENGTH = 1024 * 1024;
+
+
+// Returns the zlib compression level used to gzip response bodies. It
+// can be set through LIBPROCESS_HTTP_COMPRESSION_LEVEL, e.g., to use
+// a faster level for large responses at the cost of their size.
+inline int GZIP_COMPRESSION_LEVEL()
+{
+  static const int level = []() {
+    Option<std::string> value = os::getenv("LIBPROCESS_HTTP_COMPRESSION_LEVEL");
+
+    if (value.isSome()) {
+      Try<int> level = numify<int>(value.get());
+
+      if (level.isSome() &&
+          (level.get() == Z_DEFAULT_COMPRESSION ||
+           (level.get() >= Z_NO_COMPRESSION &&
+            level.get() <= Z_BEST_COMPRESSION))) {
+        return level.get();
+      }
+
+      LOG(WARNING) << "Ignoring invalid value '" << value.get() << "' for "
+                   << "LIBPROCESS_HTTP_COMPRESSION_LEVEL, expected an "
+                   << "integer within [-1, 9]";
+    }
+
+    return Z_DEFAULT_COMPRESSION;
+  }();
+
+  return level;
+}
+
+// Maximum number of bytes of queued data that get coalesced into a
+// single encoder (and thus a single send) for a socket.
+const size_t MAXIMUM_COALESCED_LENGTH = 64 * 1024;
+
 // Forward declarations.
 class Encoder;
 
@@ -65,6 +112,9 @@ public:
   DataEncoder(const std::string& _data)
     : data(_data), index(0) {}
 
+  DataEncoder(std::string&& _data)
+    : data(std::move(_data)), index(0) {}
+
   virtual ~DataEncoder() {}
 
   virtual Kind kind() const
@@ -92,8 +142,15 @@ public:
     return data.size() - index;
   }
 
+  // Appends the remaining data of `that` encoder so that the data of
+  // both encoders can be sent at once.
+  void append(const DataEncoder& that)
+  {
+    data.append(that.data, that.index, std::string::npos);
+  }
+
 private:
-  const std::string data;
+  std::string data;
   size_t index;
 };
 
@@ -101,41 +158,134 @@ private:
 class MessageEncoder : public DataEncoder
 {
 public:
-  MessageEncoder(const Message& message)
-    : DataEncoder(encode(message)) {}
+  MessageEncoder(const Message& message, bool framing = false)
+    : DataEncoder(encode(message, framing)) {}
 
-  static std::string encode(const Message& message)
+  // If `framing` is set the message advertises that the sender also
+  // accepts messages using the binary framing (see `FrameEncoder`).
+  static std::string encode(const Message& message, bool framing = false)
   {
-    std::ostringstream out;
-
-    out << "POST ";
+    const std::string& to = message.to.id;
+    const std::string from = stringify(message.from);
+
+    // Encode the message directly into a string that is large enough
+    // for the headers and the body so that the body only gets copied
+    // once (rather than into a stream and then out of it again).
+    std::string out;
+    out.reserve(
+        to.size() +
+        message.name.size() +
+        2 * from.size() +
+        message.body.size() +
+        256);
+
+    out += "POST ";
     // Nothing keeps the 'id' component of a PID from being an empty
     // string which would create a malformed path that has two
     // '//' unless we check for it explicitly.
     // TODO(benh): Make the 'id' part of a PID optional so when it's
     // missing it's clear that we're simply addressing an ip:port.
-    if (message.to.id != "") {
-      out << "/" << message.to.id;
+    if (!to.empty()) {
+      out += "/";
+      out += to;
     }
 
-    out << "/" << message.name << " HTTP/1.1\r\n"
-        << "User-Agent: libprocess/" << message.from << "\r\n"
-        << "Libprocess-From: " << message.from << "\r\n"
-        << "Connection: Keep-Alive\r\n"
-        << "Host: \r\n";
+    out += "/";
+    out += message.name;
+    out += " HTTP/1.1\r\n"
+           "User-Agent: libprocess/";
+    out += from;
+    out += "\r\n"
+           "Libprocess-From: ";
+    out += from;
+    out += "\r\n"
+           "Connection: Keep-Alive\r\n"
+           "Host: \r\n";
+
+    if (framing) {
+      out += "Libprocess-Framing: 1\r\n";
+    }
 
     if (message.body.size() > 0) {
-      out << "Transfer-Encoding: chunked\r\n\r\n"
-          << std::hex << message.body.size() << "\r\n";
-      out.write(message.body.data(), message.body.size());
-      out << "\r\n"
-          << "0\r\n"
-          << "\r\n";
+      char size[2 * sizeof(size_t) + 1];
+      snprintf(size, sizeof(size), "%zx", message.body.size());
+
+      out += "Transfer-Encoding: chunked\r\n\r\n";
+      out += size;
+      out += "\r\n";
+      out += message.body;
+      out += "\r\n"
+             "0\r\n"
+             "\r\n";
     } else {
-      out << "\r\n";
+      out += "\r\n";
     }
 
-    return out.str();
+    return out;
+  }
+};
+
+
+// Sent once at the start of a connection that carries framed messages.
+// The leading NUL byte can never start an HTTP request which lets the
+// receiver tell framed connections apart from HTTP ones.
+constexpr char FRAMING_PREFACE[] = "\0LIBPROCESS/1\n";
+constexpr size_t FRAMING_PREFACE_LENGTH = sizeof(FRAMING_PREFACE) - 1;
+
+
+// Encodes a message using the binary framing that libprocess instances
+// use between each other when they both support it, which is much
+// cheaper to produce and to parse than an HTTP request. A frame is the
+// length of everything that follows it, then the name, the sender and
+// the id of the receiver each prefixed by their own length, and then
+// the body. All lengths are 32 bit unsigned integers in network byte
+// order.
+class FrameEncoder : public DataEncoder
+{
+public:
+  FrameEncoder(const Message& message)
+    : DataEncoder(encode(message)) {}
+
+  static std::string encode(const Message& message)
+  {
+    const std::string& to = message.to.id;
+    const std::string from = stringify(message.from);
+
+    const size_t length =
+      3 * sizeof(uint32_t) +
+      message.name.size() +
+      from.size() +
+      to.size() +
+      message.body.size();
+
+    CHECK_LE(length, std::numeric_limits<uint32_t>::max());
+
+    std::string out;
+    out.reserve(sizeof(uint32_t) + length);
+
+    put(&out, length);
+    put(&out, message.name.size());
+    out += message.name;
+    put(&out, from.size());
+    out += from;
+    put(&out, to.size());
+    out += to;
+    out += message.body;
+
+    return out;
+  }
+
+private:
+  static void put(std::string* out, size_t value)
+  {
+    const char bytes[] = {
+      static_cast<char>(value >> 24),
+      static_cast<char>(value >> 16),
+      static_cast<char>(value >> 8),
+      static_cast<char>(value)
+    };
+
+    out->append(bytes, sizeof(bytes));
   }
 };
 
@@ -178,20 +328,25 @@ public:
 
     headers["Date"] = date;
 
-    // Should we compress this response?
-    std::string body = response.body;
+    // Should we compress this response? Note that we only copy the
+    // body if we do compress it.
+    const std::string* body = &response.body;
+    std::string compressed_;
 
     if (response.type == http::Response::BODY &&
         response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
         !headers.contains("Content-Encoding") &&
         request.acceptsEncoding("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
+      Try<std::string> compressed =
+        gzip::compress(response.body, GZIP_COMPRESSION_LEVEL());
+
       if (compressed.isError()) {
         LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
       } else {
-        body = std::move(compressed.get());
+        compressed_ = std::move(compressed.get());
+        body = &compressed_;
 
-        headers["Content-Length"] = stringify(body.length());
+        headers["Content-Length"] = stringify(body->length());
         headers["Content-Encoding"] = "gzip";
       }
     }
@@ -207,7 +362,7 @@ public:
       out << "Content-Length: 0\r\n";
     } else if (response.type == http::Response::BODY &&
                !headers.contains("Content-Length")) {
-      out << "Content-Length: " << body.size() << "\r\n";
+      out << "Content-Length: " << body->size() << "\r\n";
     }
 
     // Use a CRLF to mark end of headers.
@@ -218,10 +373,10 @@ public:
       // If the Content-Length header was supplied, only write as much data
       // as the length specifies.
       Result<uint32_t> length = numify<uint32_t>(headers.get("Content-Length"));
-      if (length.isSome() && length.get() <= body.length()) {
-        out.write(body.data(), length.get());
+      if (length.isSome() && length.get() <= body->length()) {
+        out.write(body->data(), length.get());
       } else {
-        out.write(body.data(), body.size());
+        out.write(body->data(), body->size());
       }
     }
 
@@ -280,6 +435,38 @@ private:
   off_t index;
 };
 
+
+// Pops the next encoder to send off `encoders`. The data of any
+// subsequently queued data encoders is coalesced into it (up to
+// `MAXIMUM_COALESCED_LENGTH` bytes) so that a burst of messages to the
+// same peer gets written with a single send rather than one send per
+// message. Data is never coalesced across a file encoder, so the
+// order in which the data gets sent is kept.
+inline Encoder* coalesce(std::queue<Encoder*>* encoders)
+{
+  CHECK(!encoders->empty());
+
+  Encoder* encoder = encoders->front();
+  encoders->pop();
+
+  if (encoder->kind() == Encoder::DATA) {
+    DataEncoder* data = static_cast<DataEncoder*>(encoder);
+
+    while (!encoders->empty() &&
+           encoders->front()->kind() == Encoder::DATA &&
+           data->remaining() + encoders->front()->remaining() <=
+             MAXIMUM_COALESCED_LENGTH) {
+      Encoder* next = encoders->front();
+      encoders->pop();
+
+      data->append(*static_cast<DataEncoder*>(next));
+      delete next;
+    }
+  }
+
+  return encoder;
+}
+
 }  // namespace process {
 
 #endif // __ENCODER_HPP__
@@ -13,6 +13,8 @@
 #ifndef __EVENT_LOOP_HPP__
 #define __EVENT_LOOP_HPP__
 
+#include <stddef.h> // For size_t.
+
 #include <stout/duration.hpp>
 #include <stout/lambda.hpp>
 
@@ -24,10 +26,17 @@ namespace process {
 class EventLoop
 {
 public:
-  // Initializes the event loop.
-  static void initialize();
+  // Initializes the specified number of event loops. Each event loop
+  // must be run on its own thread, see `run`. File descriptors are
+  // pinned to one of the event loops so that all of the I/O for a
+  // socket is handled by a single thread. Timers and other work that
+  // is not associated with a file descriptor use the first event loop.
+  static void initialize(size_t count);
+
+  // Returns the number of event loops.
+  static size_t count();
 
-  // Invoke the specified function in the event loop after the
+  // Invoke the specified function in the first event loop after the
   // specified duration.
   // TODO(bmahler): Update this to use rvalue references.
   static void delay(
@@ -37,10 +46,12 @@ public:
   // Returns the current time w.r.t. the event loop.
   static double time();
 
-  // Runs the event loop.
-  static void run();
+  // Runs the specified event loop (in the range [0, count)). This
+  // blocks until the event loop is stopped.
+  static void run(size_t index);
 
-  // Asynchronously tells the event loop to stop and then returns.
+  // Asynchronously tells all of the event loops to stop and then
+  // returns.
   static void stop();
 };
 
@@ -13,7 +13,10 @@
 #ifndef __PROCESS_EVENT_QUEUE_HPP__
 #define __PROCESS_EVENT_QUEUE_HPP__
 
+#include <algorithm>
+#include <array>
 #include <deque>
+#include <iterator>
 #include <mutex>
 #include <string>
 
@@ -21,10 +24,15 @@
 #include <concurrentqueue.h>
 #endif // LOCK_FREE_EVENT_QUEUE
 
+#include <glog/logging.h>
+
 #include <process/event.hpp>
 #include <process/http.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
+#include <stout/option.hpp>
 #include <stout/stringify.hpp>
 #include <stout/synchronized.hpp>
 
@@ -86,19 +94,133 @@ public:
   class Consumer
   {
   public:
-    Event* dequeue() { return queue->dequeue(); }
-    bool empty() { return queue->empty(); }
-    void decomission() { queue->decomission(); }
+    Event* dequeue()
+    {
+      if (priorities.empty()) {
+        return queue->dequeue();
+      }
+
+      // Move all the enqueued events into their lanes so that we
+      // always serve the event with the highest priority first.
+      while (!queue->empty()) {
+        Event* event = queue->dequeue();
+        lanes[static_cast<size_t>(priority(*event))].push_back(event);
+      }
+
+      Event* event = nullptr;
+
+      foreach (std::deque<Event*>& lane, lanes) {
+        if (!lane.empty()) {
+          event = lane.front();
+          lane.pop_front();
+          break;
+        }
+      }
+
+      // Semantics are the consumer _must_ call `empty()` before
+      // calling `dequeue()` which means an event must be present.
+      return CHECK_NOTNULL(event);
+    }
+
+    bool empty()
+    {
+      foreach (const std::deque<Event*>& lane, lanes) {
+        if (!lane.empty()) {
+          return false;
+        }
+      }
+
+      return queue->empty();
+    }
+
+    void decomission()
+    {
+      queue->decomission();
+
+      foreach (std::deque<Event*>& lane, lanes) {
+        foreach (Event* event, lane) {
+          delete event;
+        }
+        lane.clear();
+      }
+    }
+
     template <typename T>
-    size_t count() { return queue->count<T>(); }
-    operator JSON::Array() { return queue->operator JSON::Array(); }
+    size_t count()
+    {
+      size_t count = queue->count<T>();
+
+      foreach (const std::deque<Event*>& lane, lanes) {
+        count += std::count_if(
+            lane.begin(),
+            lane.end(),
+            [](const Event* event) {
+              return event->is<T>();
+            });
+      }
+
+      return count;
+    }
+
+    operator JSON::Array()
+    {
+      JSON::Array array;
+
+      foreach (const std::deque<Event*>& lane, lanes) {
+        foreach (const Event* event, lane) {
+          array.values.push_back(JSON::Object(*event));
+        }
+      }
+
+      JSON::Array queued = queue->operator JSON::Array();
+      array.values.insert(
+          array.values.end(),
+          std::make_move_iterator(queued.values.begin()),
+          std::make_move_iterator(queued.values.end()));
+
+      return array;
+    }
+
+    void prioritize(const std::string& name, EventPriority priority)
+    {
+      priorities[name] = priority;
+    }
 
   private:
     friend class EventQueue;
 
     Consumer(EventQueue* queue) : queue(queue) {}
 
+    // Returns the priority of the event, see `ProcessBase::prioritize`.
+    EventPriority priority(const Event& event)
+    {
+      Option<EventPriority> priority = None();
+
+      if (event.is<MessageEvent>()) {
+        priority = priorities.get(event.as<MessageEvent>().message.name);
+      } else if (event.is<HttpEvent>()) {
+        // Strip the process ID from the path, e.g., "/master/state"
+        // becomes "/state".
+        const std::string& path = event.as<HttpEvent>().request->url.path;
+        size_t index = path.find('/', 1);
+        if (index != std::string::npos) {
+          priority = priorities.get(path.substr(index));
+        }
+      }
+
+      return priority.getOrElse(EventPriority::NORMAL);
+    }
+
     EventQueue* queue;
+
+    // The priorities of messages and HTTP endpoints set by the
+    // process. Once any priority is set, events get moved out of the
+    // queue into a lane per priority on `dequeue()`, from where they
+    // get served in priority order.
+    //
+    // NOTE: These are only ever accessed by the single consumer.
+    hashmap<std::string, EventPriority> priorities;
+    std::array<std::deque<Event*>, 3> lanes;
   } consumer;
 
 private:
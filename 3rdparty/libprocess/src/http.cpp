@@ -22,6 +22,7 @@
 #include <cstring>
 #include <deque>
 #include <iomanip>
+#include <list>
 #include <ostream>
 #include <map>
 #include <memory>
@@ -32,8 +33,10 @@
 #include <vector>
 
 #include <process/after.hpp>
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
@@ -61,6 +64,7 @@
 
 #include "decoder.hpp"
 #include "encoder.hpp"
+#include "http_connection_pool.hpp"
 
 using std::deque;
 using std::istringstream;
@@ -2290,14 +2294,230 @@ Request createRequest(
 }
 
 
+namespace internal {
+
+PID<ConnectionPoolProcess> pool;
+
+
+ConnectionPoolProcess::ConnectionPoolProcess()
+  : ProcessBase(ID::generate("__http_connection_pool__")) {}
+
+
+void ConnectionPoolProcess::set(const ConnectionPoolLimits& _limits)
+{
+  limits = _limits;
+}
+
+
+Future<Response> ConnectionPoolProcess::send(const Request& request)
+{
+  if (request.url.ip.isNone() && request.url.domain.isNone()) {
+    return Failure("Expected URL.ip or URL.domain to be set");
+  }
+
+  const string key = destination(request.url);
+
+  // Prefer an idle connection, otherwise remember the least
+  // loaded one in case we cannot open another connection.
+  Option<Pooled*> selected;
+  if (connections.contains(key)) {
+    foreach (Pooled& pooled, connections.at(key)) {
+      if (selected.isNone() ||
+          pooled.inflight < selected.get()->inflight) {
+        selected = &pooled;
+      }
+    }
+  }
+
+  if (selected.isSome() && selected.get()->inflight == 0) {
+    return _send(key, selected.get(), request);
+  }
+
+  size_t opened = connections.contains(key) ? connections.at(key).size() : 0;
+  size_t opening = connecting.contains(key) ? connecting.at(key) : 0;
+
+  if (selected.isNone() || opened + opening < limits.maxConnections) {
+    connecting[key] = opening + 1;
+
+    return http::connect(request.url)
+      .recover(defer(self(), [=](const Future<Connection>& connection) {
+        connected(key);
+        return connection;
+      }))
+      .then(defer(self(), [=](const Connection& connection) {
+        connected(key);
+        return _send(key, add(key, connection), request);
+      }));
+  }
+
+  // All connections are busy and we are at the limit, so
+  // pipeline the request onto the least loaded connection.
+  return _send(key, selected.get(), request);
+}
+
+
+void ConnectionPoolProcess::initialize()
+{
+  evict();
+}
+
+
+ConnectionPoolProcess::Pooled::Pooled(const Connection& _connection)
+  : connection(_connection), inflight(0), idle(Clock::now()) {}
+
+
+string ConnectionPoolProcess::destination(const URL& url)
+{
+  return url.scheme.getOrElse("http") + "://" +
+         (url.ip.isSome() ? stringify(url.ip.get()) : url.domain.get()) +
+         ":" + (url.port.isSome() ? stringify(url.port.get()) : "");
+}
+
+
+void ConnectionPoolProcess::connected(const string& key)
+{
+  CHECK(connecting.contains(key));
+
+  if (--connecting.at(key) == 0) {
+    connecting.erase(key);
+  }
+}
+
+
+ConnectionPoolProcess::Pooled* ConnectionPoolProcess::add(
+    const string& key,
+    const Connection& connection)
+{
+  connections[key].push_back(Pooled(connection));
+
+  // The connection may also be closed by the server, in which
+  // case we stop handing it out.
+  Connection connection_ = connection;
+  connection_.disconnected()
+    .onAny(defer(self(), &Self::remove, key, connection));
+
+  return &connections.at(key).back();
+}
+
+
+void ConnectionPoolProcess::remove(
+    const string& key,
+    const Connection& connection)
+{
+  if (!connections.contains(key)) {
+    return;
+  }
+
+  connections.at(key).remove_if([&](const Pooled& pooled) {
+    return pooled.connection == connection;
+  });
+
+  if (connections.at(key).empty()) {
+    connections.erase(key);
+  }
+}
+
+
+Future<Response> ConnectionPoolProcess::_send(
+    const string& key,
+    Pooled* pooled,
+    const Request& request)
+{
+  pooled->inflight++;
+
+  Connection connection = pooled->connection;
+
+  return connection.send(request)
+    .onAny(defer(self(), &Self::completed, key, connection, lambda::_1));
+}
+
+
+void ConnectionPoolProcess::completed(
+    const string& key,
+    const Connection& connection,
+    const Future<Response>& response)
+{
+  if (!connections.contains(key)) {
+    return;
+  }
+
+  foreach (Pooled& pooled, connections.at(key)) {
+    if (pooled.connection == connection) {
+      CHECK(pooled.inflight > 0);
+
+      if (--pooled.inflight == 0) {
+        pooled.idle = Clock::now();
+      }
+      break;
+    }
+  }
+
+  // A connection that failed or that the server is about to
+  // close must not be handed out again.
+  if (!response.isReady() ||
+      (response->headers.contains("Connection") &&
+       response->headers.at("Connection") == "close")) {
+    remove(key, connection);
+  }
+}
+
+
+void ConnectionPoolProcess::evict()
+{
+  const Time now = Clock::now();
+
+  foreachvalue (list<Pooled>& pooled, connections) {
+    size_t kept = 0;
+
+    foreach (Pooled& p, pooled) {
+      if (p.inflight > 0) {
+        kept++;
+      } else if (now - p.idle >= limits.idleTimeout ||
+                 kept >= limits.maxConnections) {
+        // Removal happens once the disconnection completes.
+        p.connection.disconnect();
+      } else {
+        kept++;
+      }
+    }
+  }
+
+  delay(limits.idleTimeout, self(), &Self::evict);
+}
+
+} // namespace internal {
+
+
+void setConnectionPoolLimits(const ConnectionPoolLimits& limits)
+{
+  // The connection pool is instantiated in `process::initialize`.
+  process::initialize();
+
+  dispatch(internal::pool, &internal::ConnectionPoolProcess::set, limits);
+}
+
+
 Future<Response> request(const Request& request, bool streamedResponse)
 {
-  // We rely on the connection closing after the response.
-  CHECK(!request.keepAlive);
+  if (request.keepAlive && !streamedResponse) {
+    // The connection pool is instantiated in `process::initialize`.
+    process::initialize();
+
+    return dispatch(
+        internal::pool,
+        &internal::ConnectionPoolProcess::send,
+        request);
+  }
+
+  // Streamed responses hold the connection until the caller is
+  // done reading the body, so they always use a connection of
+  // their own which is closed after the response.
+  Request _request = request;
+  _request.keepAlive = false;
 
-  return http::connect(request.url)
+  return http::connect(_request.url)
     .then([=](Connection connection) {
-      Future<Response> response = connection.send(request, streamedResponse);
+      Future<Response> response = connection.send(_request, streamedResponse);
 
       // This is a non Keep-Alive request which means the connection
       // will be closed when the response is received. Since the
@@ -0,0 +1,98 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_HTTP_CONNECTION_POOL_HPP__
+#define __PROCESS_HTTP_CONNECTION_POOL_HPP__
+
+#include <list>
+#include <string>
+
+#include <process/future.hpp>
+#include <process/http.hpp>
+#include <process/pid.hpp>
+#include <process/process.hpp>
+#include <process/time.hpp>
+
+#include <stout/hashmap.hpp>
+
+namespace process {
+namespace http {
+namespace internal {
+
+// Keeps persistent connections open per destination so that
+// keep-alive requests sent through `http::request` can reuse them
+// rather than paying for a new connection (and TLS handshake) on
+// every request.
+class ConnectionPoolProcess : public Process<ConnectionPoolProcess>
+{
+public:
+  ConnectionPoolProcess();
+
+  void set(const ConnectionPoolLimits& _limits);
+
+  Future<Response> send(const Request& request);
+
+protected:
+  virtual void initialize();
+
+private:
+  struct Pooled
+  {
+    explicit Pooled(const Connection& _connection);
+
+    Connection connection;
+
+    // Number of requests sent but not yet responded to.
+    size_t inflight;
+
+    // When the last outstanding response completed.
+    Time idle;
+  };
+
+  static std::string destination(const URL& url);
+
+  void connected(const std::string& key);
+
+  Pooled* add(const std::string& key, const Connection& connection);
+
+  void remove(const std::string& key, const Connection& connection);
+
+  Future<Response> _send(
+      const std::string& key,
+      Pooled* pooled,
+      const Request& request);
+
+  void completed(
+      const std::string& key,
+      const Connection& connection,
+      const Future<Response>& response);
+
+  void evict();
+
+  ConnectionPoolLimits limits;
+
+  hashmap<std::string, std::list<Pooled>> connections;
+
+  // Number of connections being established per destination.
+  hashmap<std::string, size_t> connecting;
+};
+
+
+// Global connection pool, spawned in `process::initialize` and
+// terminated with all other processes in `process::finalize`.
+extern PID<ConnectionPoolProcess> pool;
+
+} // namespace internal {
+} // namespace http {
+} // namespace process {
+
+#endif // __PROCESS_HTTP_CONNECTION_POOL_HPP__
@@ -10,8 +10,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <algorithm>
+#include <string>
+
 #include <process/id.hpp>
 #include <process/defer.hpp>
+#include <process/dispatch.hpp>
 
 #include "encoder.hpp"
 #include "http_proxy.hpp"
@@ -230,6 +234,38 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
     reader.read()
       .onAny(defer(self(), &Self::stream, request_, lambda::_1));
 
+    return false; // Streaming, don't process next response (yet)!
+  } else if (response.type == Response::BODY &&
+             response.body.length() >= GZIP_STREAMING_MINIMUM_BODY_LENGTH &&
+             !response.headers.contains("Content-Encoding") &&
+             !response.headers.contains("Content-Length") &&
+             request.acceptsEncoding("gzip")) {
+    // Gzipping a large body all at once would tie up this thread for
+    // a long time and hold on to both the body and the compressed body
+    // until it is sent. Instead we stream the body, compressing it one
+    // chunk at a time and yielding in between the chunks.
+    Owned<string> body(new string(std::move(response.body)));
+    response.body.clear();
+
+    // Only the headers are sent up front.
+    response.type = Response::PIPE;
+    response.headers["Content-Encoding"] = "gzip";
+    response.headers["Transfer-Encoding"] = "chunked";
+
+    VLOG(3) << "Starting \"chunked\" gzip streaming";
+
+    socket_manager->send(
+        new HttpResponseEncoder(response, request),
+        true,
+        socket);
+
+    compress(
+        Owned<Request>(new Request(request)),
+        Owned<gzip::Compressor>(
+            new gzip::Compressor(GZIP_COMPRESSION_LEVEL())),
+        body,
+        0);
+
     return false; // Streaming, don't process next response (yet)!
   } else {
     socket_manager->send(response, request, socket);
@@ -291,4 +327,73 @@ void HttpProxy::stream(
   }
 }
 
+
+void HttpProxy::compress(
+    const Owned<Request>& request,
+    const Owned<gzip::Compressor>& compressor,
+    const Owned<string>& body,
+    size_t offset)
+{
+  const size_t length =
+    std::min(GZIP_STREAMING_CHUNK_LENGTH, body->size() - offset);
+
+  Try<string> compressed =
+    compressor->compress(body->data() + offset, length);
+
+  offset += length;
+
+  const bool finished = offset == body->size();
+
+  if (compressed.isSome() && finished) {
+    Try<string> remaining = compressor->finish();
+    if (remaining.isError()) {
+      compressed = Error(remaining.error());
+    } else {
+      compressed->append(remaining.get());
+    }
+  }
+
+  if (compressed.isError()) {
+    VLOG(1) << "Failed to gzip response body: " << compressed.error();
+
+    // The chunked headers were already sent, so there is no way to
+    // report the failure in the response; closing the connection
+    // tells the client that the response is incomplete. This also
+    // terminates this proxy, so there is no next response to process.
+    socket_manager->close(socket);
+    return;
+  }
+
+  std::ostringstream out;
+
+  // Zlib buffers data internally, so there might not be any output
+  // for this chunk yet.
+  if (!compressed->empty()) {
+    out << std::hex << compressed->size() << "\r\n";
+    out << compressed.get();
+    out << "\r\n";
+  }
+
+  if (finished) {
+    out << "0\r\n" << "\r\n";
+  }
+
+  string data = out.str();
+
+  if (!data.empty()) {
+    // Always persist the connection when streaming is not finished.
+    socket_manager->send(
+        new DataEncoder(std::move(data)),
+        finished ? request->keepAlive : true,
+        socket);
+  }
+
+  if (finished) {
+    next();
+  } else {
+    dispatch(
+        self(), &HttpProxy::compress, request, compressor, body, offset);
+  }
+}
+
 } // namespace process {
@@ -14,12 +14,15 @@
 #define __PROCESS_HTTP_PROXY_HPP__
 
 #include <queue>
+#include <string>
 
 #include <process/future.hpp>
 #include <process/http.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/socket.hpp>
 
+#include <stout/gzip.hpp>
 #include <stout/option.hpp>
 
 namespace process {
@@ -73,6 +76,14 @@ private:
       const Owned<http::Request>& request,
       const Future<std::string>& chunk);
 
+  // Gzips and sends the chunk of a large body that starts at `offset`,
+  // then continues with the next chunk in a later dispatch.
+  void compress(
+      const Owned<http::Request>& request,
+      const Owned<gzip::Compressor>& compressor,
+      const Owned<std::string>& body,
+      size_t offset);
+
   network::inet::Socket socket; // Store the socket to keep it open.
 
   // Describes a queue "item" that wraps the future to the response
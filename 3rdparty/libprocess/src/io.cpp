@@ -30,6 +30,12 @@
 #include <stout/os/strerror.hpp>
 #include <stout/os/write.hpp>
 
+#ifdef USE_IO_URING
+#include <sys/stat.h>
+
+#include "io_uring.hpp"
+#endif // USE_IO_URING
+
 using std::string;
 using std::vector;
 
@@ -37,7 +43,23 @@ namespace process {
 namespace io {
 namespace internal {
 
-Future<size_t> read(int_fd fd, void* data, size_t size)
+// Returns true if reads and writes of the file descriptor go through
+// io_uring, which is only the case for regular files (see io_uring.hpp).
+// This needs an `fstat`, so callers that read or write the same file
+// descriptor repeatedly determine it once and pass it to `read` and
+// `write` below.
+static bool uring(int_fd fd)
+{
+#ifdef USE_IO_URING
+  struct stat s;
+  return io_uring::available() && ::fstat(fd, &s) == 0 && S_ISREG(s.st_mode);
+#else
+  return false;
+#endif // USE_IO_URING
+}
+
+
+Future<size_t> read(int_fd fd, void* data, size_t size, bool ring)
 {
   // TODO(benh): Let the system calls do what ever they're supposed to
   // rather than return 0 here?
@@ -48,6 +70,13 @@ Future<size_t> read(int_fd fd, void* data, size_t size)
   return loop(
       None(),
       [=]() -> Future<Option<size_t>> {
+#ifdef USE_IO_URING
+        if (ring) {
+          return io_uring::read(fd, data, size)
+            .then([](int result) { return io_uring::result(result); });
+        }
+#endif // USE_IO_URING
+
         // Because the file descriptor is non-blocking, we call
         // read()/recv() immediately. If no data is available than
         // we'll call `poll` and block. We also observed that for some
@@ -87,7 +116,7 @@ Future<size_t> read(int_fd fd, void* data, size_t size)
 }
 
 
-Future<size_t> write(int_fd fd, const void* data, size_t size)
+Future<size_t> write(int_fd fd, const void* data, size_t size, bool ring)
 {
   // TODO(benh): Let the system calls do what ever they're supposed to
   // rather than return 0 here?
@@ -98,6 +127,13 @@ Future<size_t> write(int_fd fd, const void* data, size_t size)
   return loop(
       None(),
       [=]() -> Future<Option<size_t>> {
+#ifdef USE_IO_URING
+        if (ring) {
+          return io_uring::write(fd, data, size)
+            .then([](int result) { return io_uring::result(result); });
+        }
+#endif // USE_IO_URING
+
         ssize_t length = os::write(fd, data, size);
 
         if (length < 0) {
@@ -148,7 +184,7 @@ Future<size_t> read(int_fd fd, void* data, size_t size)
     return Failure("Expected a non-blocking file descriptor");
   }
 
-  return internal::read(fd, data, size);
+  return internal::read(fd, data, size, internal::uring(fd));
 }
 
 
@@ -168,7 +204,7 @@ Future<size_t> write(int_fd fd, const void* data, size_t size)
     return Failure("Expected a non-blocking file descriptor");
   }
 
-  return internal::write(fd, data, size);
+  return internal::write(fd, data, size, internal::uring(fd));
 }
 
 
@@ -181,10 +217,15 @@ Future<Nothing> splice(
     const vector<lambda::function<void(const string&)>>& hooks)
 {
   boost::shared_array<char> data(new char[chunk]);
+
+  // NOTE: Both file descriptors have been made non-blocking by
+  // `redirect`, so we skip the checks done by `io::read`.
+  const bool ring = uring(from);
+
   return loop(
       None(),
       [=]() {
-        return io::read(from, data.get(), chunk);
+        return internal::read(from, data.get(), chunk, ring);
       },
       [=](size_t length) -> Future<ControlFlow<Nothing>> {
         if (length == 0) { // EOF.
@@ -251,10 +292,12 @@ Future<string> read(int_fd fd)
   std::shared_ptr<string> buffer(new string());
   boost::shared_array<char> data(new char[BUFFERED_READ_SIZE]);
 
+  const bool ring = internal::uring(fd);
+
   return loop(
       None(),
       [=]() {
-        return io::read(fd, data.get(), BUFFERED_READ_SIZE);
+        return internal::read(fd, data.get(), BUFFERED_READ_SIZE, ring);
       },
       [=](size_t length) -> ControlFlow<string> {
         if (length == 0) { // EOF.
@@ -316,10 +359,12 @@ Future<Nothing> write(int_fd fd, const string& data)
   // We need to share the `index` between both lambdas below.
   std::shared_ptr<size_t> index(new size_t(0));
 
+  const bool ring = internal::uring(fd);
+
   return loop(
       None(),
       [=]() {
-        return io::write(fd, data.data() + *index, size - *index);
+        return internal::write(fd, data.data() + *index, size - *index, ring);
       },
       [=](size_t length) -> ControlFlow<Nothing> {
         if ((*index += length) != size) {
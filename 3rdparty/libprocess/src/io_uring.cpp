@@ -0,0 +1,611 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/future.hpp>
+#include <process/io.hpp>
+#include <process/owned.hpp>
+
+#include <stout/error.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/lambda.hpp>
+#include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
+#include <stout/try.hpp>
+
+#include <stout/os/close.hpp>
+
+#include "io_uring.hpp"
+
+using std::deque;
+using std::pair;
+using std::vector;
+
+namespace process {
+namespace io_uring {
+namespace internal {
+
+// Number of submission queue entries. Note that this does not bound
+// the number of operations in flight.
+constexpr unsigned ENTRIES = 1024;
+
+// The `user_data` of cancellation requests, which never refers to an
+// operation (identifiers start at 1).
+constexpr uint64_t CANCELLATION = 0;
+
+
+struct Operation
+{
+  Operation(uint8_t _opcode, int_fd _fd, const void* _data, size_t _size)
+    : opcode(_opcode), fd(_fd), data(_data), size(_size) {}
+
+  // Invoked once the kernel has completed the operation.
+  void complete(int result)
+  {
+    // Only an operation that was actually cancelled is discarded. An
+    // operation that completed despite a discard keeps its result,
+    // since the data has been read or written by then.
+    if (result == -ECANCELED && promise.future().hasDiscard()) {
+      promise.discard();
+      return;
+    }
+
+    promise.set(result);
+  }
+
+  uint64_t id = 0;
+
+  const uint8_t opcode;
+  const int_fd fd;
+
+  // The memory of the caller the kernel reads from or writes into, see
+  // io_uring.hpp.
+  const void* data;
+  const size_t size;
+
+  Promise<int> promise;
+};
+
+
+class Ring
+{
+public:
+  static Try<Ring*> create(unsigned entries);
+
+  Future<int> submit(Owned<Operation> operation);
+
+private:
+  Ring() = default;
+
+  // Returns the next (cleared) submission queue entry, or nullptr if
+  // the submission queue is full. The caller must hold `mutex`.
+  io_uring_sqe* entry();
+
+  // Makes the entry returned by `entry` visible to the kernel.
+  void push();
+
+  // Prepares a submission queue entry for the operation, or for the
+  // cancellation of the operation with the specified identifier.
+  // Returns false if the submission queue is full. The caller must
+  // hold `mutex`.
+  bool prepare(Operation* operation);
+  bool prepare(uint64_t id);
+
+  // Asks the kernel to cancel the operation, or completes the
+  // operation right away if it has not been submitted yet.
+  void cancel(uint64_t id);
+
+  // Pushes the prepared entries to the kernel. The caller must hold
+  // `mutex`.
+  void enter();
+
+  // Waits for the eventfd to become readable and then reaps.
+  void wait();
+
+  // Completes all of the operations in the completion queue and
+  // prepares any backlogged entries for which there is now room.
+  void reap();
+
+  int fd = -1;
+  int eventfd = -1;
+
+  // Submission queue.
+  unsigned* sqHead = nullptr;
+  unsigned* sqTail = nullptr;
+  unsigned* sqMask = nullptr;
+  unsigned* sqFlags = nullptr;
+  unsigned* sqArray = nullptr;
+  unsigned sqEntries = 0;
+  io_uring_sqe* sqes = nullptr;
+
+  // Completion queue.
+  unsigned* cqHead = nullptr;
+  unsigned* cqTail = nullptr;
+  unsigned* cqMask = nullptr;
+  io_uring_cqe* cqes = nullptr;
+
+  std::mutex mutex;
+
+  uint64_t next = 1;
+
+  // Submission queue entries that were prepared but not yet consumed
+  // by the kernel.
+  unsigned unsubmitted = 0;
+
+  // All operations that have not completed, including the backlogged.
+  hashmap<uint64_t, Owned<Operation>> operations;
+
+  // Operations and cancellations waiting for room in the submission
+  // queue, which only fills up if the kernel refuses submissions.
+  deque<uint64_t> backlog;
+  deque<uint64_t> cancellations;
+};
+
+
+static long setup(unsigned entries, io_uring_params* params)
+{
+  return ::syscall(__NR_io_uring_setup, entries, params);
+}
+
+
+static long enter(int fd, unsigned submit, unsigned complete, unsigned flags)
+{
+  return ::syscall(
+      __NR_io_uring_enter, fd, submit, complete, flags, nullptr, 0);
+}
+
+
+static long register_(int fd, unsigned opcode, void* arg, unsigned args)
+{
+  return ::syscall(__NR_io_uring_register, fd, opcode, arg, args);
+}
+
+
+Try<Ring*> Ring::create(unsigned entries)
+{
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  int fd = static_cast<int>(setup(entries, &params));
+  if (fd < 0) {
+    return ErrnoError("Failed to set up io_uring");
+  }
+
+  // We rely on the kernel to keep completions that do not fit into the
+  // completion queue, as there is no bound on the number of operations
+  // in flight.
+  if (!(params.features & IORING_FEAT_NODROP)) {
+    os::close(fd);
+    return Error("The io_uring does not support IORING_FEAT_NODROP");
+  }
+
+  // Make sure the kernel supports all of the operations we use.
+  const size_t length =
+    sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op);
+
+  std::unique_ptr<char[]> storage(new char[length]());
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.get());
+
+  if (register_(fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+    ErrnoError error("Failed to probe io_uring operations");
+    os::close(fd);
+    return error;
+  }
+
+  const uint8_t opcodes[] = {
+    IORING_OP_READ,
+    IORING_OP_WRITE,
+    IORING_OP_ASYNC_CANCEL
+  };
+
+  foreach (uint8_t opcode, opcodes) {
+    if (opcode > probe->last_op ||
+        !(probe->ops[opcode].flags & IO_URING_OP_SUPPORTED)) {
+      os::close(fd);
+      return Error(
+          "The io_uring operation " + stringify(static_cast<int>(opcode)) +
+          " is not supported");
+    }
+  }
+
+  // Map the rings. Newer kernels map both queues with one mapping.
+  size_t sqLength =
+    params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  size_t cqLength =
+    params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+  const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single) {
+    sqLength = cqLength = std::max(sqLength, cqLength);
+  }
+
+  void* sq = ::mmap(
+      nullptr,
+      sqLength,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      fd,
+      IORING_OFF_SQ_RING);
+
+  if (sq == MAP_FAILED) {
+    ErrnoError error("Failed to map io_uring submission queue");
+    os::close(fd);
+    return error;
+  }
+
+  void* cq = sq;
+  if (!single) {
+    cq = ::mmap(
+        nullptr,
+        cqLength,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        fd,
+        IORING_OFF_CQ_RING);
+
+    if (cq == MAP_FAILED) {
+      ErrnoError error("Failed to map io_uring completion queue");
+      ::munmap(sq, sqLength);
+      os::close(fd);
+      return error;
+    }
+  }
+
+  void* sqes = ::mmap(
+      nullptr,
+      params.sq_entries * sizeof(io_uring_sqe),
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE,
+      fd,
+      IORING_OFF_SQES);
+
+  if (sqes == MAP_FAILED) {
+    ErrnoError error("Failed to map io_uring submission queue entries");
+    if (!single) {
+      ::munmap(cq, cqLength);
+    }
+    ::munmap(sq, sqLength);
+    os::close(fd);
+    return error;
+  }
+
+  // Completions are signaled through an eventfd that is polled by the
+  // event loop, see `wait`.
+  int efd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (efd < 0 || register_(fd, IORING_REGISTER_EVENTFD, &efd, 1) < 0) {
+    ErrnoError error("Failed to register io_uring eventfd");
+    if (efd >= 0) {
+      os::close(efd);
+    }
+    ::munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+    if (!single) {
+      ::munmap(cq, cqLength);
+    }
+    ::munmap(sq, sqLength);
+    os::close(fd);
+    return error;
+  }
+
+  // NOTE: Like the event loops, the ring is never destroyed.
+  Ring* ring = new Ring();
+  ring->fd = fd;
+  ring->eventfd = efd;
+
+  char* sqBase = static_cast<char*>(sq);
+  ring->sqHead = reinterpret_cast<unsigned*>(sqBase + params.sq_off.head);
+  ring->sqTail = reinterpret_cast<unsigned*>(sqBase + params.sq_off.tail);
+  ring->sqMask = reinterpret_cast<unsigned*>(sqBase + params.sq_off.ring_mask);
+  ring->sqFlags = reinterpret_cast<unsigned*>(sqBase + params.sq_off.flags);
+  ring->sqArray = reinterpret_cast<unsigned*>(sqBase + params.sq_off.array);
+  ring->sqEntries = params.sq_entries;
+  ring->sqes = static_cast<io_uring_sqe*>(sqes);
+
+  char* cqBase = static_cast<char*>(cq);
+  ring->cqHead = reinterpret_cast<unsigned*>(cqBase + params.cq_off.head);
+  ring->cqTail = reinterpret_cast<unsigned*>(cqBase + params.cq_off.tail);
+  ring->cqMask = reinterpret_cast<unsigned*>(cqBase + params.cq_off.ring_mask);
+  ring->cqes = reinterpret_cast<io_uring_cqe*>(cqBase + params.cq_off.cqes);
+
+  ring->wait();
+
+  return ring;
+}
+
+
+Future<int> Ring::submit(Owned<Operation> operation)
+{
+  Future<int> future = operation->promise.future();
+
+  uint64_t id;
+
+  synchronized (mutex) {
+    id = next++;
+    operation->id = id;
+    operations.put(id, operation);
+
+    if (backlog.empty() && prepare(operation.get())) {
+      enter();
+    } else {
+      backlog.push_back(id);
+    }
+  }
+
+  future.onDiscard([=]() {
+    cancel(id);
+  });
+
+  return future;
+}
+
+
+io_uring_sqe* Ring::entry()
+{
+  const unsigned tail = *sqTail;
+
+  if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == sqEntries) {
+    return nullptr; // Full.
+  }
+
+  io_uring_sqe* sqe = &sqes[tail & *sqMask];
+  memset(sqe, 0, sizeof(*sqe));
+
+  return sqe;
+}
+
+
+void Ring::push()
+{
+  const unsigned tail = *sqTail;
+  const unsigned index = tail & *sqMask;
+
+  sqArray[index] = index;
+
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+  unsubmitted++;
+}
+
+
+bool Ring::prepare(Operation* operation)
+{
+  io_uring_sqe* sqe = entry();
+  if (sqe == nullptr) {
+    return false;
+  }
+
+  sqe->opcode = operation->opcode;
+  sqe->fd = operation->fd;
+  sqe->addr = reinterpret_cast<uint64_t>(operation->data);
+  // A single read or write transfers at most `INT_MAX` bytes (as the
+  // result is an `int`), so larger sizes are clamped rather than
+  // truncated to their low 32 bits; callers handle short transfers.
+  sqe->len = static_cast<uint32_t>(std::min<size_t>(
+      operation->size,
+      static_cast<size_t>(std::numeric_limits<int>::max())));
+  sqe->user_data = operation->id;
+
+  // Use (and advance) the current file position.
+  sqe->off = static_cast<uint64_t>(-1);
+
+  push();
+
+  return true;
+}
+
+
+bool Ring::prepare(uint64_t id)
+{
+  io_uring_sqe* sqe = entry();
+  if (sqe == nullptr) {
+    return false;
+  }
+
+  // The operation completes with ECANCELED (or its actual result if it
+  // raced with the cancellation) through the usual path.
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = id;
+  sqe->user_data = CANCELLATION;
+
+  push();
+
+  return true;
+}
+
+
+void Ring::cancel(uint64_t id)
+{
+  Owned<Operation> operation;
+
+  synchronized (mutex) {
+    if (!operations.contains(id)) {
+      return; // Already completed.
+    }
+
+    auto backlogged = std::find(backlog.begin(), backlog.end(), id);
+
+    if (backlogged == backlog.end()) {
+      if (cancellations.empty() && prepare(id)) {
+        enter();
+      } else {
+        cancellations.push_back(id);
+      }
+      return;
+    }
+
+    // The kernel never saw the operation so we can complete it now.
+    backlog.erase(backlogged);
+    operation = operations.at(id);
+    operations.erase(id);
+  }
+
+  operation->complete(-ECANCELED);
+}
+
+
+void Ring::enter()
+{
+  while (unsubmitted > 0) {
+    long submitted = internal::enter(fd, unsubmitted, 0, 0);
+
+    if (submitted < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      // The entries stay in the submission queue and are pushed to
+      // the kernel after the next completions have been reaped.
+      if (errno != EAGAIN && errno != EBUSY) {
+        LOG(ERROR) << "Failed to submit to io_uring: " << os::strerror(errno);
+      }
+
+      return;
+    }
+
+    unsubmitted -= static_cast<unsigned>(submitted);
+  }
+}
+
+
+void Ring::wait()
+{
+  io::poll(eventfd, io::READ)
+    .onAny([this](const Future<short>&) {
+      uint64_t count;
+      while (::read(eventfd, &count, sizeof(count)) < 0 && errno == EINTR);
+
+      reap();
+      wait();
+    });
+}
+
+
+void Ring::reap()
+{
+  vector<pair<Owned<Operation>, int>> completed;
+
+  synchronized (mutex) {
+    while (true) {
+      unsigned head = *cqHead;
+
+      while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+
+        const uint64_t id = cqe.user_data;
+
+        if (id != CANCELLATION && operations.contains(id)) {
+          completed.emplace_back(operations.at(id), cqe.res);
+          operations.erase(id);
+        }
+
+        head++;
+      }
+
+      __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+      // Completions that did not fit into the completion queue are
+      // kept by the kernel (see `IORING_FEAT_NODROP`) until we ask
+      // for them.
+      if (!(__atomic_load_n(sqFlags, __ATOMIC_ACQUIRE) &
+            IORING_SQ_CQ_OVERFLOW)) {
+        break;
+      }
+
+      internal::enter(fd, 0, 0, IORING_ENTER_GETEVENTS);
+    }
+
+    // Prepare whatever did not fit into the submission queue before.
+    while (!cancellations.empty() && prepare(cancellations.front())) {
+      cancellations.pop_front();
+    }
+
+    while (!backlog.empty() &&
+           prepare(operations.at(backlog.front()).get())) {
+      backlog.pop_front();
+    }
+
+    enter();
+  }
+
+  // Complete the operations outside of the mutex as this invokes
+  // arbitrary callbacks, which may submit more operations.
+  foreach (auto& completion, completed) {
+    completion.first->complete(completion.second);
+  }
+}
+
+
+// Returns the ring, or nullptr if io_uring is not supported.
+static Ring* ring()
+{
+  static Ring* ring = []() -> Ring* {
+    Try<Ring*> ring = Ring::create(ENTRIES);
+    if (ring.isError()) {
+      LOG(WARNING) << "Falling back to non-blocking I/O: " << ring.error();
+      return nullptr;
+    }
+
+    return ring.get();
+  }();
+
+  return ring;
+}
+
+} // namespace internal {
+
+
+bool available()
+{
+  return internal::ring() != nullptr;
+}
+
+
+Future<int> read(int_fd fd, void* data, size_t size)
+{
+  Owned<internal::Operation> operation(
+      new internal::Operation(IORING_OP_READ, fd, data, size));
+
+  return internal::ring()->submit(operation);
+}
+
+
+Future<int> write(int_fd fd, const void* data, size_t size)
+{
+  Owned<internal::Operation> operation(
+      new internal::Operation(IORING_OP_WRITE, fd, data, size));
+
+  return internal::ring()->submit(operation);
+}
+
+} // namespace io_uring {
+} // namespace process {
@@ -0,0 +1,83 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_IO_URING_HPP__
+#define __PROCESS_IO_URING_HPP__
+
+#include <errno.h>
+#include <stddef.h> // For size_t.
+
+#include <process/future.hpp>
+
+#include <stout/error.hpp>
+#include <stout/none.hpp>
+#include <stout/option.hpp>
+
+#include <stout/os/int_fd.hpp>
+#include <stout/os/strerror.hpp>
+
+namespace process {
+
+// Completion based I/O through a Linux io_uring, enabled at configure
+// time (see `--enable-io-uring` and `ENABLE_IO_URING`).
+//
+// The ring complements rather than replaces the event loop: requests
+// are submitted from any thread and the completions are delivered by
+// the event loop, which polls an eventfd registered with the ring.
+//
+// This is only used for regular files, whose reads and writes are
+// never reported as would-block and hence block the calling thread
+// when done with system calls. Sockets and pipes are non-blocking, so
+// the kernel would fail an operation on them with EAGAIN right away,
+// and the caller would have to poll and submit again; they keep
+// using the non-blocking system calls.
+//
+// The kernel reads and writes the memory of the caller directly, so
+// the memory must remain valid until the returned future is no longer
+// pending. A discard does not take effect until the kernel has given
+// up the operation: if the operation completed anyway, the future is
+// set to its result rather than discarded, so that no data that was
+// read or written goes unnoticed.
+namespace io_uring {
+
+// Returns true if the kernel supports all of the operations below.
+// Otherwise the callers must use the non-blocking system calls.
+bool available();
+
+
+// Each of the following returns the result of the corresponding
+// system call at the current file position: the (non-negative) length
+// or a negated errno.
+Future<int> read(int_fd fd, void* data, size_t size);
+Future<int> write(int_fd fd, const void* data, size_t size);
+
+
+// Converts the result of an operation into the form used by the I/O
+// loops: the length, None if the file descriptor was not ready and
+// the operation should be retried after polling, or a failure.
+inline Future<Option<size_t>> result(int result)
+{
+  if (result >= 0) {
+    return static_cast<size_t>(result);
+  }
+
+  if (-result == EINTR || -result == EAGAIN || -result == EWOULDBLOCK) {
+    return None();
+  }
+
+  return Failure(os::strerror(-result));
+}
+
+} // namespace io_uring {
+} // namespace process {
+
+#endif // __PROCESS_IO_URING_HPP__
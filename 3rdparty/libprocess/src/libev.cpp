@@ -12,10 +12,17 @@
 
 #include <ev.h>
 
+#include <functional>
 #include <mutex>
 #include <queue>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <process/once.hpp>
 
 #include <stout/duration.hpp>
+#include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 
@@ -24,47 +31,49 @@
 
 namespace process {
 
-ev_async async_watcher;
-// We need an asynchronous watcher to receive the request to shutdown.
-ev_async shutdown_watcher;
-
 // Define the initial values for all of the declarations made in
 // libev.hpp (since these need to live in the static data space).
+std::vector<EventLoopContext*>* contexts = new std::vector<EventLoopContext*>();
+
 struct ev_loop* loop = nullptr;
 
-std::queue<ev_io*>* watchers = new std::queue<ev_io*>();
+thread_local EventLoopContext* _event_loop_context_ = nullptr;
 
-std::mutex* watchers_mutex = new std::mutex();
+thread_local bool* _in_event_loop_ = nullptr;
 
-std::queue<lambda::function<void()>>* functions =
-  new std::queue<lambda::function<void()>>();
 
-thread_local bool* _in_event_loop_ = nullptr;
+EventLoopContext* context(int_fd fd)
+{
+  CHECK(!contexts->empty());
+  return contexts->at(std::hash<int_fd>()(fd) % contexts->size());
+}
 
 
-void handle_async(struct ev_loop* loop, ev_async* _, int revents)
+void handle_async(struct ev_loop* loop, ev_async* async, int revents)
 {
+  EventLoopContext* context = static_cast<EventLoopContext*>(async->data);
+
   std::queue<lambda::function<void()>> run_functions;
-  synchronized (watchers_mutex) {
+  synchronized (context->mutex) {
     // Start all the new I/O watchers.
-    while (!watchers->empty()) {
-      ev_io* watcher = watchers->front();
-      watchers->pop();
+    while (!context->watchers.empty()) {
+      ev_io* watcher = context->watchers.front();
+      context->watchers.pop();
       ev_io_start(loop, watcher);
     }
 
     // Swap the functions into a temporary queue so that we can invoke
     // them outside of the mutex.
-    std::swap(run_functions, *functions);
+    std::swap(run_functions, context->functions);
   }
 
   // Running the functions outside of the mutex reduces locking
   // contention as these are arbitrary functions that can take a long
   // time to execute. Doing this also avoids a deadlock scenario where
   // (A) mutexes are acquired before calling `run_in_event_loop`,
-  // followed by locking (B) `watchers_mutex`. If we executed the
+  // followed by locking (B) `context->mutex`. If we executed the
   // functions inside the mutex, then the locking order violation
-  // would be this function acquiring the (B) `watchers_mutex`
+  // would be this function acquiring the (B) `context->mutex`
   // followed by the arbitrary function acquiring the (A) mutexes.
   while (!run_functions.empty()) {
     (run_functions.front())();
@@ -79,15 +88,51 @@ void handle_shutdown(struct ev_loop* loop, ev_async* _, int revents)
 }
 
 
-void EventLoop::initialize()
+void EventLoop::initialize(size_t count)
 {
-  loop = ev_default_loop(EVFLAG_AUTO);
+  CHECK_GT(count, 0u);
 
-  ev_async_init(&async_watcher, handle_async);
-  ev_async_init(&shutdown_watcher, handle_shutdown);
+  // NOTE: The event loops are reused if libprocess is reinitialized.
+  static Once* initialized = new Once();
+
+  if (initialized->once()) {
+    return;
+  }
 
-  ev_async_start(loop, &async_watcher);
-  ev_async_start(loop, &shutdown_watcher);
+  for (size_t i = 0; i < count; i++) {
+    EventLoopContext* context = new EventLoopContext();
+
+    // Only the default loop can handle child and signal watchers so
+    // we use it for the first event loop.
+    context->loop = i == 0
+      ? ev_default_loop(EVFLAG_AUTO)
+      : ev_loop_new(EVFLAG_AUTO);
+
+    if (context->loop == nullptr) {
+      LOG(FATAL) << "Failed to initialize event loop " << i;
+    }
+
+    ev_async_init(&context->async_watcher, handle_async);
+    ev_async_init(&context->shutdown_watcher, handle_shutdown);
+
+    context->async_watcher.data = context;
+    context->shutdown_watcher.data = context;
+
+    ev_async_start(context->loop, &context->async_watcher);
+    ev_async_start(context->loop, &context->shutdown_watcher);
+
+    contexts->push_back(context);
+  }
+
+  loop = contexts->front()->loop;
+
+  initialized->done();
+}
+
+
+size_t EventLoop::count()
+{
+  return contexts->size();
 }
 
 
@@ -148,19 +193,25 @@ double EventLoop::time()
 }
 
 
-void EventLoop::run()
+void EventLoop::run(size_t index)
 {
+  EventLoopContext* context = contexts->at(index);
+
   __in_event_loop__ = true;
+  _event_loop_context_ = context;
 
-  ev_loop(loop, 0);
+  ev_loop(context->loop, 0);
 
+  _event_loop_context_ = nullptr;
   __in_event_loop__ = false;
 }
 
 
 void EventLoop::stop()
 {
-  ev_async_send(loop, &shutdown_watcher);
+  foreach (EventLoopContext* context, *contexts) {
+    ev_async_send(context->loop, &context->shutdown_watcher);
+  }
 }
 
 } // namespace process {
@@ -17,6 +17,7 @@
 
 #include <mutex>
 #include <queue>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/owned.hpp>
@@ -24,25 +25,54 @@
 #include <stout/lambda.hpp>
 #include <stout/synchronized.hpp>
 
+#include <stout/os/int_fd.hpp>
+
 namespace process {
 
-// Event loop.
+// State for a single libev event loop. We run each event loop on its
+// own thread (see `EventLoop::run`) and pin file descriptors to a
+// loop so that all of the I/O for a socket is handled by one thread.
+struct EventLoopContext
+{
+  struct ev_loop* loop = nullptr;
+
+  // Asynchronous watcher for interrupting loop to specifically deal
+  // with IO watchers and functions (via run_in_event_loop).
+  ev_async async_watcher;
+
+  // We need an asynchronous watcher to receive the request to shutdown.
+  ev_async shutdown_watcher;
+
+  // Protects 'watchers' and 'functions' below.
+  std::mutex mutex;
+
+  // Queue of I/O watchers to be asynchronously added to the event loop.
+  // TODO(benh): Replace this queue with functions that we put in
+  // 'functions' below that perform the ev_io_start themselves.
+  std::queue<ev_io*> watchers;
+
+  // Queue of functions to be invoked asynchronously within the event
+  // loop.
+  std::queue<lambda::function<void()>> functions;
+};
+
+
+// All of the event loops, see `EventLoop::initialize`. The first
+// event loop is the "default" event loop which is used for anything
+// that is not associated with a file descriptor (e.g., timers).
+extern std::vector<EventLoopContext*>* contexts;
+
+// Default event loop, i.e., `contexts->front()->loop`.
 extern struct ev_loop* loop;
 
-// Asynchronous watcher for interrupting loop to specifically deal
-// with IO watchers and functions (via run_in_event_loop).
-extern ev_async async_watcher;
 
-// Queue of I/O watchers to be asynchronously added to the event loop
-// (protected by 'watchers' below).
-// TODO(benh): Replace this queue with functions that we put in
-// 'functions' below that perform the ev_io_start themselves.
-extern std::queue<ev_io*>* watchers;
-extern std::mutex* watchers_mutex;
+// Returns the event loop that the file descriptor is pinned to.
+EventLoopContext* context(int_fd fd);
+
 
-// Queue of functions to be invoked asynchronously within the vent
-// loop (protected by 'watchers' above).
-extern std::queue<lambda::function<void()>>* functions;
+// Per thread pointer to the event loop that the thread is running, or
+// `nullptr` if the thread is not an event loop thread.
+extern thread_local EventLoopContext* _event_loop_context_;
 
 // Per thread bool pointer. We use a pointer to lazily construct the
 // actual bool.
@@ -67,12 +97,14 @@ void _run_in_event_loop(
 }
 
 
-// Helper for running a function in the event loop.
+// Helper for running a function in the specified event loop.
 template <typename T>
-Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+Future<T> run_in_event_loop(
+    EventLoopContext* context,
+    const lambda::function<Future<T>()>& f)
 {
   // If this is already the event loop then just run the function.
-  if (__in_event_loop__) {
+  if (__in_event_loop__ && _event_loop_context_ == context) {
     return f();
   }
 
@@ -81,16 +113,24 @@ Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
   Future<T> future = promise->future();
 
   // Enqueue the function.
-  synchronized (watchers_mutex) {
-    functions->push(lambda::bind(&_run_in_event_loop<T>, f, promise));
+  synchronized (context->mutex) {
+    context->functions.push(lambda::bind(&_run_in_event_loop<T>, f, promise));
   }
 
   // Interrupt the loop.
-  ev_async_send(loop, &async_watcher);
+  ev_async_send(context->loop, &context->async_watcher);
 
   return future;
 }
 
+
+// Helper for running a function in the default event loop.
+template <typename T>
+Future<T> run_in_event_loop(const lambda::function<Future<T>()>& f)
+{
+  return run_in_event_loop<T>(contexts->front(), f);
+}
+
 } // namespace process {
 
 #endif // __LIBEV_HPP__
@@ -90,14 +90,16 @@ namespace io {
 namespace internal {
 
 // Helper/continuation of 'poll' on future discard.
-void _poll(const std::shared_ptr<ev_async>& async)
+void _poll(struct ev_loop* loop, const std::shared_ptr<ev_async>& async)
 {
   ev_async_send(loop, async.get());
 }
 
 
-Future<short> poll(int_fd fd, short events)
+Future<short> poll(EventLoopContext* context, int_fd fd, short events)
 {
+  struct ev_loop* loop = context->loop;
+
   Poll* poll = new Poll();
 
   // Have the watchers data point back to the struct.
@@ -117,7 +119,7 @@ Future<short> poll(int_fd fd, short events)
   // in this case while we will interrupt the event loop since the
   // async watcher has already been stopped we won't cause
   // 'discard_poll' to get invoked.
-  future.onDiscard(lambda::bind(&_poll, poll->watcher.async));
+  future.onDiscard(lambda::bind(&_poll, loop, poll->watcher.async));
 
   // Initialize and start the I/O watcher.
   ev_io_init(poll->watcher.io.get(), polled, fd, events);
@@ -135,7 +137,13 @@ Future<short> poll(int_fd fd, short events)
 
   // TODO(benh): Check if the file descriptor is non-blocking?
 
-  return run_in_event_loop<short>(lambda::bind(&internal::poll, fd, events));
+  // All polling for a file descriptor is done by the event loop that
+  // the file descriptor is pinned to.
+  EventLoopContext* context = process::context(fd);
+
+  return run_in_event_loop<short>(
+      context,
+      lambda::bind(&internal::poll, context, fd, events));
 }
 
 } // namespace io {
@@ -14,7 +14,10 @@
 #include <unistd.h>
 #endif // __WINDOWS__
 
+#include <functional>
 #include <mutex>
+#include <queue>
+#include <vector>
 
 #include <event2/event.h>
 #include <event2/thread.h>
@@ -23,6 +26,8 @@
 #include <process/logging.hpp>
 #include <process/once.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/synchronized.hpp>
 
 #include "event_loop.hpp"
@@ -30,26 +35,49 @@
 
 namespace process {
 
+std::vector<event_base*>* bases = new std::vector<event_base*>();
+
 event_base* base = nullptr;
 
 
-static std::mutex* functions_mutex = new std::mutex();
-std::queue<lambda::function<void()>>* functions =
-  new std::queue<lambda::function<void()>>();
+// Queue of functions to be invoked asynchronously within an event
+// loop (protected by 'mutex').
+struct Functions
+{
+  std::mutex mutex;
+  std::queue<lambda::function<void()>> queue;
+};
+
 
+// The functions for each event loop, keyed by event loop. This is
+// only modified during `EventLoop::initialize` so it can be read
+// without synchronization.
+static hashmap<event_base*, Functions*>* functions =
+  new hashmap<event_base*, Functions*>();
+
+
+thread_local event_base* _event_loop_base_ = nullptr;
 
 thread_local bool* _in_event_loop_ = nullptr;
 
 
+event_base* base_for(int_fd fd)
+{
+  CHECK(!bases->empty());
+  return bases->at(std::hash<int_fd>()(fd) % bases->size());
+}
+
+
 void async_function(evutil_socket_t socket, short which, void* arg)
 {
   event* ev = reinterpret_cast<event*>(arg);
+  Functions* functions_ = functions->at(event_get_base(ev));
   event_free(ev);
 
   std::queue<lambda::function<void()>> q;
 
-  synchronized (functions_mutex) {
-    std::swap(q, *functions);
+  synchronized (functions_->mutex) {
+    std::swap(q, functions_->queue);
   }
 
   while (!q.empty()) {
@@ -60,16 +88,21 @@ void async_function(evutil_socket_t socket, short which, void* arg)
 
 
 void run_in_event_loop(
+    event_base* base,
     const lambda::function<void()>& f,
     EventLoopLogicFlow event_loop_logic_flow)
 {
-  if (__in_event_loop__ && event_loop_logic_flow == ALLOW_SHORT_CIRCUIT) {
+  if (__in_event_loop__ &&
+      _event_loop_base_ == base &&
+      event_loop_logic_flow == ALLOW_SHORT_CIRCUIT) {
     f();
     return;
   }
 
-  synchronized (functions_mutex) {
-    functions->push(f);
+  Functions* functions_ = functions->at(base);
+
+  synchronized (functions_->mutex) {
+    functions_->queue.push(f);
 
     // Add an event and activate it to interrupt the event loop.
     // TODO(jmlvanre): after libevent v 2.1 we can use
@@ -90,9 +123,20 @@ void run_in_event_loop(
 }
 
 
-void EventLoop::run()
+void run_in_event_loop(
+    const lambda::function<void()>& f,
+    EventLoopLogicFlow event_loop_logic_flow)
+{
+  run_in_event_loop(base, f, event_loop_logic_flow);
+}
+
+
+void EventLoop::run(size_t index)
 {
+  event_base* base = bases->at(index);
+
   __in_event_loop__ = true;
+  _event_loop_base_ = base;
 
   do {
     int result = event_base_loop(base, EVLOOP_ONCE);
@@ -111,13 +155,16 @@ void EventLoop::run()
     }
   } while (true);
 
+  _event_loop_base_ = nullptr;
   __in_event_loop__ = false;
 }
 
 
 void EventLoop::stop()
 {
-  event_base_loopexit(base, nullptr);
+  foreach (event_base* base, *bases) {
+    event_base_loopexit(base, nullptr);
+  }
 }
 
 
@@ -177,8 +224,11 @@ double EventLoop::time()
 }
 
 
-void EventLoop::initialize()
+void EventLoop::initialize(size_t count)
 {
+  CHECK_GT(count, 0u);
+
+  // NOTE: The event loops are reused if libprocess is reinitialized.
   static Once* initialized = new Once();
 
   if (initialized->once()) {
@@ -199,13 +249,26 @@ void EventLoop::initialize()
 #error "Libevent must be compiled with either pthread or Windows thread support"
 #endif
 
-  base = event_base_new();
+  for (size_t i = 0; i < count; i++) {
+    event_base* base = event_base_new();
 
-  if (base == nullptr) {
-    LOG(FATAL) << "Failed to initialize, event_base_new";
+    if (base == nullptr) {
+      LOG(FATAL) << "Failed to initialize, event_base_new";
+    }
+
+    bases->push_back(base);
+    functions->put(base, new Functions());
   }
 
+  base = bases->front();
+
   initialized->done();
 }
 
+
+size_t EventLoop::count()
+{
+  return bases->size();
+}
+
 } // namespace process {
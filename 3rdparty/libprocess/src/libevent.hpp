@@ -15,14 +15,32 @@
 
 #include <event2/event.h>
 
+#include <vector>
+
 #include <stout/lambda.hpp>
 
+#include <stout/os/int_fd.hpp>
+
 namespace process {
 
-// Event loop.
+// All of the event loops, see `EventLoop::initialize`. The first
+// event loop is the "default" event loop which is used for anything
+// that is not associated with a file descriptor (e.g., timers).
+extern std::vector<event_base*>* bases;
+
+// Default event loop, i.e., `bases->front()`.
 extern event_base* base;
 
 
+// Returns the event loop that the file descriptor is pinned to.
+event_base* base_for(int_fd fd);
+
+
+// Per thread pointer to the event loop that the thread is running, or
+// `nullptr` if the thread is not an event loop thread.
+extern thread_local event_base* _event_loop_base_;
+
+
 // Per thread bool pointer. We use a pointer to lazily construct the
 // actual bool.
 extern thread_local bool* _in_event_loop_;
@@ -39,6 +57,14 @@ enum EventLoopLogicFlow
 };
 
 
+// Runs the function in the specified event loop.
+void run_in_event_loop(
+    event_base* base,
+    const lambda::function<void()>& f,
+    EventLoopLogicFlow event_loop_logic_flow = ALLOW_SHORT_CIRCUIT);
+
+
+// Runs the function in the default event loop.
 void run_in_event_loop(
     const lambda::function<void()>& f,
     EventLoopLogicFlow event_loop_logic_flow = ALLOW_SHORT_CIRCUIT);
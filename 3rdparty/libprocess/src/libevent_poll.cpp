@@ -53,11 +53,14 @@ void pollCallback(evutil_socket_t, short what, void* arg)
 }
 
 
-void pollDiscard(const std::weak_ptr<event>& ev, short events)
+void pollDiscard(
+    event_base* base,
+    const std::weak_ptr<event>& ev,
+    short events)
 {
   // Discarding inside the event loop prevents `pollCallback()` from being
   // called twice if the future is discarded.
-  run_in_event_loop([=]() {
+  run_in_event_loop(base, [=]() {
     std::shared_ptr<event> shared = ev.lock();
     // If `ev` cannot be locked `pollCallback` already ran. If it was locked
     // but not pending, `pollCallback` is scheduled to be executed.
@@ -85,6 +88,10 @@ Future<short> poll(int_fd fd, short events)
   short what =
     ((events & io::READ) ? EV_READ : 0) | ((events & io::WRITE) ? EV_WRITE : 0);
 
+  // All polling for a file descriptor is done by the event loop that
+  // the file descriptor is pinned to.
+  event_base* base = base_for(fd);
+
   // Bind `event_free` to the destructor of the `ev` shared pointer
   // guaranteeing that the event will be freed only once.
   poll->ev.reset(
@@ -105,7 +112,7 @@ Future<short> poll(int_fd fd, short events)
   event_add(poll->ev.get(), nullptr);
 
   return future
-    .onDiscard(lambda::bind(&internal::pollDiscard, ev, what));
+    .onDiscard(lambda::bind(&internal::pollDiscard, base, ev, what));
 }
 
 } // namespace io {
@@ -116,6 +116,7 @@ LibeventSSLSocketImpl::~LibeventSSLSocketImpl()
   std::weak_ptr<LibeventSSLSocketImpl>* _event_loop_handle = event_loop_handle;
 
   run_in_event_loop(
+      base_for(fd),
       [_listener, _bev, _event_loop_handle, fd]() {
         // Once this lambda is called, it should not be possible for
         // more event loop callbacks to be triggered with 'this->bev'.
@@ -136,6 +137,18 @@ LibeventSSLSocketImpl::~LibeventSSLSocketImpl()
           bufferevent_disable(_bev, EV_READ | EV_WRITE);
 
           SSL* ssl = bufferevent_openssl_get_ssl(_bev);
+
+          // Since TLS 1.1 a session may be resumed even if its
+          // connection was not shut down cleanly, which is how most
+          // connections end (e.g., when a master fails over). OpenSSL
+          // however discards the session of a connection that gets
+          // freed without having sent a "close notify" alert, unless
+          // we mark the alert as sent.
+          if (openssl::flags().enable_session_resumption &&
+              SSL_is_init_finished(ssl)) {
+            SSL_set_shutdown(ssl, SSL_get_shutdown(ssl) | SSL_SENT_SHUTDOWN);
+          }
+
           SSL_free(ssl);
           bufferevent_free(_bev);
         }
@@ -183,6 +196,7 @@ Try<Nothing, SocketError> LibeventSSLSocketImpl::shutdown(int how)
   auto self = shared(this);
 
   run_in_event_loop(
+      base_for(s),
       [self]() {
         CHECK(__in_event_loop__);
         CHECK(self);
@@ -441,6 +455,7 @@ void LibeventSSLSocketImpl::event_callback(short events)
     Try<Nothing> verify = openssl::verify(ssl, peer_hostname, peer_ip);
     if (verify.isError()) {
       VLOG(1) << "Failed connect, verification error: " << verify.error();
+      openssl::forget(ssl);
       SSL_free(ssl);
       bufferevent_free(bev);
       bev = nullptr;
@@ -526,7 +541,7 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
   // 'event_callback' before 'bufferevent_socket_connect' returns.
   CHECK(bev == nullptr);
   bev = bufferevent_openssl_socket_new(
-      base,
+      base_for(s),
       s,
       ssl,
       BUFFEREVENT_SSL_CONNECTING,
@@ -559,6 +574,11 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
     peer_ip = network::convert<inet::Address>(address)->ip;
   }
 
+  // Offer the session of a previous connection to the same address so
+  // that reconnecting (e.g., after a master failover) does not require
+  // a full handshake.
+  openssl::resume(ssl, stringify(address));
+
   // Optimistically construct a 'ConnectRequest' and future.
   Owned<ConnectRequest> request(new ConnectRequest());
   Future<Nothing> future = request->promise.future();
@@ -582,6 +602,7 @@ Future<Nothing> LibeventSSLSocketImpl::connect(const Address& address)
   auto self = shared(this);
 
   run_in_event_loop(
+      base_for(s),
       [self, address]() {
         sockaddr_storage addr = address;
 
@@ -648,6 +669,7 @@ Future<size_t> LibeventSSLSocketImpl::recv(char* data, size_t size)
 
       if (self != nullptr) {
         run_in_event_loop(
+            base_for(self->get()),
             [self]() {
               CHECK(__in_event_loop__);
               CHECK(self);
@@ -686,6 +708,7 @@ Future<size_t> LibeventSSLSocketImpl::recv(char* data, size_t size)
   auto self = shared(this);
 
   run_in_event_loop(
+      base_for(s),
       [self]() {
         CHECK(__in_event_loop__);
         CHECK(self);
@@ -756,6 +779,7 @@ Future<size_t> LibeventSSLSocketImpl::send(const char* data, size_t size)
   auto self = shared(this);
 
   run_in_event_loop(
+      base_for(s),
       [self, buffer]() {
         CHECK(__in_event_loop__);
         CHECK(self);
@@ -850,6 +874,7 @@ Future<size_t> LibeventSSLSocketImpl::sendfile(
   auto self = shared(this);
 
   run_in_event_loop(
+      base_for(s),
       [self, owned_fd, offset, size]() {
         CHECK(__in_event_loop__);
         CHECK(self);
@@ -902,7 +927,7 @@ Try<Nothing> LibeventSSLSocketImpl::listen(int backlog)
   // can be set to block via the `LEV_OPT_LEAVE_SOCKETS_BLOCKING`
   // flag for `evconnlistener_new`.
   listener = evconnlistener_new(
-      base,
+      base_for(s),
       [](evconnlistener* listener,
          evutil_socket_t socket,
          sockaddr* addr,
@@ -1079,20 +1104,29 @@ void LibeventSSLSocketImpl::accept_callback(AcceptRequest* request)
       accept_queue_.put(impl);
     });
 
-  // If we support downgrading the connection, first wait for this
-  // socket to become readable. We will then MSG_PEEK it to test
-  // whether we want to dispatch as SSL or non-SSL.
-  if (openssl::flags().support_downgrade) {
-    request->peek_event = event_new(
-        base,
-        request->socket,
-        EV_READ,
-        &LibeventSSLSocketImpl::peek_callback,
-        request);
-    event_add(request->peek_event, nullptr);
-  } else {
-    accept_SSL_callback(request);
-  }
+  // The accepted socket may be pinned to a different event loop than
+  // the listening socket, in which case we finish accepting it (and
+  // perform the SSL handshake) in that event loop.
+  run_in_event_loop(
+      base_for(request->socket),
+      [request]() {
+        CHECK(__in_event_loop__);
+
+        // If we support downgrading the connection, first wait for
+        // this socket to become readable. We will then MSG_PEEK it to
+        // test whether we want to dispatch as SSL or non-SSL.
+        if (openssl::flags().support_downgrade) {
+          request->peek_event = event_new(
+              base_for(request->socket),
+              request->socket,
+              EV_READ,
+              &LibeventSSLSocketImpl::peek_callback,
+              request);
+          event_add(request->peek_event, nullptr);
+        } else {
+          accept_SSL_callback(request);
+        }
+      });
 }
 
 
@@ -1108,15 +1142,10 @@ void LibeventSSLSocketImpl::accept_SSL_callback(AcceptRequest* request)
     return;
   }
 
-  // We use 'request->listener' because 'this->listener' may not have
-  // been set by the time this function is executed. See comment in
-  // the lambda for evconnlistener_new in
-  // 'LibeventSSLSocketImpl::listen'.
-  event_base* ev_base = evconnlistener_get_base(request->listener);
-
-  // Construct the bufferevent in the accepting state.
+  // Construct the bufferevent in the accepting state on the event
+  // loop that the accepted socket is pinned to.
   bufferevent* bev = bufferevent_openssl_socket_new(
-      ev_base,
+      base_for(request->socket),
       request->socket,
       ssl,
       BUFFEREVENT_SSL_ACCEPTING,
@@ -12,7 +12,13 @@
 
 #include <glog/logging.h>
 
+#include <ctype.h>
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
 #include <map>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -29,6 +35,7 @@
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
@@ -89,7 +96,24 @@ MetricsProcess* MetricsProcess::create(
     }
   }
 
-  return new MetricsProcess(limiter, authenticationRealm);
+  Option<string> maxStaleness =
+    os::getenv("LIBPROCESS_METRICS_PULL_GAUGE_MAX_STALENESS");
+
+  Option<Duration> staleness;
+
+  if (maxStaleness.isSome()) {
+    Try<Duration> duration = Duration::parse(maxStaleness.get());
+
+    if (duration.isError()) {
+      EXIT(EXIT_FAILURE)
+        << "Failed to parse LIBPROCESS_METRICS_PULL_GAUGE_MAX_STALENESS "
+        << "'" << maxStaleness.get() << "': " << duration.error();
+    }
+
+    staleness = duration.get();
+  }
+
+  return new MetricsProcess(limiter, staleness, authenticationRealm);
 }
 
 
@@ -99,6 +123,11 @@ void MetricsProcess::initialize()
         authenticationRealm,
         help(),
         &MetricsProcess::_snapshot);
+
+  route("/prometheus",
+        authenticationRealm,
+        prometheusHelp(),
+        &MetricsProcess::prometheus);
 }
 
 
@@ -119,6 +148,32 @@ string MetricsProcess::help()
 }
 
 
+string MetricsProcess::prometheusHelp()
+{
+  return HELP(
+      TLDR("Provides the current metrics in the Prometheus text format."),
+      DESCRIPTION(
+          "This endpoint exposes the current metrics in the text-based",
+          "exposition format of Prometheus (version 0.0.4).",
+          "",
+          "Metric names are converted to valid Prometheus names by replacing",
+          "every character other than letters, digits, '_' and ':' with '_'.",
+          "If several metrics end up with the same name, only one of them",
+          "is exposed, preferring timers.",
+          "",
+          "Timers are exposed as histograms with cumulative buckets, all",
+          "other metrics as untyped samples. Unlike '/metrics/snapshot',",
+          "no percentiles are computed. The buckets and the sum of a timer",
+          "are in the unit of the timer (e.g., milliseconds for a timer",
+          "whose name ends with '_ms'), which is also given in its help.",
+          "",
+          "The optional query parameter 'timeout' determines the maximum",
+          "amount of time the endpoint will take to respond. If the timeout",
+          "is exceeded, some metrics may not be included in the response."),
+      AUTHENTICATION(true));
+}
+
+
 Future<Nothing> MetricsProcess::add(Owned<Metric> metric)
 {
   if (metrics.contains(metric->name())) {
@@ -145,16 +200,58 @@ Future<Nothing> MetricsProcess::remove(const string& name)
 Future<map<string, double>> MetricsProcess::snapshot(
     const Option<Duration>& timeout)
 {
-  hashmap<string, Future<double>> futures;
   hashmap<string, Option<Statistics<double>>> statistics;
 
-  foreachkey (const string& name, metrics) {
-    const Owned<Metric>& metric = metrics.at(name);
-    futures[name] = metric->value();
+  foreachpair (const string& name, const Owned<Metric>& metric, metrics) {
     // TODO(dhamon): It would be nice to compute these asynchronously.
     statistics[name] = metric->statistics();
   }
 
+  return evaluate(timeout)
+    .then([statistics](map<string, double> snapshot) {
+      foreachpair (const string& key,
+                   const Option<Statistics<double>>& statistics_,
+                   statistics) {
+        if (statistics_.isSome()) {
+          snapshot[key + "/count"] = static_cast<double>(statistics_->count);
+          snapshot[key + "/min"] = statistics_->min;
+          snapshot[key + "/max"] = statistics_->max;
+          snapshot[key + "/p50"] = statistics_->p50;
+          snapshot[key + "/p90"] = statistics_->p90;
+          snapshot[key + "/p95"] = statistics_->p95;
+          snapshot[key + "/p99"] = statistics_->p99;
+          snapshot[key + "/p999"] = statistics_->p999;
+          snapshot[key + "/p9999"] = statistics_->p9999;
+        }
+      }
+
+      return snapshot;
+    });
+}
+
+
+Future<map<string, double>> MetricsProcess::evaluate(
+    const Option<Duration>& timeout)
+{
+  // Most metrics can be read right away. Only the remaining ones
+  // (i.e., pull gauges without a recent enough value) are computed
+  // through futures, which we then wait for.
+  map<string, double> ready;
+  hashmap<string, Future<double>> futures;
+
+  foreachpair (const string& name, const Owned<Metric>& metric, metrics) {
+    Option<double> value = metric->peek(staleness);
+    if (value.isSome()) {
+      ready[name] = value.get();
+    } else {
+      futures[name] = metric->value();
+    }
+  }
+
+  if (futures.empty()) {
+    return ready;
+  }
+
   Future<Nothing> timedout =
     after(timeout.getOrElse(Duration::max()));
 
@@ -166,10 +263,10 @@ Future<map<string, double>> MetricsProcess::snapshot(
       await(std::move(values)).then([]{ return Nothing(); }) })
     .onAny([=]() mutable { timedout.discard(); }) // Don't accumulate timers.
     .then(defer(self(),
-                &Self::__snapshot,
+                &Self::_evaluate,
                 timeout,
-                std::move(futures),
-                std::move(statistics)));
+                std::move(ready),
+                std::move(futures)));
 }
 
 
@@ -207,12 +304,171 @@ Future<http::Response> MetricsProcess::_snapshot(
 }
 
 
-Future<map<string, double>> MetricsProcess::__snapshot(
+namespace {
+
+// Returns 'name' with all characters that may not appear in the
+// name of a Prometheus metric replaced by '_'.
+string sanitize(const string& name)
+{
+  string result = name;
+
+  for (size_t i = 0; i < result.size(); ++i) {
+    char c = result[i];
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != ':') {
+      result[i] = '_';
+    }
+  }
+
+  if (result.empty() || isdigit(static_cast<unsigned char>(result[0]))) {
+    result = "_" + result;
+  }
+
+  return result;
+}
+
+
+string format(double value)
+{
+  if (std::isnan(value)) {
+    return "NaN";
+  } else if (std::isinf(value)) {
+    return value > 0 ? "+Inf" : "-Inf";
+  }
+
+  std::ostringstream out;
+  out << std::setprecision(std::numeric_limits<double>::max_digits10)
+      << value;
+  return out.str();
+}
+
+} // namespace {
+
+
+Future<http::Response> MetricsProcess::prometheus(
+    const http::Request& request,
+    const Option<http::authentication::Principal>&)
+{
+  // Parse the 'timeout' parameter.
+  Option<Duration> timeout;
+
+  if (request.url.query.contains("timeout")) {
+    string parameter = request.url.query.get("timeout").get();
+
+    Try<Duration> duration = Duration::parse(parameter);
+
+    if (duration.isError()) {
+      return http::BadRequest(
+          "Invalid timeout '" + parameter + "': " + duration.error() + ".\n");
+    }
+
+    timeout = duration.get();
+  }
+
+  Future<Nothing> acquire = Nothing();
+
+  if (limiter.isSome()) {
+    acquire = limiter.get()->acquire();
+  }
+
+  // The histograms are read right away, only the other values may
+  // need to be computed.
+  map<string, Histogram::Snapshot> histograms;
+
+  foreachpair (const string& name, const Owned<Metric>& metric, metrics) {
+    Option<Histogram::Snapshot> histogram = metric->histogram();
+    if (histogram.isSome()) {
+      histograms[name] = histogram.get();
+    }
+  }
+
+  return acquire.then(defer(self(), &Self::evaluate, timeout))
+    .then([histograms](const map<string, double>& values) -> http::Response {
+      std::ostringstream out;
+
+      // Names that have been exposed, including the samples of the
+      // histograms. Different metrics may have the same sanitized
+      // name, which Prometheus rejects, so all but the first are
+      // skipped. The histograms go first as they expose more names.
+      hashset<string> exposed;
+
+      foreachpair (const string& name,
+                   const Histogram::Snapshot& histogram,
+                   histograms) {
+        const string metric = sanitize(name);
+
+        const string names[] = {
+          metric,
+          metric + "_bucket",
+          metric + "_sum",
+          metric + "_count"};
+
+        bool collides = false;
+        foreach (const string& n, names) {
+          collides = collides || exposed.contains(n);
+        }
+
+        if (collides) {
+          VLOG(1) << "Skipping metric '" << name << "' as its name '"
+                  << metric << "' collides with another metric";
+          continue;
+        }
+
+        foreach (const string& n, names) {
+          exposed.insert(n);
+        }
+
+        if (!histogram.unit.empty()) {
+          out << "# HELP " << metric << " In " << histogram.unit << ".\n";
+        }
+
+        out << "# TYPE " << metric << " histogram\n";
+
+        uint64_t count = 0;
+        for (size_t i = 0; i < histogram.bounds.size(); ++i) {
+          count += histogram.counts[i];
+          out << metric << "_bucket{le=\"" << format(histogram.bounds[i])
+              << "\"} " << count << "\n";
+        }
+
+        // NOTE: We derive the total count from the buckets as the
+        // snapshot of the histogram may be slightly inconsistent.
+        count += histogram.counts.back();
+
+        out << metric << "_bucket{le=\"+Inf\"} " << count << "\n"
+            << metric << "_sum " << format(histogram.sum) << "\n"
+            << metric << "_count " << count << "\n";
+      }
+
+      foreachpair (const string& name, double value, values) {
+        if (histograms.count(name) > 0) {
+          continue;
+        }
+
+        const string metric = sanitize(name);
+
+        if (exposed.contains(metric)) {
+          VLOG(1) << "Skipping metric '" << name << "' as its name '"
+                  << metric << "' collides with another metric";
+          continue;
+        }
+
+        exposed.insert(metric);
+
+        out << "# TYPE " << metric << " untyped\n"
+            << metric << " " << format(value) << "\n";
+      }
+
+      return http::OK(out.str(), "text/plain; version=0.0.4");
+    });
+}
+
+
+Future<map<string, double>> MetricsProcess::_evaluate(
     const Option<Duration>& timeout,
-    hashmap<string, Future<double>>&& metrics,
-    hashmap<string, Option<Statistics<double>>>&& statistics)
+    map<string, double>&& ready,
+    hashmap<string, Future<double>>&& metrics)
 {
-  map<string, double> snapshot;
+  map<string, double> values = std::move(ready);
 
   foreachpair (const string& key, const Future<double>& value, metrics) {
     // TODO(dhamon): Maybe add the failure message for this metric to the
@@ -222,28 +478,14 @@ Future<map<string, double>> MetricsProcess::__snapshot(
       VLOG(1) << "Exceeded timeout of " << timeout.get()
               << " when attempting to get metric '" << key << "'";
     } else if (value.isReady()) {
-      snapshot[key] = value.get();
-    }
-
-    Option<Statistics<double>> statistics_ = statistics.get(key).get();
-
-    if (statistics_.isSome()) {
-      snapshot[key + "/count"] = static_cast<double>(statistics_->count);
-      snapshot[key + "/min"] = statistics_->min;
-      snapshot[key + "/max"] = statistics_->max;
-      snapshot[key + "/p50"] = statistics_->p50;
-      snapshot[key + "/p90"] = statistics_->p90;
-      snapshot[key + "/p95"] = statistics_->p95;
-      snapshot[key + "/p99"] = statistics_->p99;
-      snapshot[key + "/p999"] = statistics_->p999;
-      snapshot[key + "/p9999"] = statistics_->p9999;
+      values[key] = value.get();
     }
   }
 
   // NOTE: Newer compilers (clang-3.9 and gcc-5.1) can perform
   // this move automatically when optimization is on. Once these
   // are the minimum versions, remove this `std::move`.
-  return std::move(snapshot);
+  return std::move(values);
 }
 
 }  // namespace internal {
@@ -30,8 +30,10 @@
 
 #include <process/ssl/flags.hpp>
 
+#include <stout/hashmap.hpp>
 #include <stout/os.hpp>
 #include <stout/strings.hpp>
+#include <stout/synchronized.hpp>
 
 #ifdef __WINDOWS__
 // OpenSSL on Windows requires this adapter module to be compiled as part of the
@@ -159,6 +161,22 @@ Flags::Flags()
       "enable_tls_v1_2",
       "Enable SSLV1.2.",
       true);
+
+  add(&Flags::enable_session_resumption,
+      "enable_session_resumption",
+      "Enable resuming TLS sessions (via session IDs or session tickets) "
+      "in order to skip the full handshake when reconnecting to a peer. "
+      "Clients remember the last session established with each peer "
+      "address and servers keep a session cache.",
+      false);
+
+  add(&Flags::session_ticket_key_file,
+      "session_ticket_key_file",
+      "Path to a file with the keys used to encrypt and decrypt session "
+      "tickets. Servers sharing this file can resume the sessions of each "
+      "other, e.g., a restarted or newly elected master can resume the "
+      "sessions of reconnecting agents. If not set, random keys are "
+      "generated on startup. Only used if session resumption is enabled.");
 }
 
 
@@ -366,6 +384,116 @@ static Try<Nothing> initialize_ecdh_curve(SSL_CTX* ctx, const Flags& ssl_flags)
 }
 #endif // OPENSSL_VERSION_NUMBER >= 0x0090800fL && !OPENSSL_NO_ECDH
 
+
+// The last session established by a client with each peer, see
+// 'resume'. The sessions are owned (i.e., referenced) by the map.
+static std::mutex* sessions_mutex = new std::mutex();
+static hashmap<string, SSL_SESSION*>* sessions =
+  new hashmap<string, SSL_SESSION*>();
+
+// Bounds the number of peers we remember sessions for. Clients rarely
+// talk to more than a handful of peers, so rather than tracking their
+// use we simply start over once the bound is reached.
+static const size_t MAX_CLIENT_SESSIONS = 1024;
+
+// Index of the 'SSL' extra data that holds the peer of a client
+// connection (as a heap allocated string) for 'new_session_callback'.
+static int peer_index = -1;
+
+
+static void free_peer(
+    void* /*parent*/,
+    void* peer,
+    CRYPTO_EX_DATA* /*data*/,
+    int /*index*/,
+    long /*argl*/,
+    void* /*argp*/)
+{
+  delete static_cast<string*>(peer);
+}
+
+
+// Invoked by OpenSSL whenever a connection establishes a session. For
+// TLS 1.3 this happens after the handshake, when the server sends a
+// session ticket, hence we cannot simply ask for the session once
+// the connection is established.
+static int new_session_callback(SSL* ssl, SSL_SESSION* session)
+{
+  const string* peer = static_cast<const string*>(
+      SSL_get_ex_data(ssl, peer_index));
+
+  // Only client connections have a peer, the server sessions are kept
+  // in the internal session cache of the context.
+  if (peer == nullptr) {
+    return 0;
+  }
+
+  synchronized (sessions_mutex) {
+    Option<SSL_SESSION*> previous = sessions->get(*peer);
+
+    if (previous.isSome()) {
+      SSL_SESSION_free(previous.get());
+    } else if (sessions->size() >= MAX_CLIENT_SESSIONS) {
+      foreachvalue (SSL_SESSION* cached, *sessions) {
+        SSL_SESSION_free(cached);
+      }
+      sessions->clear();
+    }
+
+    (*sessions)[*peer] = session;
+  }
+
+  // Returning 1 tells OpenSSL that we took over its reference.
+  return 1;
+}
+
+
+void resume(SSL* ssl, const string& peer)
+{
+  if (!ssl_flags->enable_session_resumption) {
+    return;
+  }
+
+  CHECK_EQ(1, SSL_set_ex_data(ssl, peer_index, new string(peer)));
+
+  synchronized (sessions_mutex) {
+    Option<SSL_SESSION*> session = sessions->get(peer);
+
+    // NOTE: 'SSL_set_session' takes its own reference. If the server
+    // does not accept the session (e.g., it expired) then a full
+    // handshake is done and a new session gets established.
+    if (session.isSome() && SSL_set_session(ssl, session.get()) != 1) {
+      VLOG(1) << "Failed to set session for " << peer << ": "
+              << error_string(ERR_get_error());
+    }
+  }
+}
+
+
+void forget(const SSL* ssl)
+{
+  if (peer_index < 0) {
+    return;
+  }
+
+  const string* peer = static_cast<const string*>(
+      SSL_get_ex_data(const_cast<SSL*>(ssl), peer_index));
+
+  if (peer == nullptr) {
+    return;
+  }
+
+  synchronized (sessions_mutex) {
+    Option<SSL_SESSION*> session = sessions->get(*peer);
+
+    if (session.isSome()) {
+      SSL_SESSION_free(session.get());
+      sessions->erase(*peer);
+    }
+  }
+}
+
+
 // Tests can declare this function and use it to re-configure the SSL
 // environment variables programatically. Without explicitly declaring
 // this function, it is not visible. This is the preferred behavior as
@@ -457,18 +585,65 @@ void reinitialize()
     ctx = nullptr;
   }
 
+  // The sessions of the previous context can not be resumed anymore.
+  synchronized (sessions_mutex) {
+    foreachvalue (SSL_SESSION* session, *sessions) {
+      SSL_SESSION_free(session);
+    }
+    sessions->clear();
+  }
+
   // Replace with `TLS_method` once our minimum OpenSSL version
   // supports it.
   ctx = SSL_CTX_new(SSLv23_method());
   CHECK(ctx) << "Failed to create SSL context: "
              << ERR_error_string(ERR_get_error(), nullptr);
 
-  // Disable SSL session caching.
-  SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  if (ssl_flags->enable_session_resumption) {
+    // Servers look up sessions in the internal cache (or decrypt them
+    // from the session tickets), while clients hand their sessions
+    // to 'new_session_callback' and pick them in 'resume'.
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH);
+    SSL_CTX_sess_set_new_cb(ctx, &new_session_callback);
+
+    if (peer_index < 0) {
+      peer_index =
+        SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, &free_peer);
+      CHECK_GE(peer_index, 0);
+    }
+
+    if (ssl_flags->session_ticket_key_file.isSome()) {
+      const string& path = ssl_flags->session_ticket_key_file.get();
+
+      Try<string> keys = os::read(path);
+      if (keys.isError()) {
+        EXIT(EXIT_FAILURE)
+          << "Failed to read session ticket keys from '" << path << "': "
+          << keys.error();
+      }
+
+      // The size of the keys depends on the OpenSSL version, which
+      // returns it when passing no keys.
+      const long size = SSL_CTX_set_tlsext_ticket_keys(ctx, nullptr, 0);
+
+      if (keys->size() != static_cast<size_t>(size) ||
+          SSL_CTX_set_tlsext_ticket_keys(
+              ctx,
+              const_cast<char*>(keys->data()),
+              size) != 1) {
+        EXIT(EXIT_FAILURE)
+          << "Invalid session ticket keys in '" << path << "': expected "
+          << size << " bytes but found " << keys->size();
+      }
+    }
+  } else {
+    // Disable SSL session caching.
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+  }
 
   // Set a session id to avoid connection termination upon
-  // re-connect. We can use something more relevant when we care
-  // about session caching.
+  // re-connect. This is also required for resuming sessions when
+  // peer certificates are verified.
   const uint64_t session_ctx = 7;
 
   const unsigned char* session_id =
@@ -52,6 +52,8 @@ namespace openssl {
 //    LIBPROCESS_SSL_ENABLE_TLS_V1_1=(false|0,true|1)
 //    LIBPROCESS_SSL_ENABLE_TLS_V1_2=(false|0,true|1)
 //    LIBPROCESS_SSL_ECDH_CURVES=(auto|list of curves separated by ':')
+//    LIBPROCESS_SSL_ENABLE_SESSION_RESUMPTION=(false|0,true|1)
+//    LIBPROCESS_SSL_SESSION_TICKET_KEY_FILE=(path to session ticket keys)
 //
 // TODO(benh): When/If we need to support multiple contexts in the
 // same process, for example for Server Name Indication (SNI), then
@@ -63,6 +65,16 @@ void initialize();
 // Returns the _global_ OpenSSL context.
 SSL_CTX* context();
 
+// Prepares the client connection 'ssl' to resume the session last
+// established with 'peer' (e.g., the address connected to), and to
+// remember the session it establishes for the next connection. Does
+// nothing unless session resumption is enabled.
+void resume(SSL* ssl, const std::string& peer);
+
+// Forgets the session remembered for the peer of the client connection
+// 'ssl', e.g., because the peer failed verification.
+void forget(const SSL* ssl);
+
 // Verify that the hostname is properly associated with the peer
 // certificate associated with the specified SSL connection.
 Try<Nothing> verify(
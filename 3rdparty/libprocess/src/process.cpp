@@ -85,8 +85,12 @@
 #include <process/system.hpp>
 #include <process/time.hpp>
 #include <process/timer.hpp>
+#include <process/trace.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
+#include <process/metrics/pull_gauge.hpp>
+#include <process/metrics/push_gauge.hpp>
 
 #include <process/ssl/flags.hpp>
 
@@ -116,11 +120,13 @@
 #include "event_loop.hpp"
 #include "event_queue.hpp"
 #include "gate.hpp"
+#include "http_connection_pool.hpp"
 #include "http_proxy.hpp"
 #include "memory_profiler.hpp"
 #include "process_reference.hpp"
 #include "socket_manager.hpp"
 #include "run_queue.hpp"
+#include "trace.hpp"
 
 namespace inet = process::network::inet;
 namespace inet4 = process::network::inet4;
@@ -250,6 +256,17 @@ struct Flags : public virtual flags::FlagsBase
         "which libprocess connects to other actors.\n",
         false);
 
+    add(&Flags::enable_message_framing,
+        "enable_message_framing",
+        "If set, messages to other libprocess instances that also enable\n"
+        "this are sent using a compact binary framing rather than as\n"
+        "HTTP requests, which is cheaper to encode and decode. Peers\n"
+        "advertise support on the messages they send, so messages to\n"
+        "instances that don't support the framing continue to use HTTP.\n"
+        "Framed connections from other instances are only accepted if\n"
+        "this is set.\n",
+        false);
+
     // TODO(bevers): Set the default to `true` after gathering some
     // real-world experience with this.
     add(&Flags::memory_profiling,
@@ -265,6 +282,7 @@ struct Flags : public virtual flags::FlagsBase
   Option<int> port;
   Option<int> advertise_port;
   bool require_peer_address_ip_match;
+  bool enable_message_framing;
   bool memory_profiling;
 };
 
@@ -354,12 +372,12 @@ public:
 
   // Prevents any further processes from spawning and terminates all
   // running processes. Then joins all processing threads and stops
-  // the event loop.
+  // the event loops.
   //
   // This is a prerequisite for finalizing the `SocketManager`.
   void finalize();
 
-  // Initializes the processing threads and the event loop thread,
+  // Initializes the processing threads and the event loop threads,
   // and returns the number of processing threads created.
   long init_threads();
 
@@ -419,8 +437,8 @@ public:
 
   long workers() const
   {
-    // Less 1 for event loop thread.
-    return static_cast<long>(threads.size() - 1);
+    // Less the event loop threads.
+    return static_cast<long>(threads.size() - EventLoop::count());
   }
 
 private:
@@ -460,6 +478,14 @@ private:
   // testing).
   std::atomic<Filter*> filter = ATOMIC_VAR_INIT(nullptr);
   std::recursive_mutex filter_mutex;
+
+  // The quantum of a process, i.e., the maximum number of events and
+  // the maximum amount of time that a process may spend serving
+  // events each time it gets resumed before it yields to the other
+  // runnable processes. If none, a process serves events until its
+  // event queue is empty. See `ProcessManager::resume`.
+  Option<size_t> max_events_per_resume;
+  Option<Duration> max_resume_duration;
 };
 
 
@@ -473,6 +499,214 @@ static std::atomic_bool initialize_complete(false);
 // Server socket listen backlog.
 static const int LISTEN_BACKLOG = 500000;
 
+// Scheduling statistics across all processes, exposed as metrics.
+// See `ProcessManager::resume`.
+static std::atomic<uint64_t> resumes(0);
+static std::atomic<uint64_t> events_served(0);
+static std::atomic<uint64_t> preemptions(0);
+
+
+// Accounting of how a process queues and serves its events. The
+// queue depth is updated by the threads enqueueing events, all other
+// fields are only accessed while the process is running.
+//
+// Additionally, the totals are aggregated across all processes with
+// the same name, i.e., the ID without the "(N)" suffix added by
+// `ID::generate`, and exposed as metrics. This keeps the number of
+// metrics bounded by the number of kinds of processes.
+struct ProcessProfile
+{
+  struct Metrics
+  {
+    explicit Metrics(const string& name)
+      : queued("libprocess/processes/" + name + "/event_queue_depth"),
+        events("libprocess/processes/" + name + "/events_served"),
+        waited("libprocess/processes/" + name + "/event_wait_time_us"),
+        served("libprocess/processes/" + name + "/event_serve_time_us") {}
+
+    process::metrics::PushGauge queued;
+    process::metrics::Counter events;
+    process::metrics::Counter waited;
+    process::metrics::Counter served;
+  };
+
+  // Time spent serving events of one kind, i.e., messages with the
+  // same name, or dispatches, HTTP requests, etc.
+  //
+  // NOTE: Only messages with an installed handler get a slot of their
+  // own, all other messages are accounted to `unknown`. Otherwise any
+  // peer could grow the profile by sending messages with new names.
+  struct Handler
+  {
+    uint64_t count = 0;
+    std::chrono::nanoseconds total = std::chrono::nanoseconds::zero();
+    std::chrono::nanoseconds max = std::chrono::nanoseconds::zero();
+  };
+
+  // Returns the metrics shared by all processes named 'name', which
+  // get added when the first process with this name is spawned.
+  static std::shared_ptr<Metrics> aggregate(const string& name)
+  {
+    static std::mutex* mutex = new std::mutex();
+    static hashmap<string, std::shared_ptr<Metrics>>* all =
+      new hashmap<string, std::shared_ptr<Metrics>>();
+
+    synchronized (mutex) {
+      if (!all->contains(name)) {
+        std::shared_ptr<Metrics> metrics(new Metrics(name));
+
+        process::metrics::add(metrics->queued);
+        process::metrics::add(metrics->events);
+        process::metrics::add(metrics->waited);
+        process::metrics::add(metrics->served);
+
+        all->put(name, metrics);
+      }
+
+      return all->at(name);
+    }
+  }
+
+  // Records that an event was enqueued.
+  void enqueued()
+  {
+    uint64_t depth = queued.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    uint64_t max = maxQueued.load(std::memory_order_relaxed);
+    while (depth > max && !maxQueued.compare_exchange_weak(max, depth)) {}
+
+    if (metrics) {
+      ++metrics->queued;
+    }
+  }
+
+  // Records that 'count' events were dequeued.
+  void dequeued(uint64_t count)
+  {
+    queued.fetch_sub(count, std::memory_order_relaxed);
+
+    if (metrics) {
+      metrics->queued -= count;
+    }
+  }
+
+  // Adds a slot for the messages named 'name', called when a message
+  // handler gets installed.
+  void installed(const string& name)
+  {
+    if (!messages.contains(name)) {
+      messages.put(name, Handler());
+    }
+  }
+
+  // Returns the slot to account 'event' to and sets 'name' to the
+  // name of the message or the kind of the event.
+  Handler& handler(const Event& event, const string** name)
+  {
+    static const string DISPATCH = "dispatch";
+    static const string HTTP = "http";
+    static const string EXITED = "exited";
+    static const string TERMINATE = "terminate";
+
+    struct HandlerVisitor : EventVisitor
+    {
+      explicit HandlerVisitor(ProcessProfile* _profile)
+        : profile(_profile), handler(&_profile->dispatch) {}
+
+      void visit(const MessageEvent& event) override
+      {
+        name = &event.message.name;
+
+        auto iterator = profile->messages.find(event.message.name);
+        handler = iterator != profile->messages.end()
+          ? &iterator->second
+          : &profile->unknown;
+      }
+
+      void visit(const DispatchEvent&) override
+      {
+        name = &DISPATCH;
+        handler = &profile->dispatch;
+      }
+
+      void visit(const HttpEvent&) override
+      {
+        name = &HTTP;
+        handler = &profile->http;
+      }
+
+      void visit(const ExitedEvent&) override
+      {
+        name = &EXITED;
+        handler = &profile->exited;
+      }
+
+      void visit(const TerminateEvent&) override
+      {
+        name = &TERMINATE;
+        handler = &profile->terminate;
+      }
+
+      ProcessProfile* profile;
+      Handler* handler;
+      const string* name = &DISPATCH;
+    } visitor(this);
+
+    event.visit(&visitor);
+
+    *name = visitor.name;
+    return *visitor.handler;
+  }
+
+  // Returns the slots with at least one served event, keyed by the
+  // name of the message or the kind of the event.
+  std::map<string, Handler> handlers() const
+  {
+    std::map<string, Handler> result;
+
+    foreachpair (const string& name, const Handler& handler, messages) {
+      if (handler.count > 0) {
+        result[name] = handler;
+      }
+    }
+
+    const std::pair<const char*, const Handler*> kinds[] = {
+      {"dispatch", &dispatch},
+      {"http", &http},
+      {"exited", &exited},
+      {"terminate", &terminate},
+      {"unknown", &unknown}};
+
+    for (const auto& kind : kinds) {
+      if (kind.second->count > 0) {
+        result[kind.first] = *kind.second;
+      }
+    }
+
+    return result;
+  }
+
+  std::atomic<uint64_t> queued = ATOMIC_VAR_INIT(0);
+  std::atomic<uint64_t> maxQueued = ATOMIC_VAR_INIT(0);
+
+  uint64_t events = 0;
+  std::chrono::nanoseconds waited = std::chrono::nanoseconds::zero();
+  std::chrono::nanoseconds maxWaited = std::chrono::nanoseconds::zero();
+
+  // NOTE: Slots are only ever added, so references to them stay valid.
+  hashmap<string, Handler> messages;
+  Handler dispatch;
+  Handler http;
+  Handler exited;
+  Handler terminate;
+  Handler unknown;
+
+  // The metrics of all processes with the same name. Not set for the
+  // processes spawned while initializing libprocess, as metrics can't
+  // be added yet.
+  std::shared_ptr<Metrics> metrics;
+};
+
 // Local server socket.
 static Socket* __s__ = nullptr;
 
@@ -520,6 +754,9 @@ static std::mutex* authorization_callbacks_mutex = new std::mutex();
 // Global route that returns process information.
 static Route* processes_route = nullptr;
 
+// Route providing the recorded trace spans.
+static Route* trace_route = nullptr;
+
 // Global help.
 PID<Help> help;
 
@@ -747,6 +984,13 @@ static Future<MessageEvent*> parse(const Request& request)
     return Failure("Failed to determine sender from request headers");
   }
 
+  // Remember peers that can receive framed messages so that new
+  // connections to them can use the framing.
+  if (libprocess_flags->enable_message_framing &&
+      request.headers.contains("Libprocess-Framing")) {
+    socket_manager->framing(from->address);
+  }
+
   // Check that URL path is present and starts with '/'.
   if (request.url.path.find('/') != 0) {
     return Failure("Request URL path must start with '/'");
@@ -849,6 +1093,104 @@ void decode_recv(
     .onAny(lambda::bind(&decode_recv, lambda::_1, data, size, socket, decoder));
 }
 
+
+void decode_frames(
+    const Future<size_t>& length,
+    char* data,
+    size_t size,
+    Socket socket,
+    FrameDecoder* decoder)
+{
+  if (length.isDiscarded() || length.isFailed()) {
+    if (length.isFailed()) {
+      VLOG(1) << "Decode failure: " << length.failure();
+    }
+
+    socket_manager->close(socket);
+    delete[] data;
+    delete decoder;
+    return;
+  }
+
+  if (length.get() == 0) {
+    socket_manager->close(socket);
+    delete[] data;
+    delete decoder;
+    return;
+  }
+
+  // Decode as much of the data as possible into messages.
+  deque<Message> messages = decoder->decode(data, length.get());
+
+  if (!messages.empty()) {
+    Try<Address> address = socket.peer();
+
+    if (address.isError()) {
+      VLOG(1) << "Failed to get peer address while receiving: "
+              << address.error();
+      socket_manager->close(socket);
+      delete[] data;
+      delete decoder;
+      return;
+    }
+
+    foreach (Message& message, messages) {
+      message.to.address = __address__;
+
+      // Verify that the UPID this peer is claiming is on the same IP
+      // address the peer is sending from. There is no response to
+      // report the failure with so the message is just dropped.
+      if (libprocess_flags->require_peer_address_ip_match &&
+          message.from.address.ip != address->ip) {
+        VLOG(1) << "Dropping libprocess message from " << message.from
+                << " sent from IP " << address.get()
+                << ": UPID IP address validation failed";
+        continue;
+      }
+
+      const UPID to = message.to;
+      if (!process_manager->deliver(to, new MessageEvent(std::move(message)))) {
+        VLOG(1) << "Failed to deliver libprocess message to " << to;
+      }
+    }
+  }
+
+  // The frames decoded before a malformed one have been delivered
+  // above, but the stream can't be resynchronized past the failure.
+  if (decoder->failed()) {
+    VLOG(1) << "Decoder error while receiving frames";
+    socket_manager->close(socket);
+    delete[] data;
+    delete decoder;
+    return;
+  }
+
+  socket.recv(data, size)
+    .onAny(lambda::bind(
+        &decode_frames, lambda::_1, data, size, socket, decoder));
+}
+
+
+// Receives the first data of an accepted connection to determine
+// whether the peer is sending framed messages or HTTP requests. When
+// framing is disabled every connection is decoded as HTTP, which
+// rejects the framing preface.
+void detect_recv(
+    const Future<size_t>& length,
+    char* data,
+    size_t size,
+    Socket socket)
+{
+  if (libprocess_flags->enable_message_framing &&
+      length.isReady() &&
+      length.get() > 0 &&
+      data[0] == FRAMING_PREFACE[0]) {
+    decode_frames(length, data, size, socket, new FrameDecoder());
+  } else {
+    decode_recv(length, data, size, socket, new StreamingRequestDecoder());
+  }
+}
+
 } // namespace internal {
 
 
@@ -912,16 +1254,13 @@ void on_accept(const Future<Socket>& socket)
     const size_t size = 80 * 1024;
     char* data = new char[size];
 
-    StreamingRequestDecoder* decoder = new StreamingRequestDecoder();
-
     socket->recv(data, size)
       .onAny(lambda::bind(
-          &internal::decode_recv,
+          &internal::detect_recv,
           lambda::_1,
           data,
           size,
-          socket.get(),
-          decoder));
+          socket.get()));
   }
 
   // NOTE: `__s__` may be cleaned up during `process::finalize`.
@@ -981,6 +1320,41 @@ void reinitialize(
 }
 
 
+// Returns the number of event loop threads to run. All socket I/O
+// (accepting, reading, writing, SSL handshakes) is performed by the
+// event loop threads, each socket being pinned to a single event loop
+// by its file descriptor. A single event loop thread is used unless
+// the operator sets `LIBPROCESS_NUM_EVENT_LOOP_THREADS`, which is
+// useful when one thread can no longer keep up with the network I/O
+// of a process with many connections (e.g., a master in a large
+// cluster).
+static size_t event_loop_threads()
+{
+  size_t num_event_loop_threads = 1;
+
+  constexpr char env_var[] = "LIBPROCESS_NUM_EVENT_LOOP_THREADS";
+  Option<string> value = os::getenv(env_var);
+  if (value.isSome()) {
+    constexpr long maxval = 128;
+    Try<long> number = numify<long>(value->c_str());
+    if (number.isSome() && number.get() > 0L && number.get() <= maxval) {
+      VLOG(1) << "Overriding default number of event loop threads "
+              << num_event_loop_threads << ", using the value "
+              << env_var << "=" << number.get() << " instead";
+      num_event_loop_threads = number.get();
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << value.get()
+                   << " for " << env_var
+                   << ", using default value " << num_event_loop_threads
+                   << ". Valid values are integers in the range 1 to "
+                   << maxval;
+    }
+  }
+
+  return num_event_loop_threads;
+}
+
+
 bool initialize(
     const Option<string>& delegate,
     const Option<string>& readwriteAuthenticationRealm,
@@ -1066,8 +1440,8 @@ bool initialize(
   process_manager = new ProcessManager(delegate);
   socket_manager = new SocketManager();
 
-  // Initialize the event loop.
-  EventLoop::initialize();
+  // Initialize the event loop(s).
+  EventLoop::initialize(event_loop_threads());
 
   // Setup processing threads.
   long num_worker_threads = process_manager->init_threads();
@@ -1212,6 +1586,19 @@ bool initialize(
       metrics::internal::MetricsProcess::create(readonlyAuthenticationRealm),
       true);
 
+  // Expose the scheduling statistics of the worker threads.
+  metrics::add(metrics::PullGauge(
+      "libprocess/resumes",
+      []() -> Future<double> { return resumes.load(); }));
+
+  metrics::add(metrics::PullGauge(
+      "libprocess/events_served",
+      []() -> Future<double> { return events_served.load(); }));
+
+  metrics::add(metrics::PullGauge(
+      "libprocess/preemptions",
+      []() -> Future<double> { return preemptions.load(); }));
+
   // Create the global logging process.
   _logging = spawn(new Logging(readwriteAuthenticationRealm), true);
 
@@ -1234,6 +1621,10 @@ bool initialize(
   process::internal::reaper =
     spawn(new process::internal::ReaperProcess(), true);
 
+  // Create the global HTTP connection pool.
+  http::internal::pool =
+    spawn(new http::internal::ConnectionPoolProcess(), true);
+
   // Create the global job object manager process.
 #ifdef __WINDOWS__
   process::internal::job_object_manager =
@@ -1249,6 +1640,10 @@ bool initialize(
 
   processes_route = new Route("/__processes__", None(), __processes__);
 
+  trace_route = new Route("/__trace__", None(), [](const Request&) {
+    return OK(trace::internal::dump());
+  });
+
   VLOG(1) << "libprocess is initialized on " << address() << " with "
           << num_worker_threads << " worker threads";
 
@@ -1273,6 +1668,9 @@ void finalize(bool finalize_wsa)
   delete processes_route;
   processes_route = nullptr;
 
+  delete trace_route;
+  trace_route = nullptr;
+
   // Close the server socket.
   // This will prevent any further connections managed by the `SocketManager`.
   synchronized (socket_mutex) {
@@ -1524,6 +1922,8 @@ void SocketManager::link_connect(
     return;
   }
 
+  bool preface = false;
+
   synchronized (mutex) {
     // It is possible that a prior call to `link()` with `RECONNECT`
     // semantics has swapped out this socket before we finished
@@ -1533,6 +1933,8 @@ void SocketManager::link_connect(
       return;
     }
 
+    preface = framed.contains(socket);
+
     size_t size = 80 * 1024;
     char* data = new char[size];
 
@@ -1556,7 +1958,12 @@ void SocketManager::link_connect(
   // SocketManager::next() the 'outgoing' queue will get removed and
   // any subsequent call to SocketManager::send() will take care of
   // setting it back up and sending.
-  Encoder* encoder = socket_manager->next(socket);
+  //
+  // A framed socket first sends the preface, after which sending
+  // continues with whatever is in the 'outgoing' queue.
+  Encoder* encoder = preface
+    ? new DataEncoder(string(FRAMING_PREFACE, FRAMING_PREFACE_LENGTH))
+    : socket_manager->next(socket);
 
   if (encoder != nullptr) {
     internal::send(encoder, socket);
@@ -1614,6 +2021,8 @@ void SocketManager::link(
 
         persists.emplace(to.address, s);
 
+        framed_connect(s, to.address);
+
         // Initialize 'outgoing' to prevent a race with
         // SocketManager::send() while the socket is not yet connected.
         // Initializing the 'outgoing' queue prevents
@@ -1943,7 +2352,19 @@ void SocketManager::send_connect(
     return;
   }
 
-  Encoder* encoder = new MessageEncoder(message);
+  Encoder* encoder = nullptr;
+
+  synchronized (mutex) {
+    if (framed.contains(socket)) {
+      // This is the first data on the connection so it also carries
+      // the preface.
+      encoder = new DataEncoder(
+          string(FRAMING_PREFACE, FRAMING_PREFACE_LENGTH) +
+          FrameEncoder::encode(message));
+    } else {
+      encoder = encode(socket, message);
+    }
+  }
 
   // Receive and ignore data from this socket. Note that we don't
   // expect to receive anything other than HTTP '202 Accepted'
@@ -1968,6 +2389,7 @@ void SocketManager::send(Message&& message, const SocketImpl::Kind& kind)
   const Address& address = message.to.address;
 
   Option<Socket> socket = None();
+  Encoder* encoder = nullptr;
   bool connect = false;
 
   synchronized (mutex) {
@@ -1985,8 +2407,10 @@ void SocketManager::send(Message&& message, const SocketImpl::Kind& kind)
         dispose.insert(socket.get());
       }
 
+      encoder = encode(socket.get(), message);
+
       if (outgoing.count(socket.get()) > 0) {
-        outgoing[socket.get()].push(new MessageEncoder(message));
+        outgoing[socket.get()].push(encoder);
         return;
       } else {
         // Initialize the outgoing queue.
@@ -2017,6 +2441,8 @@ void SocketManager::send(Message&& message, const SocketImpl::Kind& kind)
 
       dispose.insert(s);
 
+      framed_connect(s, address);
+
       // Initialize the outgoing queue.
       outgoing[s];
 
@@ -2036,11 +2462,43 @@ void SocketManager::send(Message&& message, const SocketImpl::Kind& kind)
   } else {
     // If we're not connecting and we haven't added the encoder to
     // the 'outgoing' queue then schedule it to be sent.
-    internal::send(new MessageEncoder(message), socket.get());
+    internal::send(CHECK_NOTNULL(encoder), socket.get());
+  }
+}
+
+
+void SocketManager::framing(const Address& address)
+{
+  synchronized (framing_mutex) {
+    framing_peers.insert(address);
   }
 }
 
 
+void SocketManager::framed_connect(int_fd s, const Address& address)
+{
+  if (!libprocess_flags->enable_message_framing) {
+    return;
+  }
+
+  synchronized (framing_mutex) {
+    if (framing_peers.contains(address)) {
+      framed.insert(s);
+    }
+  }
+}
+
+
+Encoder* SocketManager::encode(int_fd s, const Message& message)
+{
+  if (framed.contains(s)) {
+    return new FrameEncoder(message);
+  }
+
+  return new MessageEncoder(message, libprocess_flags->enable_message_framing);
+}
+
+
 Encoder* SocketManager::next(int_fd s)
 {
   HttpProxy* proxy = nullptr; // Non-null if needs to be terminated.
@@ -2063,10 +2521,8 @@ Encoder* SocketManager::next(int_fd s)
       CHECK(outgoing.count(s) > 0);
 
       if (!outgoing[s].empty()) {
-        // More messages!
-        Encoder* encoder = outgoing[s].front();
-        outgoing[s].pop();
-        return encoder;
+        // More messages! Send any subsequently queued data along.
+        return coalesce(&outgoing[s]);
       } else {
         // No more messages ... erase the outgoing queue.
         outgoing.erase(s);
@@ -2155,9 +2611,19 @@ void SocketManager::close(int_fd s)
       // Clean up after sockets used for remote communication.
       Option<Address> address = addresses.get(s);
       if (address.isSome()) {
+        // A lost framed link (persistent or temporary) may mean the
+        // peer was restarted without framing support, so go back to
+        // HTTP until the peer advertises support again.
+        if (framed.contains(s)) {
+          synchronized (framing_mutex) {
+            framing_peers.erase(address.get());
+          }
+        }
+
         // Don't bother invoking `exited` unless socket was persistent.
         if (persists.count(address.get()) > 0 && persists[address.get()] == s) {
           persists.erase(address.get());
+
           exited(address.get()); // Generate ExitedEvent(s)!
         } else if (temps.count(address.get()) > 0 &&
                    temps[address.get()] == s) {
@@ -2174,6 +2640,7 @@ void SocketManager::close(int_fd s)
       }
 
       dispose.erase(s);
+      framed.erase(s);
       auto iterator = sockets.find(s);
 
       // We need to stop any 'ignore_data' receivers as they may have
@@ -2382,6 +2849,13 @@ void SocketManager::swap_implementing_socket(
     outgoing[to_fd] = std::move(outgoing[from_fd]);
     outgoing.erase(from_fd);
 
+    // The queued encoders match the framing of the old socket, so the
+    // new socket keeps using it.
+    if (framed.contains(from_fd)) {
+      framed.insert(to_fd);
+      framed.erase(from_fd);
+    }
+
     // Update the fd any proxies are associated with.
     if (proxies.count(from_fd) > 0) {
       proxies[to_fd] = proxies[from_fd];
@@ -2488,12 +2962,64 @@ long ProcessManager::init_threads()
     }
   }
 
+  // We also allow the operator to bound the number of events and the
+  // amount of time a process may spend serving events before it has
+  // to yield the worker thread to other runnable processes. This
+  // keeps a busy process (e.g., the master) from starving the other
+  // processes while still amortizing the cost of scheduling it.
+  constexpr char events_env_var[] = "LIBPROCESS_MAX_EVENTS_PER_RESUME";
+  value = os::getenv(events_env_var);
+  if (value.isSome()) {
+    Try<size_t> number = numify<size_t>(value->c_str());
+    if (number.isSome() && number.get() > 0) {
+      VLOG(1) << "Limiting processes to " << number.get()
+              << " events per resume";
+      max_events_per_resume = number.get();
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << value.get()
+                   << " for " << events_env_var
+                   << ". Valid values are positive integers";
+    }
+  }
+
+  constexpr char duration_env_var[] = "LIBPROCESS_MAX_RESUME_DURATION";
+  value = os::getenv(duration_env_var);
+  if (value.isSome()) {
+    Try<Duration> duration = Duration::parse(value.get());
+    if (duration.isSome() && duration.get() > Duration::zero()) {
+      VLOG(1) << "Limiting processes to " << duration.get()
+              << " per resume";
+      max_resume_duration = duration.get();
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << value.get()
+                   << " for " << duration_env_var
+                   << ". Valid values are positive durations, e.g., 1ms";
+    }
+  }
+
+  // Tracing is disabled by default. The buffer size bounds the number
+  // of spans kept per worker thread (see `process/trace.hpp`).
+  constexpr char trace_env_var[] = "LIBPROCESS_TRACE_BUFFER_SIZE";
+  value = os::getenv(trace_env_var);
+  if (value.isSome()) {
+    Try<size_t> number = numify<size_t>(value->c_str());
+    if (number.isSome()) {
+      VLOG(1) << "Keeping up to " << number.get()
+              << " trace spans per thread";
+      trace::internal::enable(number.get());
+    } else {
+      LOG(WARNING) << "Ignoring invalid value " << value.get()
+                   << " for " << trace_env_var
+                   << ". Valid values are non-negative integers";
+    }
+  }
+
   if (runq.capacity() < (size_t) num_worker_threads) {
     EXIT(EXIT_FAILURE) << "Number of worker threads can not exceed "
                        << runq.capacity() << " at this time";
   }
 
-  threads.reserve(num_worker_threads + 1);
+  threads.reserve(num_worker_threads + EventLoop::count());
 
   // Create processing threads.
   for (long i = 0; i < num_worker_threads; i++) {
@@ -2520,8 +3046,10 @@ long ProcessManager::init_threads()
         }));
   }
 
-  // Create a thread for the event loop.
-  threads.emplace_back(new std::thread(&EventLoop::run));
+  // Create a thread for each event loop.
+  for (size_t i = 0; i < EventLoop::count(); i++) {
+    threads.emplace_back(new std::thread(&EventLoop::run, i));
+  }
 
   return num_worker_threads;
 }
@@ -2819,6 +3347,21 @@ UPID ProcessManager::spawn(ProcessBase* process, bool manage)
       << "Attempted to spawn a process (" << process->self()
       << ") that has already been initialized";
   } else {
+    // Aggregate the profile of this process with all processes of the
+    // same name, except while initializing when the metrics process
+    // may not yet be running. Internal processes (e.g., `__latch__`)
+    // are skipped as they are spawned often enough for the global
+    // lock in `ProcessProfile::aggregate` to matter.
+    if (initialize_complete.load()) {
+      const string& id = process->pid.id;
+      string name = id.substr(0, id.find('('));
+      if (!name.empty() &&
+          !(strings::startsWith(name, "__") &&
+            strings::endsWith(name, "__"))) {
+        process->profile->metrics = ProcessProfile::aggregate(name);
+      }
+    }
+
     synchronized (processes_mutex) {
       if (processes.count(process->pid.id) > 0) {
         LOG(WARNING)
@@ -2907,7 +3450,29 @@ void ProcessManager::resume(ProcessBase* process)
   // we set the state to BLOCKED (see the comment below).
   ProcessReference reference = process->reference;
 
-  while (!terminate && !blocked) {
+  // Whether the process exhausted its quantum while it still had
+  // events queued, in which case it yields to other processes by
+  // getting put back into the run queue (see below).
+  bool yielded = false;
+
+  // Number of events served during this resume.
+  size_t served = 0;
+
+  // Number of events dequeued (served, filtered or purged) and the
+  // time spent waiting and serving during this resume.
+  uint64_t dequeued = 0;
+  std::chrono::nanoseconds waited = std::chrono::nanoseconds::zero();
+  std::chrono::nanoseconds serving = std::chrono::nanoseconds::zero();
+
+  // The time of the start of this resume and of the end of the last
+  // served event, which is also used as the start of the next one so
+  // that each event only reads the clock once.
+  const std::chrono::steady_clock::time_point resumed =
+    std::chrono::steady_clock::now();
+
+  std::chrono::steady_clock::time_point now = resumed;
+
+  while (!terminate && !blocked && !yielded) {
     Event* event = nullptr;
 
     // NOTE: the event queue requires only a _single_ consumer at a
@@ -2916,6 +3481,7 @@ void ProcessManager::resume(ProcessBase* process)
 
     if (!process->events->consumer.empty()) {
       event = process->events->consumer.dequeue();
+      ++dequeued;
     } else {
       // We now transition the process to BLOCKED. It's possible that
       // events get enqueued while we're still in the READY state.
@@ -2964,6 +3530,7 @@ void ProcessManager::resume(ProcessBase* process)
           delete event;
           event = process->events->consumer.dequeue();
           CHECK_NOTNULL(event);
+          ++dequeued;
         }
       }
 
@@ -2994,11 +3561,31 @@ void ProcessManager::resume(ProcessBase* process)
       // Determine if we should terminate.
       terminate = event->is<TerminateEvent>();
 
+      // NOTE: The handler stays valid as handlers are never removed.
+      const string* name = nullptr;
+      ProcessProfile::Handler& handler =
+        process->profile->handler(*event, &name);
+
+      Option<trace::internal::Span> span;
+      if (trace::internal::enabled()) {
+        span = trace::internal::Span(*name, process->pid, *event);
+      }
+
+      const std::chrono::steady_clock::time_point start = now;
+
+      // The event may have been enqueued after the end of the last
+      // served event, i.e., after `start`.
+      const std::chrono::nanoseconds wait = std::max(
+          std::chrono::nanoseconds::zero(),
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              start - event->enqueued));
+
       // Now service the event. In the event that the process
       // throws an exception, we will abort the program.
       //
       // TODO(bmahler): Consider providing recovery mechanisms.
       try {
+        trace::Scope scope(span.isSome() ? span->id : 0);
         process->serve(std::move(*event));
       } catch (const std::exception& e) {
         LOG(FATAL) << "Aborting libprocess: '" << process->pid << "'"
@@ -3008,10 +3595,70 @@ void ProcessManager::resume(ProcessBase* process)
                    << " threw unknown exception";
       }
 
+      now = std::chrono::steady_clock::now();
+
+      const std::chrono::nanoseconds elapsed = now - start;
+
+      if (span.isSome()) {
+        span->start = start;
+        span->duration = elapsed;
+        trace::internal::record(std::move(span.get()));
+      }
+
+      handler.count++;
+      handler.total += elapsed;
+      handler.max = std::max(handler.max, elapsed);
+
+      process->profile->maxWaited =
+        std::max(process->profile->maxWaited, wait);
+
+      waited += wait;
+      serving += elapsed;
+
       delete event;
+
+      ++served;
+
+      // Yield if this process has exhausted its quantum and has more
+      // events to serve. Note that the process stays READY so that
+      // any events enqueued in the meantime won't enqueue it again.
+      if (!terminate &&
+          ((max_events_per_resume.isSome() &&
+            served >= max_events_per_resume.get()) ||
+           (max_resume_duration.isSome() &&
+            now - resumed >= std::chrono::nanoseconds(
+                max_resume_duration->ns()))) &&
+          !process->events->consumer.empty()) {
+        yielded = true;
+      }
     }
   }
 
+  process->scheduling.resumes++;
+  process->scheduling.events += served;
+
+  process->profile->events += served;
+  process->profile->waited += waited;
+  process->profile->dequeued(dequeued);
+
+  if (process->profile->metrics) {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    ProcessProfile::Metrics& metrics = *process->profile->metrics;
+    metrics.events += served;
+    metrics.waited += duration_cast<microseconds>(waited).count();
+    metrics.served += duration_cast<microseconds>(serving).count();
+  }
+
+  resumes.fetch_add(1, std::memory_order_relaxed);
+  events_served.fetch_add(served, std::memory_order_relaxed);
+
+  if (yielded) {
+    process->scheduling.preemptions++;
+    preemptions.fetch_add(1, std::memory_order_relaxed);
+  }
+
   // Clear the reference before we cleanup!
   reference = ProcessReference();
 
@@ -3027,6 +3674,13 @@ void ProcessManager::resume(ProcessBase* process)
   if (terminate && manage) {
     delete process;
   }
+
+  // Put the process back into the run queue if it yielded. This must
+  // be done last since another worker may start running the process
+  // immediately.
+  if (yielded) {
+    enqueue(process);
+  }
 }
 
 
@@ -3054,6 +3708,8 @@ void ProcessManager::cleanup(ProcessBase* process)
 
   process->events->consumer.decomission();
 
+  process->profile->dequeued(process->profile->queued.load());
+
   // Remove help strings for all installed routes for this process.
   dispatch(help, &Help::remove, process->pid.id);
 
@@ -3191,7 +3847,9 @@ bool ProcessManager::wait(const UPID& pid)
         // Try and extract the process from the run queue. This may
         // fail because another thread might resume the process first
         // or the run queue might not support arbitrary extraction.
-        if (!runq.extract(process)) {
+        if (!runq.extract(
+                process,
+                process->scheduling.worker.load(std::memory_order_relaxed))) {
           running.fetch_sub(1);
           process = nullptr;
         }
@@ -3290,7 +3948,9 @@ void ProcessManager::enqueue(ProcessBase* process)
   // it's not running. Otherwise, check and see which thread this
   // process was last running on, and put it on that threads runq.
 
-  runq.enqueue(process);
+  runq.enqueue(
+      process,
+      process->scheduling.worker.load(std::memory_order_relaxed));
 }
 
 
@@ -3312,7 +3972,17 @@ ProcessBase* ProcessManager::dequeue()
   // NOTE: contract with the run queue is that we'll always //
   // call `wait` _BEFORE_ we call `dequeue`.                //
   ////////////////////////////////////////////////////////////
-  return runq.dequeue();
+  ProcessBase* process = runq.dequeue();
+
+  // Remember which worker runs the process so that it gets enqueued
+  // on the same worker next time (if the run queue tracks workers).
+  if (process != nullptr) {
+    process->scheduling.worker.store(
+        RunQueue::worker(),
+        std::memory_order_relaxed);
+  }
+
+  return process;
 }
 
 
@@ -3409,6 +4079,7 @@ Future<Response> ProcessManager::__processes__(const Request&)
 
 ProcessBase::ProcessBase(const string& id)
   : events(new EventQueue()),
+    profile(new ProcessProfile()),
     reference(std::make_shared<ProcessBase*>(this)),
     gate(std::make_shared<Gate>())
 {
@@ -3491,6 +4162,9 @@ void ProcessBase::enqueue(Event* event)
     case State::BOTTOM:
     case State::READY:
     case State::BLOCKED:
+      event->enqueued = std::chrono::steady_clock::now();
+      event->parent = trace::current();
+      profile->enqueued();
       events->producer.enqueue(event);
       break;
     case State::TERMINATING:
@@ -3574,7 +4248,7 @@ void ProcessBase::consume(MessageEvent&& event)
 
 void ProcessBase::consume(DispatchEvent&& event)
 {
-  std::move(*event.f)(this);
+  std::move(event.f)(this);
 }
 
 
@@ -3818,6 +4492,20 @@ UPID ProcessBase::link(const UPID& to, const RemoteConnection remote)
 }
 
 
+void ProcessBase::install(const string& name, const MessageHandler& handler)
+{
+  handlers.message[name] = handler;
+  profile->installed(name);
+}
+
+
+void ProcessBase::prioritize(const string& name, EventPriority priority)
+{
+  CHECK_EQ(this, __process__);
+  events->consumer.prioritize(name, priority);
+}
+
+
 void ProcessBase::route(
     const string& name,
     const Option<string>& help_,
@@ -3873,6 +4561,40 @@ ProcessBase:: operator JSON::Object()
   JSON::Object object;
   object.values["id"] = (const string&) pid.id;
   object.values["events"] = JSON::Array(events->consumer);
+
+  JSON::Object statistics;
+  statistics.values["resumes"] = scheduling.resumes;
+  statistics.values["events"] = scheduling.events;
+  statistics.values["preemptions"] = scheduling.preemptions;
+  object.values["scheduling"] = statistics;
+
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  JSON::Object handlers;
+  foreachpair (const string& name,
+               const ProcessProfile::Handler& handler,
+               profile->handlers()) {
+    JSON::Object h;
+    h.values["count"] = handler.count;
+    h.values["serve_time_us"] =
+      duration_cast<microseconds>(handler.total).count();
+    h.values["max_serve_time_us"] =
+      duration_cast<microseconds>(handler.max).count();
+    handlers.values[name] = h;
+  }
+
+  JSON::Object profile_;
+  profile_.values["event_queue_depth"] = profile->queued.load();
+  profile_.values["max_event_queue_depth"] = profile->maxQueued.load();
+  profile_.values["events_served"] = profile->events;
+  profile_.values["event_wait_time_us"] =
+    duration_cast<microseconds>(profile->waited).count();
+  profile_.values["max_event_wait_time_us"] =
+    duration_cast<microseconds>(profile->maxWaited).count();
+  profile_.values["handlers"] = handlers;
+  object.values["profile"] = profile_;
+
   return object;
 }
 
@@ -4033,7 +4755,7 @@ namespace internal {
 
 void dispatch(
     const UPID& pid,
-    std::unique_ptr<lambda::CallableOnce<void(ProcessBase*)>> f,
+    lambda::CallableOnce<void(ProcessBase*)>&& f,
     const Option<const std::type_info*>& functionType)
 {
   process::initialize();
@@ -17,9 +17,16 @@
 #include <sys/wait.h>
 #endif
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <process/defer.hpp>
 #include <process/delay.hpp>
 #include <process/future.hpp>
 #include <process/id.hpp>
+#include <process/io.hpp>
 #include <process/once.hpp>
 #include <process/owned.hpp>
 #include <process/reap.hpp>
@@ -33,12 +40,24 @@
 #include <stout/result.hpp>
 #include <stout/try.hpp>
 
+#if defined(__linux__) && !defined(SYS_pidfd_open)
+// The system call number is the same on all architectures, see
+// `pidfd_open(2)`. Older headers don't define it.
+#define SYS_pidfd_open 434
+#endif
+
 namespace process {
 
 
-// TODO(bmahler): This can be optimized to use a thread per pid, where
-// each thread makes a blocking call to waitpid. This eliminates the
-// unfortunate poll delay.
+// Pids are watched through a pidfd where the kernel supports it
+// (Linux 5.3+), which becomes readable as soon as the process exits so
+// the exit is noticed through the event loop without any delay. Other
+// pids are polled, with the interval given by the following simple
+// bounded linear model.
+//
+// NOTE: We don't use a signalfd for SIGCHLD since that requires the
+// signal to be blocked in every thread of the process, which a library
+// can't guarantee. It would also only cover our own children.
 //
 // Simple bounded linear model for computing the poll interval.
 // Values were chosen such that at (50 pids, 100 ms) the CPU usage is
@@ -70,8 +89,15 @@ Future<Option<int>> ReaperProcess::reap(pid_t pid)
 {
   // Check to see if this pid exists.
   if (os::exists(pid)) {
+    const bool reaping = promises.contains(pid);
+
     Owned<Promise<Option<int>>> promise(new Promise<Option<int>>());
     promises.put(pid, promise);
+
+    if (!reaping) {
+      watch(pid);
+    }
+
     return promise->future();
   } else {
     return None();
@@ -97,7 +123,12 @@ void ReaperProcess::wait()
   // NOTE: A child can only be reaped by us, the parent. If a child exits
   // between waitpid and the (!exists) conditional it will still exist as a
   // zombie; it will be reaped by us on the next loop.
-  foreach (pid_t pid, promises.keys()) {
+  //
+  // NOTE: We loop over a copy since `notify()` removes the pid. Watched
+  // pids get reaped as soon as they exit, see `_watch()`.
+  const hashset<pid_t> pids = polled;
+
+  foreach (pid_t pid, pids) {
     int status;
     Result<pid_t> child_pid = os::waitpid(pid, &status, WNOHANG);
     if (child_pid.isSome()) {
@@ -113,6 +144,45 @@ void ReaperProcess::wait()
 }
 
 
+void ReaperProcess::watch(pid_t pid)
+{
+#ifdef __linux__
+  // Failure means that the kernel doesn't support pidfds or that the
+  // process was reaped in the meantime. Either way we leave the pid
+  // to be polled.
+  const int pidfd = ::syscall(SYS_pidfd_open, pid, 0);
+  if (pidfd >= 0) {
+    io::poll(pidfd, io::READ)
+      .onAny(defer(self(), &ReaperProcess::_watch, pid, pidfd));
+    return;
+  }
+#endif // __linux__
+
+  polled.insert(pid);
+}
+
+
+void ReaperProcess::_watch(pid_t pid, int_fd pidfd)
+{
+  os::close(pidfd);
+
+  if (!promises.contains(pid)) {
+    return;
+  }
+
+  // The process has exited (or we failed to poll the pidfd). If it is
+  // our child we reap it now, otherwise we leave it to be polled since
+  // it doesn't go away until its parent reaps it.
+  int status;
+  Result<pid_t> child_pid = os::waitpid(pid, &status, WNOHANG);
+  if (child_pid.isSome()) {
+    notify(pid, status);
+  } else {
+    polled.insert(pid);
+  }
+}
+
+
 void ReaperProcess::notify(pid_t pid, Result<int> status)
 {
   foreach (const Owned<Promise<Option<int>>>& promise, promises.get(pid)) {
@@ -125,12 +195,13 @@ void ReaperProcess::notify(pid_t pid, Result<int> status)
     }
   }
   promises.remove(pid);
+  polled.erase(pid);
 }
 
 
 const Duration ReaperProcess::interval()
 {
-  size_t count = promises.size();
+  size_t count = polled.size();
 
   if (count <= LOW_PID_COUNT) {
     return MIN_REAP_INTERVAL();
@@ -20,7 +20,12 @@
 //      -DENABLE_LOCK_FREE_RUN_QUEUE (cmake) which enables the
 //      lock-free run queue implementation (see below for more details).
 //
-//  (2) --enable-last-in-first-out-fixed-size-semaphore (autotools) or
+//  (2) --enable-work-stealing-run-queue (autotools) or
+//      -DENABLE_WORK_STEALING_RUN_QUEUE (cmake) which enables the
+//      work stealing run queue implementation (see below for more
+//      details).
+//
+//  (3) --enable-last-in-first-out-fixed-size-semaphore (autotools) or
 //      -DENABLE_LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE (cmake) which
 //      enables an optimized semaphore implementation (see semaphore.hpp
 //      for more details).
@@ -32,13 +37,21 @@
 // _runtime_ decisions because we wanted the run queue implementation
 // to be compile-time optimized (e.g., inlined, etc).
 
+#if defined(LOCK_FREE_RUN_QUEUE) && defined(WORK_STEALING_RUN_QUEUE)
+#error "Only one of LOCK_FREE_RUN_QUEUE and WORK_STEALING_RUN_QUEUE can be set"
+#endif
+
 #ifdef LOCK_FREE_RUN_QUEUE
 #include <concurrentqueue.h>
 #endif // LOCK_FREE_RUN_QUEUE
 
 #include <algorithm>
+#include <array>
+#include <deque>
 #include <list>
 
+#include <glog/logging.h>
+
 #include <process/process.hpp>
 
 #include <stout/synchronized.hpp>
@@ -47,11 +60,13 @@
 
 namespace process {
 
-#ifndef LOCK_FREE_RUN_QUEUE
+#if !defined(LOCK_FREE_RUN_QUEUE) && !defined(WORK_STEALING_RUN_QUEUE)
 class RunQueue
 {
 public:
-  bool extract(ProcessBase* process)
+  // The index of the worker that last ran a process is ignored, see
+  // the work stealing run queue below.
+  bool extract(ProcessBase* process, int)
   {
     synchronized (mutex) {
       std::list<ProcessBase*>::iterator it = std::find(
@@ -73,7 +88,7 @@ public:
     semaphore.wait();
   }
 
-  void enqueue(ProcessBase* process)
+  void enqueue(ProcessBase* process, int)
   {
     synchronized (mutex) {
       processes.push_back(process);
@@ -96,6 +111,12 @@ public:
     return nullptr;
   }
 
+  // Workers are not tracked, see the work stealing run queue below.
+  static int worker()
+  {
+    return -1;
+  }
+
   // NOTE: this function can't be const because `synchronized (mutex)`
   // is not const ...
   bool empty()
@@ -130,12 +151,272 @@ private:
 #endif // LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE
 };
 
+#elif defined(WORK_STEALING_RUN_QUEUE)
+
+// A run queue made up of a separate queue for each worker thread.
+//
+// A worker first tries to dequeue a process from its own queue and
+// only when its own queue is empty does it try and "steal" a process
+// from the queues of the other workers. This removes the contention
+// of every worker thread on a single queue (and lock).
+//
+// To improve locality a process is enqueued on the queue of the worker
+// that last ran it, which the caller keeps track of (see `worker`
+// below) and passes to `enqueue` and `extract`, so that the process
+// is likely to keep running on the same thread (and thus with warm CPU
+// caches). A process that has never run is enqueued on the queue of
+// the enqueueing worker or, if not enqueued from a worker thread
+// (e.g., from the event loop), round-robin across the workers.
+//
+// Worker threads are implicitly registered the first time they call
+// `wait`, which only worker threads do.
+class RunQueue
+{
+public:
+  ~RunQueue()
+  {
+    for (size_t i = 0; i < queues.size(); i++) {
+      delete queues[i].load();
+    }
+  }
+
+  bool extract(ProcessBase* process, int last)
+  {
+    // Start looking on the queue that the process was most likely
+    // enqueued on.
+    const size_t size = std::max(workers.load(), (size_t) 1);
+    const size_t start = last >= 0 ? static_cast<size_t>(last) : 0;
+
+    for (size_t i = 0; i < size; i++) {
+      Queue* queue = queues[(start + i) % size].load();
+      if (queue == nullptr) {
+        continue;
+      }
+
+      synchronized (queue->mutex) {
+        std::deque<ProcessBase*>::iterator it = std::find(
+            queue->processes.begin(),
+            queue->processes.end(),
+            process);
+
+        if (it != queue->processes.end()) {
+          queue->processes.erase(it);
+          pending.fetch_sub(1);
+          return true;
+        }
+      }
+    }
+
+    return false;
+  }
+
+  void wait()
+  {
+    // Register the calling thread as a worker if this is the first
+    // time it is waiting on this run queue.
+    Worker& current = this->current();
+    if (current.runq != this) {
+      const size_t index = registered.fetch_add(1);
+
+      CHECK_LT(index, queues.size())
+        << "Number of worker threads can not exceed " << queues.size();
+
+      queue(index);
+
+      // Workers register concurrently so we only make this worker
+      // visible once all of the workers before it are visible, which
+      // guarantees that `queues[0, workers)` are all valid.
+      size_t expected = index;
+      while (!workers.compare_exchange_weak(expected, index + 1)) {
+        expected = index;
+      }
+
+      current.runq = this;
+      current.index = index;
+    }
+
+    semaphore.wait();
+  }
+
+  void enqueue(ProcessBase* process, int last)
+  {
+    size_t index = 0;
+
+    const size_t size = workers.load();
+
+    // Prefer the worker that last ran the process, then the current
+    // worker, then fall back to round-robin. If no workers have
+    // registered yet (i.e., while libprocess is initializing) we use
+    // the queue of the first worker.
+    if (size > 0) {
+      const Worker& current = this->current();
+
+      if (last >= 0 && static_cast<size_t>(last) < size) {
+        index = static_cast<size_t>(last);
+      } else if (current.runq == this) {
+        index = current.index;
+      } else {
+        index = next.fetch_add(1, std::memory_order_relaxed) % size;
+      }
+    }
+
+    Queue* queue = this->queue(index);
+
+    // NOTE: we increment `pending` _before_ we enqueue the process so
+    // that it never underflows when the process gets dequeued.
+    pending.fetch_add(1);
+
+    synchronized (queue->mutex) {
+      queue->processes.push_back(process);
+    }
+
+    epoch.fetch_add(1);
+    semaphore.signal();
+  }
+
+  // Precondition: `wait` must get called before `dequeue`!
+  ProcessBase* dequeue()
+  {
+    const Worker& current = this->current();
+    CHECK(current.runq == this);
+
+    // NOTE: the contract for using the run queue is that `wait` must
+    // be called first so we know that there is something to be
+    // dequeued. However, the process might not be on our queue and
+    // might get stolen by another worker while we look for it (in
+    // which case there must be another process for us to find), so
+    // we keep looking until we find a process, there are no more
+    // processes (possible because processes can be extracted), or
+    // the run queue has been decommissioned.
+    do {
+      const size_t size = workers.load();
+
+      // First try our own queue, then try and steal from the other
+      // workers starting with our "neighbor" so that the workers
+      // don't all contend on the same queue.
+      for (size_t i = 0; i < size; i++) {
+        Queue* queue = queues[(current.index + i) % size].load();
+
+        ProcessBase* process = nullptr;
+
+        synchronized (queue->mutex) {
+          if (!queue->processes.empty()) {
+            process = queue->processes.front();
+            queue->processes.pop_front();
+          }
+        }
+
+        if (process != nullptr) {
+          pending.fetch_sub(1);
+          return process;
+        }
+      }
+    } while (pending.load() > 0 && !semaphore.decomissioned());
+
+    return nullptr;
+  }
+
+  // Returns the index of the calling worker thread, or -1 if the
+  // calling thread is not a worker. Callers record this for the
+  // processes they run, to be passed to `enqueue` and `extract`.
+  static int worker()
+  {
+    const Worker& current = RunQueue::current();
+    return current.runq != nullptr ? static_cast<int>(current.index) : -1;
+  }
+
+  bool empty() const
+  {
+    return pending.load() == 0;
+  }
+
+  void decomission()
+  {
+    semaphore.decomission();
+  }
+
+  size_t capacity() const
+  {
+    return std::min(semaphore.capacity(), queues.size());
+  }
+
+  // Epoch used to capture changes to the run queue when settling.
+  std::atomic_long epoch = ATOMIC_VAR_INIT(0L);
+
+private:
+  // Maximum number of worker threads (this matches the maximum value
+  // of LIBPROCESS_NUM_WORKER_THREADS).
+  static constexpr size_t WORKERS = 1024;
+
+  // Run queue of a single worker thread.
+  //
+  // NOTE: we align each queue to a cache line to avoid false sharing
+  // between the workers.
+  struct alignas(64) Queue
+  {
+    std::deque<ProcessBase*> processes;
+    std::mutex mutex;
+  };
+
+  // The run queue (if any) that a thread is a worker of and the
+  // index of the worker's queue in `queues`.
+  struct Worker
+  {
+    RunQueue* runq = nullptr;
+    size_t index = 0;
+  };
+
+  static Worker& current()
+  {
+    static thread_local Worker worker;
+    return worker;
+  }
+
+  // Returns the queue at the specified index, creating it if it does
+  // not yet exist. Queues are only deleted when the run queue is
+  // destroyed.
+  Queue* queue(size_t index)
+  {
+    Queue* queue = queues[index].load();
+    if (queue == nullptr) {
+      Queue* created = new Queue();
+      if (queues[index].compare_exchange_strong(queue, created)) {
+        queue = created;
+      } else {
+        delete created;
+      }
+    }
+    return queue;
+  }
+
+  std::array<std::atomic<Queue*>, WORKERS> queues{};
+
+  // Number of workers that have started registering.
+  std::atomic<size_t> registered = ATOMIC_VAR_INIT(0);
+
+  // Number of registered workers, i.e., `queues[0, workers)` are all
+  // valid.
+  std::atomic<size_t> workers = ATOMIC_VAR_INIT(0);
+
+  // Used to distribute processes enqueued from non-worker threads.
+  std::atomic<size_t> next = ATOMIC_VAR_INIT(0);
+
+  // Number of processes across all of the queues.
+  std::atomic<long> pending = ATOMIC_VAR_INIT(0L);
+
+#ifndef LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE
+  DecomissionableKernelSemaphore semaphore;
+#else
+  DecomissionableLastInFirstOutFixedSizeSemaphore semaphore;
+#endif // LAST_IN_FIRST_OUT_FIXED_SIZE_SEMAPHORE
+};
+
 #else // LOCK_FREE_RUN_QUEUE
 
 class RunQueue
 {
 public:
-  bool extract(ProcessBase*)
+  bool extract(ProcessBase*, int)
   {
     // NOTE: moodycamel::ConcurrentQueue does not provide a way to
     // implement extract so we simply return false here.
@@ -147,7 +428,7 @@ public:
     semaphore.wait();
   }
 
-  void enqueue(ProcessBase* process)
+  void enqueue(ProcessBase* process, int)
   {
     queue.enqueue(process);
     epoch.fetch_add(1);
@@ -171,6 +452,12 @@ public:
     return process;
   }
 
+  // Workers are not tracked, see the work stealing run queue above.
+  static int worker()
+  {
+    return -1;
+  }
+
   bool empty() const
   {
     return queue.size_approx() == 0;
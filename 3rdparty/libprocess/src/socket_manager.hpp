@@ -81,6 +81,10 @@ public:
 
   Encoder* next(int_fd s);
 
+  // Records that the libprocess instance at `address` accepts
+  // messages using the binary framing (see `FrameEncoder`).
+  void framing(const network::inet::Address& address);
+
   void close(int_fd s);
 
   void exited(const network::inet::Address& address);
@@ -121,6 +125,14 @@ private:
       network::inet::Socket socket,
       Message&& message);
 
+  // Marks the new outbound socket `s` as framed if the peer at
+  // `address` is known to accept framed messages.
+  void framed_connect(int_fd s, const network::inet::Address& address);
+
+  // Returns an encoder for `message` that matches how the outbound
+  // socket `s` was set up.
+  Encoder* encode(int_fd s, const Message& message);
+
   // Collection of all active sockets (both inbound and outbound).
   hashmap<int_fd, network::inet::Socket> sockets;
 
@@ -149,8 +161,19 @@ private:
   // HTTP proxies.
   hashmap<int_fd, HttpProxy*> proxies;
 
+  // Outbound sockets that send messages using the binary framing
+  // rather than HTTP. Whether a socket is framed is decided when it
+  // gets created and doesn't change afterwards.
+  hashset<int_fd> framed;
+
   // Protects instance variables.
   std::recursive_mutex mutex;
+
+  // Addresses of peers that advertised support for the binary
+  // framing. These are recorded while parsing incoming messages so
+  // they have their own mutex rather than contending on `mutex`.
+  hashset<network::inet::Address> framing_peers;
+  std::mutex framing_mutex;
 };
 
 
@@ -18,6 +18,8 @@
 #endif // __linux__
 #include <sys/types.h>
 
+#include <spawn.h>
+
 #include <string>
 
 #include <glog/logging.h>
@@ -34,6 +36,7 @@
 #include <stout/none.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 #include <stout/unreachable.hpp>
 
@@ -197,6 +200,59 @@ inline int childMain(
 }
 
 
+// Starts the child with `posix_spawn`, which on Linux uses `vfork`
+// semantics and therefore does not copy the page tables of the
+// parent. This makes starting a child cheap even when the parent has
+// a large address space and avoids blocking the calling thread for
+// the duration of the copy. It can only be used when nothing has to
+// run in the child between the clone and the exec, see `cloneChild`.
+inline Try<pid_t> spawnChild(
+    const std::string& path,
+    char** argv,
+    char** envp,
+    const InputFileDescriptors& stdinfds,
+    const OutputFileDescriptors& stdoutfds,
+    const OutputFileDescriptors& stderrfds)
+{
+  posix_spawn_file_actions_t actions;
+
+  int error = ::posix_spawn_file_actions_init(&actions);
+  if (error != 0) {
+    return Error(
+        "Failed to initialize spawn file actions: " + os::strerror(error));
+  }
+
+  // Redirect I/O for stdin/stdout/stderr. All other file descriptors,
+  // including the parent's ends of the pipes, are close-on-exec.
+  const int redirects[][2] = {
+    {stdinfds.read, STDIN_FILENO},
+    {stdoutfds.write, STDOUT_FILENO},
+    {stderrfds.write, STDERR_FILENO}
+  };
+
+  foreach (const auto& redirect, redirects) {
+    error = ::posix_spawn_file_actions_adddup2(
+        &actions, redirect[0], redirect[1]);
+
+    if (error != 0) {
+      ::posix_spawn_file_actions_destroy(&actions);
+      return Error("Failed to add spawn file action: " + os::strerror(error));
+    }
+  }
+
+  pid_t pid;
+  error = ::posix_spawnp(&pid, path.c_str(), &actions, nullptr, argv, envp);
+
+  ::posix_spawn_file_actions_destroy(&actions);
+
+  if (error != 0) {
+    return Error("Failed to spawn '" + path + "': " + os::strerror(error));
+  }
+
+  return pid;
+}
+
+
 inline Try<pid_t> cloneChild(
     const std::string& path,
     std::vector<std::string> argv,
@@ -240,6 +296,35 @@ inline Try<pid_t> cloneChild(
     envp[index] = nullptr;
   }
 
+  // Use `posix_spawn` if nothing needs to run in the child before the
+  // exec. We also require that none of the redirected file descriptors
+  // is a standard one already, as a `dup2` onto itself would leave it
+  // close-on-exec, and that the executable is found using the same
+  // 'PATH' as with `os::execvpe`, i.e., the one in the environment of
+  // the child.
+  //
+  // If spawning fails (e.g., the executable does not exist) we fall
+  // back to cloning, so that the failure is reported through the exit
+  // status of the child as before.
+  Option<pid_t> spawned;
+
+  if (_clone.isNone() &&
+      parent_hooks.empty() &&
+      child_hooks.empty() &&
+      stdinfds.read > STDERR_FILENO &&
+      stdoutfds.write > STDERR_FILENO &&
+      stderrfds.write > STDERR_FILENO &&
+      (environment.isNone() || strings::contains(path, "/"))) {
+    Try<pid_t> pid = spawnChild(
+        path, _argv, envp, stdinfds, stdoutfds, stderrfds);
+
+    if (pid.isSome()) {
+      spawned = pid.get();
+    } else {
+      VLOG(1) << pid.error() << "; falling back to cloning";
+    }
+  }
+
   // Determine the function to clone the child process. If the user
   // does not specify the clone function, we will use the default.
   lambda::function<pid_t(const lambda::function<int()>&)> clone =
@@ -259,8 +344,8 @@ inline Try<pid_t> cloneChild(
     pipes = pipe.get();
   }
 
-  // Now, clone the child process.
-  pid_t pid = clone(lambda::bind(
+  // Now, clone the child process unless it was already spawned.
+  pid_t pid = spawned.isSome() ? spawned.get() : clone(lambda::bind(
       &childMain,
       path,
       _argv,
@@ -18,12 +18,15 @@
 
 #include <gmock/gmock.h>
 
+#include <array>
+#include <atomic>
 #include <deque>
 #include <iostream>
 #include <memory>
 #include <string>
 #include <vector>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/count_down_latch.hpp>
 #include <process/future.hpp>
@@ -32,23 +35,32 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
+#include <process/subprocess.hpp>
+#include <process/timer.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashset.hpp>
+#include <stout/lambda.hpp>
+#include <stout/nothing.hpp>
 #include <stout/stopwatch.hpp>
 
 #include "benchmarks.pb.h"
 
 namespace http = process::http;
 
+using process::Clock;
 using process::CountDownLatch;
 using process::Future;
 using process::MessageEvent;
 using process::Owned;
+using process::PID;
 using process::Process;
 using process::ProcessBase;
 using process::Promise;
+using process::Subprocess;
+using process::Timer;
 using process::UPID;
 
 using std::cout;
@@ -494,6 +506,93 @@ TEST(ProcessTest, Process_BENCHMARK_ThroughputPerformance)
 }
 
 
+// A process that repeatedly dispatches to its peer (which dispatches
+// back) until `repeat` dispatches have been made between the two.
+class PingPongProcess : public Process<PingPongProcess>
+{
+public:
+  PingPongProcess(CountDownLatch* latch, long repeat)
+    : latch(latch), repeat(repeat) {}
+
+  void setPeer(const PID<PingPongProcess>& _peer)
+  {
+    peer = _peer;
+  }
+
+  void ping(long count)
+  {
+    if (count >= repeat) {
+      latch->decrement();
+      return;
+    }
+
+    dispatch(peer, &PingPongProcess::ping, count + 1);
+  }
+
+private:
+  CountDownLatch* latch;
+  const long repeat;
+  PID<PingPongProcess> peer;
+};
+
+
+// Measures the dispatch throughput for an increasing number of pairs
+// of processes which dispatch back and forth, i.e., how well the run
+// queue scales as more processes are concurrently runnable. Run this
+// with LIBPROCESS_NUM_WORKER_THREADS set to 32 or more to measure the
+// contention between the worker threads on the run queue.
+TEST(ProcessTest, Process_BENCHMARK_DispatchThroughput)
+{
+  const long dispatches = 2000000;
+  const long numberOfPairs[] = {1, 8, 32, 64, 128, 256};
+
+  cout << "Using " << process::workers() << " worker threads" << endl;
+
+  foreach (long pairs, numberOfPairs) {
+    CountDownLatch latch(pairs);
+
+    const long repeat = dispatches / pairs;
+
+    vector<Owned<PingPongProcess>> processes;
+
+    for (long i = 0; i < pairs; i++) {
+      Owned<PingPongProcess> ping(new PingPongProcess(&latch, repeat));
+      Owned<PingPongProcess> pong(new PingPongProcess(&latch, repeat));
+
+      spawn(*ping);
+      spawn(*pong);
+
+      dispatch(ping->self(), &PingPongProcess::setPeer, pong->self());
+      dispatch(pong->self(), &PingPongProcess::setPeer, ping->self());
+
+      processes.push_back(ping);
+      processes.push_back(pong);
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < processes.size(); i += 2) {
+      dispatch(processes[i]->self(), &PingPongProcess::ping, 0);
+    }
+
+    AWAIT_READY(latch.triggered());
+
+    Duration elapsed = watch.elapsed();
+
+    cout << pairs << " pairs of processes made " << repeat * pairs
+         << " dispatches in " << elapsed << " ("
+         << std::fixed << std::setprecision(0)
+         << (repeat * pairs) / elapsed.secs() << " dispatches/s)" << endl;
+
+    foreach (const Owned<PingPongProcess>& process, processes) {
+      terminate(process->self());
+      wait(process->self());
+    }
+  }
+}
+
+
 // TODO(andschwa): Turn this test back on when MESOS-8915 is solved.
 #ifndef __WINDOWS__
 class DispatchProcess : public Process<DispatchProcess>
@@ -580,6 +679,56 @@ TEST(ProcessTest, Process_BENCHMARK_DispatchDefer)
   DispatchProcess::run<DispatchProcess::Movable>("Movable", repeats);
   DispatchProcess::run<DispatchProcess::Copyable>("Copyable", repeats);
 }
+
+
+class CaptureProcess : public Process<CaptureProcess> {};
+
+
+// Dispatches a lambda capturing `N` pointers. The inline storage of
+// `lambda::CallableOnce` is 8 pointers, one of which is taken by the
+// vtable, so only callables of up to 7 pointers (including what
+// `dispatch` binds along with the lambda) avoid another allocation,
+// which shows as a drop in the dispatch rate for the larger captures.
+template <size_t N>
+static void dispatchCapturing(const PID<CaptureProcess>& pid, long repeats)
+{
+  std::array<void*, N> captured;
+  captured.fill(nullptr);
+
+  Stopwatch watch;
+  watch.start();
+
+  for (long i = 0; i < repeats; i++) {
+    dispatch(pid, [captured]() { (void) captured; });
+  }
+
+  AWAIT_READY(dispatch(pid, []() { return Nothing(); }));
+
+  Duration elapsed = watch.elapsed();
+
+  cout << "Capturing " << N << " pointers: " << repeats
+       << " dispatches in " << elapsed << " ("
+       << std::fixed << std::setprecision(0)
+       << repeats / elapsed.secs() << " dispatches/s)" << endl;
+}
+
+
+TEST(ProcessTest, Process_BENCHMARK_DispatchCapture)
+{
+  constexpr long repeats = 1000000;
+
+  CaptureProcess process;
+  spawn(process);
+
+  dispatchCapturing<1>(process.self(), repeats);
+  dispatchCapturing<4>(process.self(), repeats);
+  dispatchCapturing<6>(process.self(), repeats);
+  dispatchCapturing<8>(process.self(), repeats);
+  dispatchCapturing<16>(process.self(), repeats);
+
+  terminate(process);
+  wait(process);
+}
 #endif // __WINDOWS__
 
 
@@ -587,9 +736,17 @@ class ProtobufInstallHandlerBenchmarkProcess
   : public ProtobufProcess<ProtobufInstallHandlerBenchmarkProcess>
 {
 public:
-  ProtobufInstallHandlerBenchmarkProcess()
+  ProtobufInstallHandlerBenchmarkProcess(bool rvalue, bool arena)
   {
-    install<tests::Message>(&Self::handle);
+    if (rvalue) {
+      install<tests::Message>(&Self::handleRvalue);
+    } else {
+      install<tests::Message>(&Self::handle);
+    }
+
+    if (arena) {
+      enableArenaParsing();
+    }
   }
 
   // TODO(dzhuk): Add benchmark for handlers taking individual
@@ -600,6 +757,8 @@ public:
     // from receiving MessageEvent till calling handler.
   }
 
+  void handleRvalue(tests::Message&& message) {}
+
   void run(int submessages)
   {
     tests::Message message = createMessage(submessages);
@@ -678,8 +837,221 @@ TEST(ProcessTest, Process_BENCHMARK_ProtobufInstallHandler)
 {
   const int submessages[] = {0, 1, 5, 10, 50, 100, 500, 1000, 5000, 10000};
 
-  ProtobufInstallHandlerBenchmarkProcess process;
-  foreach (int num_submessages, submessages) {
-    process.run(num_submessages);
+  // Compare parsing with and without a reused arena block, for
+  // handlers taking a const reference and an rvalue.
+  for (bool arena : {false, true}) {
+    for (bool rvalue : {false, true}) {
+      cout << (rvalue ? "Rvalue" : "Const reference") << " handler"
+           << (arena ? " with arena parsing:" : ":") << endl;
+
+      ProtobufInstallHandlerBenchmarkProcess process(rvalue, arena);
+      foreach (int num_submessages, submessages) {
+        process.run(num_submessages);
+      }
+    }
+  }
+}
+
+
+// Measures the cost of creating a future, chaining callbacks onto it
+// and then satisfying it, which is the common pattern in the master
+// and agent.
+TEST(ProcessTest, Process_BENCHMARK_FutureChain)
+{
+  constexpr size_t repeats = 100000;
+
+  const size_t lengths[] = {0, 1, 4, 16};
+
+  foreach (size_t length, lengths) {
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < repeats; i++) {
+      Promise<int> promise;
+
+      Future<int> future = promise.future();
+      for (size_t j = 0; j < length; j++) {
+        future = future.then([](int value) { return value + 1; });
+      }
+
+      promise.set(0);
+
+      ASSERT_TRUE(future.isReady());
+      ASSERT_EQ(static_cast<int>(length), future.get());
+    }
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Created and satisfied " << repeats << " futures chained "
+         << length << " times in " << elapsed << " ("
+         << std::fixed << std::setprecision(0)
+         << repeats / elapsed.secs() << " futures/s)" << endl;
+  }
+}
+
+
+// Measures the cost of creating, canceling and expiring a large number
+// of outstanding timers, like the master and agent keep around for
+// offer timeouts, pings and filters.
+TEST(ProcessTest, Process_BENCHMARK_Timers)
+{
+  constexpr size_t count = 1000000;
+
+  Clock::pause();
+
+  std::atomic<size_t> fired(0);
+  Promise<Nothing> expired;
+
+  vector<Timer> timers;
+  timers.reserve(count);
+
+  Stopwatch watch;
+  watch.start();
+
+  // Spread the timeouts over the next hour.
+  for (size_t i = 0; i < count; i++) {
+    timers.push_back(Clock::timer(
+        Milliseconds(static_cast<int64_t>(i % (60 * 60 * 1000))),
+        [&fired, &expired]() {
+          if (++fired == count / 2) {
+            expired.set(Nothing());
+          }
+        }));
+  }
+
+  cout << "Created " << count << " timers in " << watch.elapsed() << endl;
+
+  watch.start();
+
+  // Cancel every other timer.
+  for (size_t i = 0; i < count; i += 2) {
+    ASSERT_TRUE(Clock::cancel(timers[i]));
+  }
+
+  cout << "Canceled " << count / 2 << " timers in " << watch.elapsed()
+       << endl;
+
+  watch.start();
+
+  Clock::advance(Hours(1));
+  Clock::settle();
+
+  AWAIT_READY(expired.future());
+
+  cout << "Expired " << count / 2 << " timers in " << watch.elapsed()
+       << endl;
+
+  EXPECT_EQ(count / 2, fired.load());
+
+  Clock::resume();
+}
+
+
+class HttpPingProcess : public Process<HttpPingProcess>
+{
+public:
+  HttpPingProcess() : ProcessBase(process::ID::generate("http-ping")) {}
+
+protected:
+  virtual void initialize()
+  {
+    route("/ping", None(), [](const http::Request&) {
+      return http::OK();
+    });
+  }
+};
+
+
+// Measures the latency of sequences of small HTTP requests sent
+// through `http::request`, with and without reusing pooled
+// keep-alive connections.
+TEST(ProcessTest, Process_BENCHMARK_HttpConnectionPool)
+{
+  constexpr size_t requests = 10000;
+
+  const size_t concurrencies[] = {1, 16};
+
+  HttpPingProcess process;
+  PID<HttpPingProcess> pid = spawn(&process);
+
+  http::Request request = http::createRequest(pid, "GET", false, "ping");
+
+  for (bool keepAlive : {false, true}) {
+    foreach (size_t concurrency, concurrencies) {
+      request.keepAlive = keepAlive;
+
+      Stopwatch watch;
+      watch.start();
+
+      for (size_t i = 0; i < requests; i += concurrency) {
+        vector<Future<http::Response>> responses;
+        for (size_t j = 0; j < concurrency; j++) {
+          responses.push_back(http::request(request));
+        }
+
+        AWAIT_READY(collect(responses));
+      }
+
+      Duration elapsed = watch.elapsed();
+
+      cout << "Sent " << requests << " requests "
+           << (keepAlive ? "with" : "without") << " keep-alive and "
+           << concurrency << " in flight in " << elapsed << " ("
+           << std::fixed << std::setprecision(0)
+           << requests / elapsed.secs() << " requests/s)" << endl;
+    }
+  }
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Measures the latency of starting subprocesses as the resident set
+// of the parent grows, with the `posix_spawn` fast path and with the
+// child forked through a clone function.
+TEST(ProcessTest, Process_BENCHMARK_SubprocessSpawn)
+{
+  constexpr size_t count = 100;
+
+  const Bytes sizes[] = {Bytes(0), Megabytes(512), Gigabytes(2)};
+
+  // Passing a clone function forces `subprocess` to fork the child.
+  lambda::function<pid_t(const lambda::function<int()>&)> fork =
+    [](const lambda::function<int()>& func) {
+      pid_t pid = ::fork();
+      if (pid == 0) {
+        ::exit(func());
+      }
+      return pid;
+    };
+
+  foreach (const Bytes& size, sizes) {
+    // Touch every page so that it has to be mapped in the child.
+    vector<char> memory(size.bytes(), 1);
+
+    for (bool spawn : {true, false}) {
+      Stopwatch watch;
+      watch.start();
+
+      for (size_t i = 0; i < count; i++) {
+        Try<Subprocess> s = process::subprocess(
+            "true",
+            {"true"},
+            Subprocess::FD(STDIN_FILENO),
+            Subprocess::FD(STDOUT_FILENO),
+            Subprocess::FD(STDERR_FILENO),
+            nullptr,
+            None(),
+            spawn ? None() : Option<decltype(fork)>(fork));
+
+        ASSERT_SOME(s);
+        AWAIT_READY(s->status());
+      }
+
+      cout << "Started " << count << " subprocesses "
+           << (spawn ? "with posix_spawn" : "with fork") << " from a "
+           << size << " resident set in " << watch.elapsed() << endl;
+    }
   }
 }
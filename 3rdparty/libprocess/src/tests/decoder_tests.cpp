@@ -25,12 +25,19 @@
 namespace http = process::http;
 
 using process::DataDecoder;
+using process::FrameDecoder;
+using process::FrameEncoder;
 using process::Future;
+using process::Message;
 using process::Owned;
+using process::UPID;
 using process::ResponseDecoder;
 using process::StreamingRequestDecoder;
 using process::StreamingResponseDecoder;
 
+using process::FRAMING_PREFACE;
+using process::FRAMING_PREFACE_LENGTH;
+
 using std::deque;
 using std::string;
 
@@ -325,3 +332,95 @@ TEST(DecoderTest, StreamingResponseInvalidHeader)
 
   EXPECT_TRUE(decoder.failed());
 }
+
+
+TEST(DecoderTest, Frame)
+{
+  Message message1;
+  message1.name = "name1";
+  message1.from = UPID("from@1.2.3.4:5");
+  message1.to = UPID("to1@6.7.8.9:10");
+  message1.body = "body1";
+
+  Message message2;
+  message2.name = "name2";
+  message2.from = UPID("from@1.2.3.4:5");
+  message2.to = UPID("to2@6.7.8.9:10");
+
+  const string data =
+    string(FRAMING_PREFACE, FRAMING_PREFACE_LENGTH) +
+    FrameEncoder::encode(message1) +
+    FrameEncoder::encode(message2);
+
+  // Feed the data one byte at a time to exercise partial prefaces and
+  // partial frames.
+  FrameDecoder decoder;
+  deque<Message> messages;
+
+  for (size_t i = 0; i < data.size(); i++) {
+    deque<Message> decoded = decoder.decode(data.data() + i, 1);
+    ASSERT_FALSE(decoder.failed());
+
+    foreach (Message& message, decoded) {
+      messages.push_back(std::move(message));
+    }
+  }
+
+  ASSERT_EQ(2u, messages.size());
+
+  EXPECT_EQ("name1", messages[0].name);
+  EXPECT_EQ(message1.from, messages[0].from);
+  EXPECT_EQ("to1", messages[0].to.id);
+  EXPECT_EQ("body1", messages[0].body);
+
+  EXPECT_EQ("name2", messages[1].name);
+  EXPECT_EQ(message2.from, messages[1].from);
+  EXPECT_EQ("to2", messages[1].to.id);
+  EXPECT_EQ("", messages[1].body);
+
+  // Both frames also decode from a single buffer.
+  FrameDecoder decoder2;
+  messages = decoder2.decode(data.data(), data.size());
+  EXPECT_FALSE(decoder2.failed());
+  EXPECT_EQ(2u, messages.size());
+}
+
+
+TEST(DecoderTest, FrameInvalidPreface)
+{
+  FrameDecoder decoder;
+
+  const string data = "POST /to/name HTTP/1.1\r\n";
+
+  deque<Message> messages = decoder.decode(data.data(), data.length());
+
+  EXPECT_TRUE(messages.empty());
+  EXPECT_TRUE(decoder.failed());
+}
+
+
+TEST(DecoderTest, FrameTooLarge)
+{
+  Message message;
+  message.name = "name";
+  message.from = UPID("from@1.2.3.4:5");
+  message.to = UPID("to@6.7.8.9:10");
+  message.body = string(1024, 'a');
+
+  const string data =
+    string(FRAMING_PREFACE, FRAMING_PREFACE_LENGTH) +
+    FrameEncoder::encode(message);
+
+  // The frame fits within the default maximum.
+  FrameDecoder decoder;
+  EXPECT_EQ(1u, decoder.decode(data.data(), data.size()).size());
+  EXPECT_FALSE(decoder.failed());
+
+  // Only the length of the frame is needed to reject it.
+  FrameDecoder decoder2(1024);
+  deque<Message> messages = decoder2.decode(
+      data.data(), FRAMING_PREFACE_LENGTH + sizeof(uint32_t));
+
+  EXPECT_TRUE(messages.empty());
+  EXPECT_TRUE(decoder2.failed());
+}
@@ -13,6 +13,7 @@
 #include <gmock/gmock.h>
 
 #include <deque>
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -21,17 +22,23 @@
 #include <process/socket.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/os.hpp>
 
 #include "encoder.hpp"
 #include "decoder.hpp"
 
 namespace http = process::http;
 
+using process::DataEncoder;
+using process::Encoder;
+using process::FileEncoder;
 using process::HttpResponseEncoder;
+using process::MAXIMUM_COALESCED_LENGTH;
 using process::Owned;
 using process::ResponseDecoder;
 
 using std::deque;
+using std::queue;
 using std::string;
 using std::vector;
 
@@ -115,3 +122,76 @@ TEST(EncoderTest, AcceptableEncodings)
       << gzipRequest.headers.get("Accept-Encoding").get() << "'";
   }
 }
+
+
+// Returns the remaining data of the data encoder and deletes it.
+static string drain(Encoder* encoder)
+{
+  EXPECT_EQ(Encoder::DATA, encoder->kind());
+
+  size_t length;
+  const char* data = static_cast<DataEncoder*>(encoder)->next(&length);
+
+  string result(data, length);
+  delete encoder;
+
+  return result;
+}
+
+
+TEST(EncoderTest, Coalesce)
+{
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+
+  Try<int_fd> fd = os::open(path.get(), O_RDONLY | O_CLOEXEC);
+  ASSERT_SOME(fd);
+
+  queue<Encoder*> encoders;
+  encoders.push(new DataEncoder("a"));
+  encoders.push(new DataEncoder("b"));
+  encoders.push(new FileEncoder(fd.get(), 0));
+  encoders.push(new DataEncoder("c"));
+  encoders.push(new DataEncoder("d"));
+
+  // The data is coalesced in order, but not across the file.
+  EXPECT_EQ("ab", drain(process::coalesce(&encoders)));
+
+  Encoder* file = process::coalesce(&encoders);
+  EXPECT_EQ(Encoder::FILE, file->kind());
+  delete file;
+
+  EXPECT_EQ("cd", drain(process::coalesce(&encoders)));
+  EXPECT_TRUE(encoders.empty());
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
+
+TEST(EncoderTest, CoalesceMaximumLength)
+{
+  const string data(MAXIMUM_COALESCED_LENGTH - 1, 'a');
+
+  queue<Encoder*> encoders;
+  encoders.push(new DataEncoder(data));
+  encoders.push(new DataEncoder("b"));
+  encoders.push(new DataEncoder("c"));
+
+  // Only as much data as fits in `MAXIMUM_COALESCED_LENGTH` bytes.
+  EXPECT_EQ(data + "b", drain(process::coalesce(&encoders)));
+  EXPECT_EQ("c", drain(process::coalesce(&encoders)));
+  EXPECT_TRUE(encoders.empty());
+
+  // Only the remaining data of a partially sent encoder counts.
+  DataEncoder* encoder = new DataEncoder("x" + data);
+
+  size_t length;
+  encoder->next(&length);
+  encoder->backup(length - 1);
+
+  encoders.push(encoder);
+  encoders.push(new DataEncoder("b"));
+
+  EXPECT_EQ(data + "b", drain(process::coalesce(&encoders)));
+  EXPECT_TRUE(encoders.empty());
+}
@@ -726,6 +726,37 @@ TEST_P(HTTPTest, Get)
 }
 
 
+// Tests that a large response body gets gzipped in chunks and streamed
+// to a client that accepts gzip.
+TEST_P(HTTPTest, GzipLargeBody)
+{
+  Http http;
+
+  string body;
+  while (body.size() < process::GZIP_STREAMING_MINIMUM_BODY_LENGTH) {
+    body += stringify(body.size());
+  }
+
+  EXPECT_CALL(*http.process, body(_))
+    .WillOnce(Return(http::OK(body)));
+
+  http::Headers headers;
+  headers["Accept-Encoding"] = "gzip";
+
+  Future<http::Response> response =
+    http::get(http.process->self(), "body", None(), headers, GetParam());
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::Status::OK, response->code);
+
+  EXPECT_SOME_EQ("gzip", response->headers.get("Content-Encoding"));
+  EXPECT_SOME_EQ("chunked", response->headers.get("Transfer-Encoding"));
+
+  // The client decompresses the body.
+  EXPECT_EQ(body, response->body);
+}
+
+
 // TODO(hausdorff): Routing logic is broken on Windows. Fix and enable test. In
 // this case, the route '/a/b/c' exists and returns 200 ok, but '/a/b' does
 // not. See MESOS-5904.
@@ -984,6 +1015,36 @@ TEST_P(HTTPTest, Request)
 }
 
 
+// This test verifies that keep-alive requests sent through
+// `http::request` reuse a pooled connection.
+TEST_P(HTTPTest, RequestConnectionPool)
+{
+  Http http;
+
+  Future<http::Request> request1;
+  Future<http::Request> request2;
+  EXPECT_CALL(*http.process, get(_))
+    .WillOnce(DoAll(FutureArg<0>(&request1), Return(http::OK())))
+    .WillOnce(DoAll(FutureArg<0>(&request2), Return(http::OK())));
+
+  http::Request request = http::createRequest(
+      http.process->self(), "GET", GetParam() == "https", "get");
+  request.keepAlive = true;
+
+  Future<http::Response> response = http::request(request);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  response = http::request(request);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  AWAIT_READY(request1);
+  AWAIT_READY(request2);
+
+  ASSERT_SOME(request1->client);
+  EXPECT_SOME_EQ(request1->client.get(), request2->client);
+}
+
+
 // This test verifies that the server can correctly receive the
 // uncompressed data from the request.
 TEST(HTTPConnectionTest, GzipRequestBody)
@@ -13,6 +13,7 @@
 #include <gmock/gmock.h>
 
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/gtest.hpp>
@@ -25,11 +26,16 @@
 
 #include "encoder.hpp"
 
+#ifdef USE_IO_URING
+#include "io_uring.hpp"
+#endif // USE_IO_URING
+
 namespace io = process::io;
 
 using process::Future;
 
 using std::string;
+using std::vector;
 
 class IOTest: public TemporaryDirectoryTest {};
 
@@ -365,3 +371,136 @@ TEST_F(IOTest, Redirect)
   // accumulated in the redirect hook.
   EXPECT_EQ(data, accumulated);
 }
+
+
+#ifdef USE_IO_URING
+// Reads and writes of regular files go through io_uring when the
+// kernel supports it, and through the system calls otherwise.
+TEST_F(IOTest, IOUringRegularFile)
+{
+  Try<int_fd> fd = os::open(
+      "file",
+      O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  ASSERT_SOME(fd);
+  ASSERT_SOME(os::nonblock(fd.get()));
+
+  string data(1024 * 1024, 'a');
+
+  AWAIT_READY(io::write(fd.get(), data));
+
+  ASSERT_NE(-1, ::lseek(fd.get(), 0, SEEK_SET));
+
+  AWAIT_EXPECT_EQ(data, io::read(fd.get()));
+
+  ASSERT_SOME(os::close(fd.get()));
+}
+
+
+// Submitting many more operations than there are submission queue
+// entries backlogs the rest, and their completions may overflow the
+// completion queue; none of them may be lost.
+TEST_F(IOTest, IOUringBacklog)
+{
+  if (!process::io_uring::available()) {
+    return;
+  }
+
+  Try<int_fd> fd = os::open(
+      "file",
+      O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  ASSERT_SOME(fd);
+
+  static const char data = 'a';
+  const size_t count = 16 * 1024;
+
+  vector<Future<int>> futures;
+  for (size_t i = 0; i < count; ++i) {
+    futures.push_back(process::io_uring::write(fd.get(), &data, 1));
+  }
+
+  foreach (const Future<int>& future, futures) {
+    AWAIT_EXPECT_EQ(1, future);
+  }
+
+  ASSERT_SOME(os::close(fd.get()));
+
+  Try<string> read = os::read("file");
+  ASSERT_SOME(read);
+  EXPECT_EQ(string(count, 'a'), read.get());
+}
+
+
+// A discarded operation is cancelled in the kernel, after which it
+// must not consume any data.
+TEST_F(IOTest, IOUringDiscard)
+{
+  if (!process::io_uring::available()) {
+    return;
+  }
+
+  int pipes[2];
+  char data[3];
+
+  ASSERT_NE(-1, ::pipe(pipes));
+
+  Future<int> future = process::io_uring::read(pipes[0], data, 3);
+  EXPECT_TRUE(future.isPending());
+
+  future.discard();
+  AWAIT_DISCARDED(future);
+
+  ASSERT_EQ(3, ::write(pipes[1], "omg", 3));
+
+  ASSERT_EQ(3, ::read(pipes[0], data, 3));
+  EXPECT_EQ("omg", string(data, 3));
+
+  ASSERT_SOME(os::close(pipes[0]));
+  ASSERT_SOME(os::close(pipes[1]));
+}
+
+
+// A discard that races with the completion of an operation either
+// cancels it, leaving the data in place, or leaves the future with
+// the result of the operation; the data is never lost.
+TEST_F(IOTest, IOUringDiscardRace)
+{
+  if (!process::io_uring::available()) {
+    return;
+  }
+
+  int pipes[2];
+  ASSERT_NE(-1, ::pipe(pipes));
+  ASSERT_SOME(os::nonblock(pipes[0]));
+
+  for (int i = 0; i < 100; ++i) {
+    char data = '\0';
+
+    ASSERT_EQ(1, ::write(pipes[1], "x", 1));
+
+    Future<int> future = process::io_uring::read(pipes[0], &data, 1);
+    future.discard();
+
+    AWAIT(future);
+
+    char remaining = '\0';
+    ssize_t length = ::read(pipes[0], &remaining, 1);
+
+    if (future.isDiscarded()) {
+      ASSERT_EQ(1, length);
+      EXPECT_EQ('x', remaining);
+    } else {
+      AWAIT_ASSERT_EQ(1, future);
+      EXPECT_EQ('x', data);
+      ASSERT_EQ(-1, length);
+      EXPECT_EQ(EAGAIN, errno);
+    }
+  }
+
+  ASSERT_SOME(os::close(pipes[0]));
+  ASSERT_SOME(os::close(pipes[1]));
+}
+#endif // USE_IO_URING
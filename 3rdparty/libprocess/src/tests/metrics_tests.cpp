@@ -12,13 +12,16 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <stout/base64.hpp>
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
+#include <stout/strings.hpp>
 
 #include <process/authenticator.hpp>
 #include <process/clock.hpp>
@@ -30,6 +33,7 @@
 #include <process/time.hpp>
 
 #include <process/metrics/counter.hpp>
+#include <process/metrics/histogram.hpp>
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/pull_gauge.hpp>
 #include <process/metrics/push_gauge.hpp>
@@ -174,6 +178,72 @@ TEST_F(MetricsTest, PullGauge)
 }
 
 
+// Tests that the increments of several threads, which land on
+// different shards of the counter, all add up.
+TEST_F(MetricsTest, THREADSAFE_CounterConcurrent)
+{
+  Counter counter("test/counter");
+
+  AWAIT_READY(metrics::add(counter));
+
+  vector<std::thread> threads;
+  for (size_t i = 0; i < 4; ++i) {
+    threads.emplace_back([&counter]() {
+      for (size_t j = 0; j < 10000; ++j) {
+        ++counter;
+      }
+    });
+  }
+
+  foreach (std::thread& thread, threads) {
+    thread.join();
+  }
+
+  AWAIT_EXPECT_EQ(40000.0, counter.value());
+
+  AWAIT_READY(metrics::remove(counter));
+}
+
+
+// Tests that a snapshot reuses the last value of a pull gauge
+// as long as it is within the staleness bound of the gauge.
+TEST_F(MetricsTest, PullGaugeStaleness)
+{
+  Clock::pause();
+
+  std::atomic<int> calls(0);
+
+  PullGauge gauge(
+      "test/gauge",
+      [&calls]() -> Future<double> { return ++calls; },
+      Seconds(10));
+
+  AWAIT_READY(metrics::add(gauge));
+
+  Future<map<string, double>> snapshot = metrics::snapshot(None());
+  AWAIT_READY(snapshot);
+  EXPECT_EQ(1.0, snapshot->at("test/gauge"));
+
+  Clock::advance(Seconds(5));
+
+  snapshot = metrics::snapshot(None());
+  AWAIT_READY(snapshot);
+  EXPECT_EQ(1.0, snapshot->at("test/gauge"));
+  EXPECT_EQ(1, calls.load());
+
+  Clock::advance(Seconds(6));
+
+  snapshot = metrics::snapshot(None());
+  AWAIT_READY(snapshot);
+  EXPECT_EQ(2.0, snapshot->at("test/gauge"));
+  EXPECT_EQ(2, calls.load());
+
+  AWAIT_READY(metrics::remove(gauge));
+
+  Clock::resume();
+}
+
+
 TEST_F(MetricsTest, PushGauge)
 {
   // Gauge with a value.
@@ -567,6 +637,95 @@ TEST_F(MetricsTest, Timer)
 }
 
 
+TEST_F(MetricsTest, Histogram)
+{
+  metrics::Histogram histogram({1, 10});
+
+  histogram.add(0.5);
+  histogram.add(1);
+  histogram.add(5);
+  histogram.add(20);
+
+  metrics::Histogram::Snapshot snapshot = histogram.snapshot();
+  EXPECT_EQ(vector<uint64_t>({2, 1, 1}), snapshot.counts);
+  EXPECT_DOUBLE_EQ(26.5, snapshot.sum);
+  EXPECT_EQ(4u, snapshot.count);
+
+  // Histograms with the same buckets can be merged.
+  snapshot += snapshot;
+  EXPECT_EQ(vector<uint64_t>({4, 2, 2}), snapshot.counts);
+  EXPECT_DOUBLE_EQ(53.0, snapshot.sum);
+  EXPECT_EQ(8u, snapshot.count);
+}
+
+
+// Tests that the `/metrics/prometheus` endpoint exposes timers as
+// histograms and all other metrics as samples.
+TEST_F(MetricsTest, Prometheus)
+{
+  UPID upid("metrics", process::address());
+
+  Clock::pause();
+
+  Counter counter("test/counter");
+  metrics::Timer<Milliseconds> timer("test/timer", None(), {1, 10});
+
+  // Sanitized to the same name as `counter` and as the buckets of
+  // `timer`, so these are not exposed.
+  Counter duplicate("test_counter");
+  Counter bucket("test/timer_ms_bucket");
+
+  AWAIT_READY(metrics::add(counter));
+  AWAIT_READY(metrics::add(timer));
+  AWAIT_READY(metrics::add(duplicate));
+  AWAIT_READY(metrics::add(bucket));
+
+  counter += 3;
+
+  timer.start();
+  Clock::advance(Milliseconds(5));
+  timer.stop();
+
+  timer.start();
+  Clock::advance(Milliseconds(20));
+  timer.stop();
+
+  Future<Response> response = http::get(upid, "prometheus");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ(
+      "text/plain; version=0.0.4", "Content-Type", response);
+
+  const string expected[] = {
+    "# TYPE test_counter untyped\n"
+    "test_counter 3\n",
+    "# HELP test_timer_ms In ms.\n"
+    "# TYPE test_timer_ms histogram\n"
+    "test_timer_ms_bucket{le=\"1\"} 0\n"
+    "test_timer_ms_bucket{le=\"10\"} 1\n"
+    "test_timer_ms_bucket{le=\"+Inf\"} 2\n"
+    "test_timer_ms_sum 25\n"
+    "test_timer_ms_count 2\n"
+  };
+
+  foreach (const string& lines, expected) {
+    EXPECT_TRUE(strings::contains(response->body, lines)) << response->body;
+  }
+
+  EXPECT_EQ(2u, strings::split(response->body, "# TYPE test_counter ").size())
+    << response->body;
+  EXPECT_FALSE(strings::contains(response->body, "test_timer_ms_bucket 0"))
+    << response->body;
+
+  AWAIT_READY(metrics::remove(counter));
+  AWAIT_READY(metrics::remove(timer));
+  AWAIT_READY(metrics::remove(duplicate));
+  AWAIT_READY(metrics::remove(bucket));
+
+  Clock::resume();
+}
+
+
 static Future<int> advanceAndReturn()
 {
   Clock::advance(Seconds(1));
@@ -19,12 +19,19 @@
 
 #include <gmock/gmock.h>
 
+#include <google/protobuf/struct.pb.h>
+
+#include <google/protobuf/util/message_differencer.h>
+
 #ifndef __WINDOWS__
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #endif // __WINDOWS__
 
 #include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -40,30 +47,39 @@
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
+#include <process/id.hpp>
 #include <process/network.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/protobuf.hpp>
 #include <process/reap.hpp>
 #include <process/run.hpp>
 #include <process/socket.hpp>
 #include <process/subprocess.hpp>
 #include <process/time.hpp>
 
+#include <process/metrics/metrics.hpp>
+
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/result.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
+#include <stout/synchronized.hpp>
 #include <stout/try.hpp>
 
 #include <stout/os/killtree.hpp>
 #include <stout/os/write.hpp>
 
 #include "encoder.hpp"
+#include "trace.hpp"
 
 namespace http = process::http;
 namespace inject = process::inject;
@@ -75,8 +91,10 @@ using process::CountDownLatch;
 using process::defer;
 using process::Deferred;
 using process::Event;
+using process::EventPriority;
 using process::Executor;
 using process::ExitedEvent;
+using process::FrameEncoder;
 using process::Future;
 using process::Message;
 using process::MessageEncoder;
@@ -85,12 +103,17 @@ using process::Owned;
 using process::PID;
 using process::Process;
 using process::ProcessBase;
+using process::Promise;
 using process::run;
 using process::Subprocess;
 using process::TerminateEvent;
 using process::Time;
+using process::Timer;
 using process::UPID;
 
+using process::FRAMING_PREFACE;
+using process::FRAMING_PREFACE_LENGTH;
+
 using process::firewall::DisabledEndpointsFirewallRule;
 using process::firewall::FirewallRule;
 
@@ -101,6 +124,12 @@ using std::move;
 using std::string;
 using std::vector;
 
+using google::protobuf::ListValue;
+using google::protobuf::Struct;
+using google::protobuf::Value;
+
+using google::protobuf::util::MessageDifferencer;
+
 using testing::_;
 using testing::Assign;
 using testing::DoAll;
@@ -620,6 +649,205 @@ TEST(ProcessTest, Delay)
 }
 
 
+// The ids of the timers created through `record` in the order in
+// which the timers fired.
+struct Fired
+{
+  vector<int> get()
+  {
+    synchronized (mutex) {
+      return ids;
+    }
+  }
+
+  std::mutex mutex;
+  vector<int> ids;
+};
+
+
+static Timer record(
+    const std::shared_ptr<Fired>& fired,
+    const Duration& duration,
+    int id)
+{
+  return Clock::timer(duration, [=]() {
+    synchronized (fired->mutex) {
+      fired->ids.push_back(id);
+    }
+  });
+}
+
+
+// Timers are kept in a timing wheel whose levels cover 256ms, ~65s,
+// ~4.6 hours and ~49.7 days, with timers further out kept separately.
+// This verifies that timers on each level fire in order and not early.
+TEST(ProcessTest, TimersFireInOrder)
+{
+  Clock::pause();
+
+  std::shared_ptr<Fired> fired(new Fired());
+
+  // Add the timers out of order.
+  record(fired, Days(50), 4);
+  record(fired, Seconds(70), 2);
+  record(fired, Milliseconds(1), 0);
+  record(fired, Hours(5), 3);
+  record(fired, Milliseconds(300), 1);
+
+  Clock::advance(Milliseconds(299));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0}), fired->get());
+
+  Clock::advance(Milliseconds(1));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0, 1}), fired->get());
+
+  Clock::advance(Seconds(70) - Milliseconds(301));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0, 1}), fired->get());
+
+  Clock::advance(Milliseconds(1));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0, 1, 2}), fired->get());
+
+  // Advancing past several levels at once still fires in order.
+  Clock::advance(Days(50));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0, 1, 2, 3, 4}), fired->get());
+
+  // Do the same for timers that all get cascaded down together.
+  fired.reset(new Fired());
+
+  record(fired, Days(60), 3);
+  record(fired, Days(51), 2);
+  record(fired, Days(50) + Milliseconds(1), 1);
+  record(fired, Days(50), 0);
+
+  Clock::advance(Days(50) - Milliseconds(1));
+  Clock::settle();
+  EXPECT_TRUE(fired->get().empty());
+
+  Clock::advance(Days(11));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0, 1, 2, 3}), fired->get());
+
+  Clock::resume();
+}
+
+
+TEST(ProcessTest, CancelEarliestTimer)
+{
+  Clock::pause();
+
+  std::shared_ptr<Fired> fired(new Fired());
+
+  Timer first = record(fired, Seconds(1), 0);
+  record(fired, Seconds(2), 1);
+
+  EXPECT_TRUE(Clock::cancel(first));
+  EXPECT_FALSE(Clock::cancel(first));
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+  EXPECT_TRUE(fired->get().empty());
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({1}), fired->get());
+
+  Clock::resume();
+}
+
+
+// Cancelling a timer must not affect another timer with the same
+// timeout, which is also the earliest one.
+TEST(ProcessTest, CancelTimerWithSharedTimeout)
+{
+  Clock::pause();
+
+  std::shared_ptr<Fired> fired(new Fired());
+
+  Timer first = record(fired, Seconds(1), 0);
+  Timer second = record(fired, Seconds(1), 1);
+
+  ASSERT_EQ(first.timeout().time(), second.timeout().time());
+
+  EXPECT_TRUE(Clock::cancel(first));
+
+  Clock::advance(Seconds(1));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({1}), fired->get());
+
+  EXPECT_FALSE(Clock::cancel(second));
+
+  Clock::resume();
+}
+
+
+class TimerProcess : public Process<TimerProcess> {};
+
+
+// While the clock is paused a process keeps its own notion of the
+// current time, which can lag behind the global clock. Timers that
+// the process creates can thus time out before the tick up to which
+// the wheel has already been advanced, and must fire right away.
+TEST(ProcessTest, TimerInThePast)
+{
+  Clock::pause();
+
+  std::shared_ptr<Fired> fired(new Fired());
+
+  TimerProcess process;
+  spawn(process);
+
+  // Advance the wheel by letting a timer fire.
+  record(fired, Days(1), 0);
+
+  Clock::advance(Days(1));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0}), fired->get());
+
+  Future<Timer> timer = dispatch(process.self(), [=]() {
+    return record(fired, Seconds(1), 1);
+  });
+
+  AWAIT_READY(timer);
+  EXPECT_LT(timer->timeout().time(), Clock::now());
+
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0, 1}), fired->get());
+
+  terminate(process);
+  wait(process);
+
+  Clock::resume();
+}
+
+
+// Advancing the paused clock also advances the timing wheel, which
+// must not keep timers created after the clock is resumed from firing.
+TEST(ProcessTest, TimerAfterResume)
+{
+  Clock::pause();
+
+  std::shared_ptr<Fired> fired(new Fired());
+
+  // Advance the wheel by letting a timer fire.
+  record(fired, Days(100), 0);
+
+  Clock::advance(Days(100));
+  Clock::settle();
+  EXPECT_EQ(vector<int>({0}), fired->get());
+
+  Clock::resume();
+
+  Promise<Nothing> promise;
+  Clock::timer(Milliseconds(10), [&promise]() { promise.set(Nothing()); });
+
+  AWAIT_READY(promise.future());
+}
+
+
 class OrderProcess : public Process<OrderProcess>
 {
 public:
@@ -671,6 +899,356 @@ TEST(ProcessTest, Order)
 }
 
 
+class PriorityProcess : public Process<PriorityProcess>
+{
+public:
+  void initialize() override
+  {
+    install("high", &PriorityProcess::handle);
+    install("normal", &PriorityProcess::handle);
+    install("low", &PriorityProcess::handle);
+
+    prioritize("high", EventPriority::HIGH);
+    prioritize("low", EventPriority::LOW);
+  }
+
+  void block(const Future<Nothing>& future)
+  {
+    future.await();
+  }
+
+  void handle(const UPID& from, const string& body)
+  {
+    served.push_back(body);
+
+    if (served.size() == 3) {
+      promise.set(served);
+    }
+  }
+
+  vector<string> served;
+  Promise<vector<string>> promise;
+};
+
+
+// Tests that queued events get served in the order of their priority.
+TEST(ProcessTest, Prioritize)
+{
+  PriorityProcess process;
+  PID<PriorityProcess> pid = spawn(process);
+
+  // Block the process so that the messages below get queued.
+  Promise<Nothing> promise;
+  dispatch(pid, &PriorityProcess::block, promise.future());
+
+  foreach (const string& name, vector<string>({"low", "normal", "high"})) {
+    post(pid, name, name.data(), name.size());
+  }
+
+  promise.set(Nothing());
+
+  AWAIT_EXPECT_EQ(
+      vector<string>({"high", "normal", "low"}),
+      process.promise.future());
+
+  terminate(pid);
+  wait(pid);
+}
+
+
+class ProfileProcess : public Process<ProfileProcess>
+{
+public:
+  ProfileProcess() : ProcessBase(process::ID::generate("profile-test")) {}
+
+  void initialize() override
+  {
+    install("ping", &ProfileProcess::ping);
+  }
+
+  void block(const Future<Nothing>& future)
+  {
+    future.await();
+  }
+
+  void ping(const UPID& from, const string& body)
+  {
+    if (++pings == 3) {
+      promise.set(Nothing());
+    }
+  }
+
+  int pings = 0;
+  Promise<Nothing> promise;
+};
+
+
+// Tests that the events served by a process are profiled, exposed
+// via /__processes__ per handler and as metrics aggregated across the
+// processes with the same name.
+TEST(ProcessTest, Profile)
+{
+  ProfileProcess process;
+  PID<ProfileProcess> pid = spawn(process);
+
+  // Block the process so that the messages below get queued.
+  Promise<Nothing> promise;
+  dispatch(pid, &ProfileProcess::block, promise.future());
+
+  // Messages without an installed handler share a single slot.
+  post(pid, "pong");
+  post(pid, "pang");
+
+  for (int i = 0; i < 3; ++i) {
+    post(pid, "ping");
+  }
+
+  promise.set(Nothing());
+
+  AWAIT_READY(process.promise.future());
+
+  Future<http::Response> response =
+    http::get(UPID("__processes__", process::address()));
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Try<JSON::Array> processes = JSON::parse<JSON::Array>(response->body);
+  ASSERT_SOME(processes);
+
+  Option<JSON::Object> profile;
+  foreach (const JSON::Value& value, processes->values) {
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> id = object.find<JSON::String>("id");
+    ASSERT_SOME(id);
+
+    if (id->value == pid.id) {
+      Result<JSON::Object> result = object.find<JSON::Object>("profile");
+      ASSERT_SOME(result);
+      profile = result.get();
+    }
+  }
+
+  ASSERT_SOME(profile);
+
+  // NOTE: The totals are only updated at the end of a resume, which
+  // may still be serving the dispatch for the JSON representation.
+  EXPECT_SOME(profile->find<JSON::Number>("events_served"));
+  EXPECT_SOME(profile->find<JSON::Number>("max_event_queue_depth"));
+  EXPECT_SOME(profile->find<JSON::Number>("event_wait_time_us"));
+
+  Result<JSON::Number> pings =
+    profile->find<JSON::Number>("handlers.ping.count");
+  ASSERT_SOME(pings);
+  EXPECT_EQ(3u, pings->as<uint64_t>());
+
+  EXPECT_SOME(profile->find<JSON::Number>("handlers.ping.serve_time_us"));
+  EXPECT_SOME(
+      profile->find<JSON::Number>("handlers.ping.max_serve_time_us"));
+
+  Result<JSON::Number> unknown =
+    profile->find<JSON::Number>("handlers.unknown.count");
+  ASSERT_SOME(unknown);
+  EXPECT_EQ(2u, unknown->as<uint64_t>());
+
+  EXPECT_NONE(profile->find<JSON::Object>("handlers.pong"));
+  EXPECT_NONE(profile->find<JSON::Object>("handlers.pang"));
+
+  Result<JSON::Number> dispatches =
+    profile->find<JSON::Number>("handlers.dispatch.count");
+  ASSERT_SOME(dispatches);
+  EXPECT_LE(1u, dispatches->as<uint64_t>());
+
+  terminate(pid);
+  wait(pid);
+
+  Future<hashmap<string, double>> snapshot =
+    process::metrics::snapshot(None())
+      .then([](const std::map<string, double>& values) {
+        return hashmap<string, double>(values);
+      });
+
+  AWAIT_READY(snapshot);
+
+  const string prefix = "libprocess/processes/profile-test/";
+
+  ASSERT_TRUE(snapshot->contains(prefix + "events_served"));
+  ASSERT_TRUE(snapshot->contains(prefix + "event_queue_depth"));
+  ASSERT_TRUE(snapshot->contains(prefix + "event_wait_time_us"));
+  ASSERT_TRUE(snapshot->contains(prefix + "event_serve_time_us"));
+
+  // The dispatch, the messages and the termination were served.
+  EXPECT_LE(5.0, snapshot->at(prefix + "events_served"));
+  EXPECT_EQ(0.0, snapshot->at(prefix + "event_queue_depth"));
+}
+
+
+class ArenaProcess : public ProtobufProcess<ArenaProcess>
+{
+public:
+  ArenaProcess() : ProcessBase(process::ID::generate("arena-test"))
+  {
+    // Use a small block so that the messages below also need blocks
+    // that the arena allocates beyond the reused one.
+    enableArenaParsing(256);
+  }
+
+  void initialize() override
+  {
+    install<Struct>(&ArenaProcess::structure);
+    install<ListValue>(&ArenaProcess::list);
+  }
+
+  // Serves the messages nested in 'message' from within this handler,
+  // i.e., while its arena holds the block of this thread, so that the
+  // nested handlers fall back to an arena on the heap.
+  void structure(const UPID& from, const Struct& message)
+  {
+    structures.push_back(message);
+
+    auto nested = message.fields().find("nested");
+    if (nested == message.fields().end()) {
+      return;
+    }
+
+    string data;
+
+    nested->second.struct_value().SerializeToString(&data);
+    consume(MessageEvent(
+        from, self(), Struct().GetTypeName(), data.data(), data.size()));
+
+    nested->second.struct_value().fields().at("list").list_value()
+      .SerializeToString(&data);
+    consume(MessageEvent(
+        from, self(), ListValue().GetTypeName(), data.data(), data.size()));
+  }
+
+  void list(const UPID& from, ListValue&& message)
+  {
+    lists.push_back(std::move(message));
+  }
+
+  vector<Struct> structures;
+  vector<ListValue> lists;
+};
+
+
+// Tests that both the handlers taking a const reference and those
+// taking an rvalue receive the messages intact with arena parsing
+// enabled, whether or not the arena gets to reuse the block.
+TEST(ProcessTest, ArenaParsing)
+{
+  ListValue list;
+  for (int i = 0; i < 64; ++i) {
+    list.add_values()->set_string_value("value " + stringify(i));
+  }
+
+  Struct inner;
+  (*inner.mutable_fields())["list"].mutable_list_value()->CopyFrom(list);
+  (*inner.mutable_fields())["number"].set_number_value(42);
+
+  Struct outer;
+  (*outer.mutable_fields())["nested"].mutable_struct_value()->CopyFrom(inner);
+  (*outer.mutable_fields())["flag"].set_bool_value(true);
+
+  ArenaProcess process;
+  PID<ArenaProcess> pid = spawn(process);
+
+  post(pid, list);
+  post(pid, outer);
+
+  // Wait for the messages to be served.
+  AWAIT_READY(dispatch(pid, []() { return Nothing(); }));
+
+  terminate(pid);
+  wait(pid);
+
+  // The handlers were served in order, with the nested ones served
+  // while serving `outer`.
+  ASSERT_EQ(2u, process.structures.size());
+  EXPECT_TRUE(MessageDifferencer::Equals(outer, process.structures[0]));
+  EXPECT_TRUE(MessageDifferencer::Equals(inner, process.structures[1]));
+
+  ASSERT_EQ(2u, process.lists.size());
+  EXPECT_TRUE(MessageDifferencer::Equals(list, process.lists[0]));
+  EXPECT_TRUE(MessageDifferencer::Equals(list, process.lists[1]));
+}
+
+
+class TraceProcess : public Process<TraceProcess>
+{
+public:
+  void forward(const PID<TraceProcess>& pid)
+  {
+    dispatch(pid, &TraceProcess::handle);
+  }
+
+  void handle()
+  {
+    promise.set(Nothing());
+  }
+
+  Promise<Nothing> promise;
+};
+
+
+// Tests that the span of a dispatch refers to the span of the event
+// during which it was dispatched.
+TEST(ProcessTest, Trace)
+{
+  process::trace::internal::enable(1024);
+
+  TraceProcess process1;
+  TraceProcess process2;
+
+  PID<TraceProcess> pid1 = spawn(process1);
+  PID<TraceProcess> pid2 = spawn(process2);
+
+  dispatch(pid1, &TraceProcess::forward, pid2);
+
+  AWAIT_READY(process2.promise.future());
+
+  terminate(pid1);
+  wait(pid1);
+
+  terminate(pid2);
+  wait(pid2);
+
+  JSON::Object trace = process::trace::internal::dump();
+
+  process::trace::internal::enable(0);
+
+  Result<JSON::Array> events = trace.at<JSON::Array>("traceEvents");
+  ASSERT_SOME(events);
+
+  // Find the span of each dispatch by the process that served it.
+  hashmap<string, JSON::Object> spans;
+  foreach (const JSON::Value& value, events->values) {
+    JSON::Object event = value.as<JSON::Object>();
+
+    Result<JSON::String> phase = event.at<JSON::String>("ph");
+    Result<JSON::String> name = event.at<JSON::String>("name");
+    Result<JSON::String> id = event.at<JSON::String>("args.process");
+
+    if (phase.isSome() && phase->value == "X" &&
+        name.isSome() && name->value == "dispatch" &&
+        id.isSome() && (id->value == pid1.id || id->value == pid2.id)) {
+      spans[id->value] = event;
+    }
+  }
+
+  ASSERT_TRUE(spans.contains(pid1.id));
+  ASSERT_TRUE(spans.contains(pid2.id));
+
+  Result<JSON::Number> span = spans[pid1.id].at<JSON::Number>("args.span");
+  Result<JSON::Number> parent = spans[pid2.id].at<JSON::Number>("args.parent");
+
+  ASSERT_SOME(span);
+  ASSERT_SOME(parent);
+  EXPECT_EQ(span->as<uint64_t>(), parent->as<uint64_t>());
+}
+
+
 class DonateProcess : public Process<DonateProcess>
 {
 public:
@@ -1023,9 +1601,117 @@ namespace process {
 // to programatically mess with "link" FDs during tests.
 Option<int> get_persistent_socket(const UPID& to);
 
+// We need to reinitialize libprocess in order to test against different
+// configurations, such as the scheduling limits read from environment
+// variables when libprocess is initialized.
+void reinitialize(
+    const Option<string>& delegate,
+    const Option<string>& readonlyAuthenticationRealm,
+    const Option<string>& readwriteAuthenticationRealm);
+
 } // namespace process {
 
 
+class YieldProcess : public Process<YieldProcess>
+{
+public:
+  void block(const Future<Nothing>& future)
+  {
+    future.await();
+  }
+
+  void handle(int i, const Duration& duration)
+  {
+    os::sleep(duration);
+    handled.push_back(i);
+  }
+
+  vector<int> get()
+  {
+    return handled;
+  }
+
+private:
+  vector<int> handled;
+};
+
+
+// Reinitializes libprocess with the given scheduling limit, after
+// which a process with many queued events must yield the worker
+// thread, get enqueued again and still serve its events in order.
+static void yields(
+    const string& variable,
+    const string& value,
+    const Duration& duration)
+{
+  os::setenv(variable, value);
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+
+  // The preemptions are counted across reinitializations, so only the
+  // ones during this test are checked below.
+  Future<double> preemptions = process::metrics::snapshot(None())
+    .then([](const std::map<string, double>& values) {
+      auto iterator = values.find("libprocess/preemptions");
+      return iterator != values.end() ? iterator->second : 0.0;
+    });
+
+  AWAIT_READY(preemptions);
+
+  YieldProcess process;
+  PID<YieldProcess> pid = spawn(process);
+
+  // Block the process so that the events below get queued.
+  Promise<Nothing> promise;
+  dispatch(pid, &YieldProcess::block, promise.future());
+
+  vector<int> expected;
+  for (int i = 0; i < 10; ++i) {
+    dispatch(pid, &YieldProcess::handle, i, duration);
+    expected.push_back(i);
+  }
+
+  promise.set(Nothing());
+
+  AWAIT_EXPECT_EQ(expected, dispatch(pid, &YieldProcess::get));
+
+  Future<hashmap<string, double>> snapshot =
+    process::metrics::snapshot(None())
+      .then([](const std::map<string, double>& values) {
+        return hashmap<string, double>(values);
+      });
+
+  AWAIT_READY(snapshot);
+  ASSERT_TRUE(snapshot->contains("libprocess/preemptions"));
+  EXPECT_LT(preemptions.get(), snapshot->at("libprocess/preemptions"));
+
+  terminate(pid);
+  wait(pid);
+
+  os::unsetenv(variable);
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+}
+
+
+TEST(ProcessTest, YieldAfterMaxEventsPerResume)
+{
+  yields("LIBPROCESS_MAX_EVENTS_PER_RESUME", "2", Duration::zero());
+}
+
+
+TEST(ProcessTest, YieldAfterMaxResumeDuration)
+{
+  yields("LIBPROCESS_MAX_RESUME_DURATION", "1ms", Milliseconds(2));
+}
+
+
 // TODO(hausdorff): Test disabled temporarily because `SHUT_WR` does not exist
 // on Windows. See MESOS-5817.
 #ifndef __WINDOWS__
@@ -1396,6 +2082,59 @@ TEST(ProcessTest, Remote)
 }
 
 
+// Like the 'remote' test but sends the message using the binary
+// framing, with framing enabled as it would be in a deployment.
+TEST(ProcessTest, RemoteFramed)
+{
+  os::setenv("LIBPROCESS_ENABLE_MESSAGE_FRAMING", "true");
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+
+  RemoteProcess process;
+  spawn(process);
+
+  Future<Nothing> handler;
+  EXPECT_CALL(process, handler(_, _))
+    .WillOnce(FutureSatisfy(&handler));
+
+  Try<Socket> create = Socket::create();
+  ASSERT_SOME(create);
+
+  Socket socket = create.get();
+
+  AWAIT_READY(socket.connect(process.self().address));
+
+  Try<Address> sender = socket.address();
+  ASSERT_SOME(sender);
+
+  Message message;
+  message.name = "handler";
+  message.from = UPID("sender", sender.get());
+  message.to = process.self();
+
+  const string data =
+    string(FRAMING_PREFACE, FRAMING_PREFACE_LENGTH) +
+    FrameEncoder::encode(message);
+
+  AWAIT_READY(socket.send(data));
+
+  AWAIT_READY(handler);
+
+  terminate(process);
+  wait(process);
+
+  os::unsetenv("LIBPROCESS_ENABLE_MESSAGE_FRAMING");
+
+  process::reinitialize(
+      None(),
+      process::READWRITE_HTTP_AUTHENTICATION_REALM,
+      process::READONLY_HTTP_AUTHENTICATION_REALM);
+}
+
+
 // Like the 'remote' test but uses http::connect.
 TEST(ProcessTest, Http1)
 {
@@ -15,6 +15,10 @@
 
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif // __linux__
+
 #include <gtest/gtest.h>
 
 #include <process/clock.hpp>
@@ -173,3 +177,113 @@ TEST(ReapTest, TerminatedChildProcess)
 
   Clock::resume();
 }
+
+
+#if defined(__linux__) && defined(SYS_pidfd_open)
+// Where pidfds are supported, the exit of a child is noticed through
+// the event loop, without waiting for the reaper to poll.
+TEST(ReapTest, ChildProcessPidfd)
+{
+  const int pidfd = ::syscall(SYS_pidfd_open, ::getpid(), 0);
+  if (pidfd < 0) {
+    return;
+  }
+
+  ASSERT_SOME(os::close(pidfd));
+
+  Try<ProcessTree> tree = Fork(None(),
+                               Exec("sleep 10"))();
+
+  ASSERT_SOME(tree);
+  pid_t child = tree.get();
+
+  // Pausing the clock keeps the reaper from polling.
+  Clock::pause();
+
+  Future<Option<int>> status = process::reap(child);
+
+  EXPECT_EQ(0, kill(child, SIGKILL));
+
+  AWAIT_EXPECT_WTERMSIG_EQ(SIGKILL, status);
+
+  Clock::resume();
+}
+#endif // __linux__ && SYS_pidfd_open
+
+
+// The exit of a non-child process may be noticed through a pidfd, but
+// it can't be reaped by us, so the reaper falls back to polling until
+// the process is gone.
+TEST(ReapTest, NonChildProcessFallsBackToPolling)
+{
+  Try<ProcessTree> tree = Fork(None(),
+                               Fork(Exec(SLEEP_COMMAND(10))),
+                               Exec("exit 0"))();
+  ASSERT_SOME(tree);
+  ASSERT_EQ(1u, tree->children.size());
+  pid_t grandchild = tree->children.front();
+
+  Clock::pause();
+
+  Future<Option<int>> status = process::reap(grandchild);
+
+  EXPECT_EQ(0, kill(grandchild, SIGKILL));
+
+  // Wait for the grandchild to be reaped by 'init'.
+  while (os::exists(grandchild)) {
+    os::sleep(Milliseconds(1));
+  }
+
+  // Without advancing the clock the reaper doesn't poll, so the
+  // status can't be known yet.
+  Clock::settle();
+  EXPECT_TRUE(status.isPending());
+
+  while (status.isPending()) {
+    Clock::advance(MAX_REAP_INTERVAL());
+    Clock::settle();
+  }
+
+  AWAIT_READY(status);
+  ASSERT_NONE(status.get()) << status->get();
+
+  // Reap the child as well to clean up after ourselves.
+  status = process::reap(tree->process.pid);
+
+  while (status.isPending()) {
+    Clock::advance(MAX_REAP_INTERVAL());
+    Clock::settle();
+  }
+
+  AWAIT_EXPECT_WEXITSTATUS_EQ(0, status);
+
+  Clock::resume();
+}
+
+
+// Reaping the same pid more than once notifies all the callers.
+TEST(ReapTest, ChildProcessReapedTwice)
+{
+  Try<ProcessTree> tree = Fork(None(),
+                               Exec("sleep 10"))();
+
+  ASSERT_SOME(tree);
+  pid_t child = tree.get();
+
+  Future<Option<int>> status1 = process::reap(child);
+  Future<Option<int>> status2 = process::reap(child);
+
+  EXPECT_EQ(0, kill(child, SIGKILL));
+
+  Clock::pause();
+
+  while (status1.isPending() || status2.isPending()) {
+    Clock::advance(MAX_REAP_INTERVAL());
+    Clock::settle();
+  }
+
+  AWAIT_EXPECT_WTERMSIG_EQ(SIGKILL, status1);
+  AWAIT_EXPECT_WTERMSIG_EQ(SIGKILL, status2);
+
+  Clock::resume();
+}
@@ -10,7 +10,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 
@@ -19,10 +21,13 @@
 #include <process/http.hpp>
 #include <process/process.hpp>
 #include <process/socket.hpp>
+#include <process/subprocess.hpp>
 
 #include <process/ssl/gtest.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/try.hpp>
 
 #include <stout/tests/utils.hpp>
@@ -35,11 +40,14 @@ namespace unix = process::network::unix;
 using process::Future;
 using process::READONLY_HTTP_AUTHENTICATION_REALM;
 using process::READWRITE_HTTP_AUTHENTICATION_REALM;
+using process::Subprocess;
 
 using process::network::inet::Address;
 using process::network::inet::Socket;
 
+using std::map;
 using std::string;
+using std::vector;
 
 using testing::WithParamInterface;
 
@@ -91,6 +99,35 @@ TEST_F(SocketTest, Unix)
 }
 
 
+// The event loops are set up once per OS process, so the socket and
+// HTTP tests are run again in a subprocess with several event loops.
+// Accepted sockets are then often pinned to a different event loop
+// than the listening socket and have to be handed over to it.
+TEST_F(SocketTest, MultipleEventLoops)
+{
+  map<string, string> environment = os::environment();
+  environment["LIBPROCESS_NUM_EVENT_LOOP_THREADS"] = "4";
+
+  const string path = path::join(BUILD_DIR, "libprocess-tests");
+
+  Try<Subprocess> tests = process::subprocess(
+      path,
+      vector<string>{
+        path,
+        "--gtest_filter="
+          "*NetSocketTest.*:*HTTPTest.*:HTTPConnectionTest.*"},
+      Subprocess::FD(STDIN_FILENO),
+      Subprocess::FD(STDOUT_FILENO),
+      Subprocess::FD(STDERR_FILENO),
+      nullptr,
+      environment);
+
+  ASSERT_SOME(tests);
+
+  AWAIT_EXPECT_WEXITSTATUS_EQ_FOR(0, tests->status(), Minutes(5));
+}
+
+
 // Parameterize the tests with the type of encryption used.
 class NetSocketTest : public SSLTemporaryDirectoryTest,
                       public WithParamInterface<string>
@@ -243,4 +280,43 @@ TEST_P(NetSocketTest, EOFAfterRecv)
 
   AWAIT_EXPECT_EQ(string(), receive);
 }
+
+
+#ifdef USE_IO_URING
+// Sockets keep polling for readiness when io_uring is enabled (it is
+// only used for regular files), so a discarded `recv()` must leave
+// any data that arrives afterwards to the next `recv()`.
+TEST_P(NetSocketTest, DiscardedRecv)
+{
+  Try<Socket> client = Socket::create();
+  ASSERT_SOME(client);
+
+  const string data = "Lorem ipsum dolor sit amet";
+
+  Try<Socket> server = Socket::create();
+  ASSERT_SOME(server);
+
+  Try<Address> server_address = server->bind(inet4::Address::ANY_ANY());
+  ASSERT_SOME(server_address);
+
+  ASSERT_SOME(server->listen(1));
+  Future<Socket> server_accept = server->accept();
+
+  AWAIT_READY(
+      client->connect(Address(process::address().ip, server_address->port)));
+
+  AWAIT_READY(server_accept);
+
+  Socket server_socket = server_accept.get();
+
+  Future<string> receive = client->recv(data.size());
+  EXPECT_TRUE(receive.isPending());
+
+  receive.discard();
+  AWAIT_DISCARDED(receive);
+
+  AWAIT_READY(server_socket.send(data));
+  AWAIT_EXPECT_EQ(data, client->recv(data.size()));
+}
+#endif // USE_IO_URING
 #endif // __WINDOWS__
@@ -12,6 +12,7 @@
 
 #include <stdio.h>
 
+#include <iostream>
 #include <map>
 #include <string>
 #include <vector>
@@ -33,10 +34,13 @@
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/try.hpp>
 
 #include "openssl.hpp"
 
+using std::cout;
+using std::endl;
 using std::map;
 using std::string;
 using std::vector;
@@ -918,4 +922,84 @@ TEST_F(SSLTest, ShutdownThenSend)
   AWAIT_FAILED(Socket(socket.get()).send("Hello World"));
 }
 
+
+// Ensures that reconnecting to a server resumes the session of the
+// previous connection instead of doing a full handshake.
+TEST_F(SSLTest, SessionResumption)
+{
+  Try<Socket> server = setup_server({
+      {"LIBPROCESS_SSL_ENABLED", "true"},
+      {"LIBPROCESS_SSL_KEY_FILE", key_path().string()},
+      {"LIBPROCESS_SSL_CERT_FILE", certificate_path().string()},
+      {"LIBPROCESS_SSL_ENABLE_SESSION_RESUMPTION", "true"}});
+
+  ASSERT_SOME(server);
+  ASSERT_SOME(server->address());
+
+  for (int i = 0; i < 3; i++) {
+    Future<Socket> accept = server->accept();
+
+    Try<Socket> client = Socket::create(SocketImpl::Kind::SSL);
+    ASSERT_SOME(client);
+    AWAIT_ASSERT_READY(client->connect(server->address().get()));
+
+    AWAIT_ASSERT_READY(accept);
+
+    // Exchange some data so that the client also receives any session
+    // ticket that gets sent after the handshake (as done by TLS 1.3).
+    Socket socket = accept.get();
+    AWAIT_ASSERT_READY(socket.send(data));
+    AWAIT_ASSERT_EQ(data, client->recv(data.size()));
+  }
+
+  // Both reconnections resumed the session of the first connection
+  // (this counts the sessions reused by the server).
+  EXPECT_EQ(2, SSL_CTX_sess_hits(openssl::context()));
+}
+
+
+// Measures how quickly a client can reconnect to a server, with and
+// without session resumption. This is the load a master sees when all
+// agents reconnect after a failover.
+TEST_F(SSLTest, BENCHMARK_Reconnect)
+{
+  const size_t connections = 1000;
+
+  for (bool resumption : {false, true}) {
+    Try<Socket> server = setup_server({
+        {"LIBPROCESS_SSL_ENABLED", "true"},
+        {"LIBPROCESS_SSL_KEY_FILE", key_path().string()},
+        {"LIBPROCESS_SSL_CERT_FILE", certificate_path().string()},
+        {"LIBPROCESS_SSL_ENABLE_SESSION_RESUMPTION",
+         resumption ? "true" : "false"}});
+
+    ASSERT_SOME(server);
+    ASSERT_SOME(server->address());
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < connections; i++) {
+      Future<Socket> accept = server->accept();
+
+      Try<Socket> client = Socket::create(SocketImpl::Kind::SSL);
+      ASSERT_SOME(client);
+      AWAIT_ASSERT_READY(client->connect(server->address().get()));
+
+      AWAIT_ASSERT_READY(accept);
+
+      Socket socket = accept.get();
+      AWAIT_ASSERT_READY(socket.send(data));
+      AWAIT_ASSERT_EQ(data, client->recv(data.size()));
+    }
+
+    watch.stop();
+
+    cout << "Established " << connections << " connections "
+         << (resumption ? "with" : "without") << " session resumption in "
+         << watch.elapsed() << " (" << SSL_CTX_sess_hits(openssl::context())
+         << " resumed)" << endl;
+  }
+}
+
 #endif // USE_SSL_SOCKET
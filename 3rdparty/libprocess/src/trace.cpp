@@ -0,0 +1,257 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <process/trace.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/synchronized.hpp>
+
+#include "trace.hpp"
+
+using std::string;
+using std::vector;
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+namespace process {
+namespace trace {
+
+// The span of the event being served by this thread.
+static thread_local uint64_t __span__ = 0;
+
+
+uint64_t current()
+{
+  return __span__;
+}
+
+
+Scope::Scope(uint64_t span)
+  : previous(__span__)
+{
+  __span__ = span;
+}
+
+
+Scope::~Scope()
+{
+  __span__ = previous;
+}
+
+
+namespace internal {
+
+// Number of spans kept per thread, 0 if recording is disabled.
+static std::atomic<size_t> capacity(0);
+
+// ID of the next span, 0 is reserved for "no span".
+static std::atomic<uint64_t> next(1);
+
+
+// The spans recorded by one thread, in a ring buffer. The lock is
+// only contended while the spans are being dumped.
+struct Buffer
+{
+  explicit Buffer(size_t _thread) : thread(_thread) {}
+
+  const size_t thread;
+
+  std::mutex mutex;
+  vector<Span> spans;
+
+  // Index of the oldest span once the buffer is full.
+  size_t oldest = 0;
+};
+
+
+// All buffers, including those of threads that have exited so that
+// their spans can still be dumped. Intentionally leaked.
+static std::mutex* buffers_mutex = new std::mutex();
+static vector<Buffer*>* buffers = new vector<Buffer*>();
+
+
+static Buffer* buffer()
+{
+  static thread_local Buffer* buffer = nullptr;
+
+  if (buffer == nullptr) {
+    synchronized (buffers_mutex) {
+      buffer = new Buffer(buffers->size());
+      buffers->push_back(buffer);
+    }
+  }
+
+  return buffer;
+}
+
+
+Span::Span(const string& _name, const UPID& pid, const Event& event)
+  : id(next.fetch_add(1, std::memory_order_relaxed)),
+    parent(event.parent),
+    name(_name),
+    process(pid.id),
+    enqueued(event.enqueued),
+    duration(std::chrono::nanoseconds::zero()) {}
+
+
+void enable(size_t _capacity)
+{
+  capacity.store(_capacity);
+}
+
+
+bool enabled()
+{
+  return capacity.load(std::memory_order_relaxed) > 0;
+}
+
+
+void record(Span&& span)
+{
+  Buffer* buffer = internal::buffer();
+
+  synchronized (buffer->mutex) {
+    const size_t limit = capacity.load();
+
+    // Drop the oldest spans if the capacity has been reduced, keeping
+    // the remaining ones in order.
+    if (buffer->spans.size() > limit) {
+      std::rotate(
+          buffer->spans.begin(),
+          buffer->spans.begin() + buffer->oldest,
+          buffer->spans.end());
+
+      buffer->spans.erase(
+          buffer->spans.begin(),
+          buffer->spans.end() - limit);
+
+      buffer->spans.shrink_to_fit();
+      buffer->oldest = 0;
+    }
+
+    if (buffer->spans.size() < limit) {
+      buffer->spans.push_back(std::move(span));
+    } else if (!buffer->spans.empty()) {
+      buffer->spans[buffer->oldest] = std::move(span);
+      buffer->oldest = (buffer->oldest + 1) % buffer->spans.size();
+    }
+  }
+}
+
+
+static int64_t micros(steady_clock::time_point time)
+{
+  return duration_cast<microseconds>(time.time_since_epoch()).count();
+}
+
+
+JSON::Object dump()
+{
+  // Copy the spans so that we don't hold the locks while serializing.
+  vector<std::pair<size_t, Span>> spans;
+
+  synchronized (buffers_mutex) {
+    foreach (Buffer* buffer, *buffers) {
+      synchronized (buffer->mutex) {
+        foreach (const Span& span, buffer->spans) {
+          spans.emplace_back(buffer->thread, span);
+        }
+      }
+    }
+  }
+
+  hashmap<uint64_t, const std::pair<size_t, Span>*> index;
+  foreach (const auto& span, spans) {
+    index[span.second.id] = &span;
+  }
+
+  JSON::Array events;
+
+  foreach (const auto& entry, spans) {
+    const size_t thread = entry.first;
+    const Span& span = entry.second;
+
+    JSON::Object args;
+    args.values["process"] = span.process;
+    args.values["span"] = span.id;
+    args.values["parent"] = span.parent;
+    args.values["queued_us"] =
+      duration_cast<microseconds>(span.start - span.enqueued).count();
+
+    JSON::Object event;
+    event.values["name"] = span.name;
+    event.values["cat"] = "libprocess";
+    event.values["ph"] = "X";
+    event.values["ts"] = micros(span.start);
+    event.values["dur"] = duration_cast<microseconds>(span.duration).count();
+    event.values["pid"] = 0;
+    event.values["tid"] = thread;
+    event.values["args"] = args;
+
+    events.values.push_back(event);
+
+    // Draw an arrow from the parent to this span, if the parent is
+    // still recorded. The arrow starts when the event was enqueued,
+    // which is within the parent unless the event was deferred.
+    Option<const std::pair<size_t, Span>*> parent = index.get(span.parent);
+    if (parent.isSome()) {
+      const size_t parentThread = parent.get()->first;
+      const Span& parentSpan = parent.get()->second;
+
+      int64_t start = micros(parentSpan.start);
+      int64_t end = start +
+        duration_cast<microseconds>(parentSpan.duration).count();
+
+      JSON::Object from;
+      from.values["name"] = "enqueue";
+      from.values["cat"] = "libprocess";
+      from.values["ph"] = "s";
+      from.values["id"] = span.id;
+      from.values["ts"] = std::min(std::max(micros(span.enqueued), start), end);
+      from.values["pid"] = 0;
+      from.values["tid"] = parentThread;
+
+      JSON::Object to;
+      to.values["name"] = "enqueue";
+      to.values["cat"] = "libprocess";
+      to.values["ph"] = "f";
+      to.values["bp"] = "e";
+      to.values["id"] = span.id;
+      to.values["ts"] = micros(span.start);
+      to.values["pid"] = 0;
+      to.values["tid"] = thread;
+
+      events.values.push_back(from);
+      events.values.push_back(to);
+    }
+  }
+
+  JSON::Object object;
+  object.values["traceEvents"] = events;
+  object.values["displayTimeUnit"] = "ms";
+
+  return object;
+}
+
+} // namespace internal {
+} // namespace trace {
+} // namespace process {
@@ -0,0 +1,73 @@
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License
+
+#ifndef __PROCESS_SRC_TRACE_HPP__
+#define __PROCESS_SRC_TRACE_HPP__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <chrono>
+#include <string>
+
+#include <process/event.hpp>
+#include <process/pid.hpp>
+#include <process/trace.hpp>
+
+#include <stout/json.hpp>
+
+namespace process {
+namespace trace {
+namespace internal {
+
+// A span recorded for serving an event, see `process/trace.hpp`.
+struct Span
+{
+  // Assigns a new ID to the span of serving 'event' by 'pid'.
+  Span(const std::string& name, const UPID& pid, const Event& event);
+
+  uint64_t id;
+  uint64_t parent;
+
+  // The name of the message, or the kind of the event otherwise.
+  std::string name;
+  std::string process;
+
+  std::chrono::steady_clock::time_point enqueued;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::nanoseconds duration;
+};
+
+
+// Enables recording spans, keeping the last 'capacity' spans per
+// thread. Must be called before the worker threads are started.
+// Calling this again changes the capacity, including shrinking it, in
+// which case a thread drops its oldest spans the next time it records
+// a span.
+void enable(size_t capacity);
+
+
+bool enabled();
+
+
+// Records a finished span in the buffer of the calling thread.
+void record(Span&& span);
+
+
+// Returns the recorded spans in the Chrome trace event format.
+JSON::Object dump();
+
+} // namespace internal {
+} // namespace trace {
+} // namespace process {
+
+#endif // __PROCESS_SRC_TRACE_HPP__
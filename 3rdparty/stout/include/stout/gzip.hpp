@@ -25,7 +25,6 @@
 
 
 // Compression utilities.
-// TODO(bmahler): Provide streaming compression as well.
 namespace gzip {
 
 namespace internal {
@@ -169,6 +168,126 @@ private:
 };
 
 
+// Provides the ability to incrementally compress a stream of input
+// data, e.g., to compress a large body in chunks rather than all at
+// once. The compression level should be within the range [-1, 9], see
+// `compress()` below.
+class Compressor
+{
+public:
+  explicit Compressor(int level = Z_DEFAULT_COMPRESSION)
+    : _finished(false)
+  {
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    stream.next_in = Z_NULL;
+    stream.avail_in = 0;
+
+    int code = deflateInit2(
+        &stream,
+        level,          // Compression level.
+        Z_DEFLATED,     // Compression method.
+        MAX_WBITS + 16, // Zlib magic for gzip compression / decompression.
+        8,              // Default memLevel value.
+        Z_DEFAULT_STRATEGY);
+
+    if (code != Z_OK) {
+      Error error = internal::GzipError("Failed to deflateInit2", stream, code);
+      ABORT(error.message);
+    }
+  }
+
+  Compressor(const Compressor&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+
+  ~Compressor()
+  {
+    // NOTE: `deflateEnd` returns `Z_DATA_ERROR` if the stream was
+    // never finished, which is fine since we're discarding it anyway.
+    int code = deflateEnd(&stream);
+    if (code != Z_OK && code != Z_DATA_ERROR) {
+      ABORT("Failed to deflateEnd");
+    }
+  }
+
+  // Returns the compressed data that is ready for the provided chunk
+  // of input, which may be empty since zlib buffers data internally,
+  // or an Error if compression fails.
+  Try<std::string> compress(const char* data, size_t length)
+  {
+    if (_finished) {
+      return Error("Stream is already finished");
+    }
+
+    return _compress(data, length, Z_NO_FLUSH);
+  }
+
+  Try<std::string> compress(const std::string& decompressed)
+  {
+    return compress(decompressed.data(), decompressed.length());
+  }
+
+  // Finishes the stream and returns the remaining compressed data.
+  Try<std::string> finish()
+  {
+    if (_finished) {
+      return Error("Stream is already finished");
+    }
+
+    Try<std::string> result = _compress(nullptr, 0, Z_FINISH);
+
+    _finished = true;
+
+    return result;
+  }
+
+  // Returns whether the compression stream is finished.
+  bool finished() const
+  {
+    return _finished;
+  }
+
+private:
+  Try<std::string> _compress(const char* data, size_t length, int flush)
+  {
+    stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(data));
+    stream.avail_in = static_cast<uInt>(length);
+
+    // Build up the compressed result.
+    Bytef buffer[GZIP_BUFFER_SIZE];
+    std::string result;
+
+    int code;
+    do {
+      stream.next_out = buffer;
+      stream.avail_out = GZIP_BUFFER_SIZE;
+
+      code = deflate(&stream, flush);
+
+      if (code != Z_OK && code != Z_STREAM_END && code != Z_BUF_ERROR) {
+        return internal::GzipError("Failed to deflate", stream, code);
+      }
+
+      // Consume output and reset the buffer.
+      result.append(
+          reinterpret_cast<char*>(buffer),
+          GZIP_BUFFER_SIZE - stream.avail_out);
+
+      // Keep going while zlib fills up the whole buffer since it may
+      // have more output pending, and until the stream has ended if
+      // we are finishing it.
+    } while (stream.avail_out == 0 ||
+             (flush == Z_FINISH && code != Z_STREAM_END));
+
+    return result;
+  }
+
+  z_stream_s stream;
+  bool _finished;
+};
+
+
 // Returns a gzip compressed version of the provided string.
 // The compression level should be within the range [-1, 9].
 // See zlib.h:
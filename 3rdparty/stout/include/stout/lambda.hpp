@@ -13,9 +13,13 @@
 #ifndef __STOUT_LAMBDA_HPP__
 #define __STOUT_LAMBDA_HPP__
 
+#include <stdint.h>
+
 #include <algorithm>
+#include <cstddef>
 #include <functional>
 #include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -405,11 +409,14 @@ struct Invoke<void>
 // This is similar to `std::function`, but it can only be called once.
 // The "called once" semantics is enforced by having rvalue-ref qualifier
 // on `operator()`, so instances of `CallableOnce` must be `std::move`'d
-// in order to be invoked. Similar to `std::function`, this has heap
-// allocation overhead due to type erasure.
+// in order to be invoked. Similar to `std::function`, this uses type
+// erasure.
 //
-// Note: Heap allocation can be avoided in some cases by implementing
-// small buffer optimization. This is currently not implemented.
+// To avoid the overhead of a heap allocation for small callable
+// objects (e.g., most lambdas and partially applied functions created
+// by `dispatch` and `defer`) we implement a small buffer optimization:
+// callable objects that fit into `BUFFER_SIZE` bytes (and can be
+// moved without throwing) are stored inline.
 template <typename F>
 class CallableOnce;
 
@@ -429,12 +436,34 @@ public:
                  R>::value),
           int>::type = 0>
   CallableOnce(F&& f)
-    : f(new CallableFn<typename std::decay<F>::type>(std::forward<F>(f))) {}
+  {
+    typedef CallableFn<typename std::decay<F>::type> Fn;
+
+    this->f = create<Fn>(
+        std::forward<F>(f), std::integral_constant<bool, Fn::INLINE>());
+  }
+
+  CallableOnce(CallableOnce&& that) noexcept
+  {
+    move(std::move(that));
+  }
 
-  CallableOnce(CallableOnce&&) = default;
   CallableOnce(const CallableOnce&) = delete;
 
-  CallableOnce& operator=(CallableOnce&&) = default;
+  ~CallableOnce()
+  {
+    reset();
+  }
+
+  CallableOnce& operator=(CallableOnce&& that) noexcept
+  {
+    if (this != &that) {
+      reset();
+      move(std::move(that));
+    }
+    return *this;
+  }
+
   CallableOnce& operator=(const CallableOnce&) = delete;
 
   R operator()(Args... args) &&
@@ -444,15 +473,32 @@ public:
   }
 
 private:
+  // Size of the inline storage, chosen so that the partially applied
+  // functions created by most `dispatch` and `defer` calls fit.
+  static constexpr size_t BUFFER_SIZE = 8 * sizeof(void*);
+
+  typedef typename std::aligned_storage<
+      BUFFER_SIZE, alignof(std::max_align_t)>::type Storage;
+
   struct Callable
   {
     virtual ~Callable() = default;
     virtual R operator()(Args&&...) && = 0;
+
+    // Move constructs this callable into `storage`. Only invoked for
+    // callables that are stored inline.
+    virtual Callable* move(Storage* storage) && noexcept = 0;
   };
 
   template <typename F>
   struct CallableFn : Callable
   {
+    // Whether or not this callable gets stored inline.
+    static constexpr bool INLINE =
+      sizeof(F) <= BUFFER_SIZE - sizeof(Callable) &&
+      alignof(F) <= alignof(Storage) &&
+      std::is_nothrow_move_constructible<F>::value;
+
     F f;
 
     CallableFn(const F& f) : f(f) {}
@@ -462,9 +508,75 @@ private:
     {
       return internal::Invoke<R>{}(std::move(f), std::forward<Args>(args)...);
     }
+
+    virtual Callable* move(Storage* storage) && noexcept
+    {
+      return std::move(*this).move(
+          storage, std::integral_constant<bool, INLINE>());
+    }
+
+    // NOTE: Inline and heap storage are chosen at compile time so that
+    // the placement of callables that don't fit into the storage never
+    // gets compiled (which GCC would warn about).
+    Callable* move(Storage* storage, std::true_type) && noexcept
+    {
+      return new (storage) CallableFn(std::move(f));
+    }
+
+    Callable* move(Storage* storage, std::false_type) && noexcept
+    {
+      LOG(FATAL) << "Callables stored on the heap are never moved";
+      return nullptr;
+    }
   };
 
-  std::unique_ptr<Callable> f;
+  template <typename Fn, typename F>
+  Callable* create(F&& f, std::true_type)
+  {
+    return new (&storage) Fn(std::forward<F>(f));
+  }
+
+  template <typename Fn, typename F>
+  Callable* create(F&& f, std::false_type)
+  {
+    return new Fn(std::forward<F>(f));
+  }
+
+  // Returns true if `f` is stored inline.
+  bool local() const
+  {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(f);
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(&storage);
+    return address >= begin && address < begin + sizeof(storage);
+  }
+
+  void move(CallableOnce&& that) noexcept
+  {
+    if (that.f == nullptr) {
+      f = nullptr;
+    } else if (that.local()) {
+      f = std::move(*that.f).move(&storage);
+      that.reset();
+    } else {
+      f = that.f;
+      that.f = nullptr;
+    }
+  }
+
+  void reset()
+  {
+    if (f != nullptr) {
+      if (local()) {
+        f->~Callable();
+      } else {
+        delete f;
+      }
+      f = nullptr;
+    }
+  }
+
+  Callable* f = nullptr;
+  Storage storage;
 };
 
 } // namespace lambda {
@@ -99,4 +99,51 @@ TEST(GzipTest, Decompressor)
 
   ASSERT_EQ(s, decompressed);
 }
+
+
+TEST(GzipTest, Compressor)
+{
+  // Test with a 1MB random string, compressed 1KB at a time.
+  string s;
+  while (s.length() < (1024 * 1024)) {
+    s.append(1, ' ' + (rand() % ('~' - ' ')));
+  }
+
+  gzip::Compressor compressor(Z_BEST_SPEED);
+
+  string compressed;
+  size_t i = 0;
+
+  while (i < s.size()) {
+    size_t chunkSize = 1024;
+
+    Try<string> compressedChunk = compressor.compress(s.substr(i, chunkSize));
+    ASSERT_SOME(compressedChunk);
+    compressed += compressedChunk.get();
+
+    i += chunkSize;
+  }
+
+  Try<string> finished = compressor.finish();
+  ASSERT_SOME(finished);
+  compressed += finished.get();
+
+  EXPECT_TRUE(compressor.finished());
+  EXPECT_ERROR(compressor.compress(s));
+  EXPECT_ERROR(compressor.finish());
+
+  Try<string> decompressed = gzip::decompress(compressed);
+  ASSERT_SOME(decompressed);
+  ASSERT_EQ(s, decompressed.get());
+
+  // An empty stream is still a valid gzip stream.
+  gzip::Compressor empty;
+
+  finished = empty.finish();
+  ASSERT_SOME(finished);
+
+  decompressed = gzip::decompress(finished.get());
+  ASSERT_SOME(decompressed);
+  ASSERT_EQ("", decompressed.get());
+}
 #endif // HAVE_LIBZ
@@ -10,7 +10,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License
 
+#include <array>
 #include <list>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -250,3 +252,87 @@ TEST(PartialTest, Test)
   mp2();
   std::move(mp2)();
 }
+
+
+// Counts the number of live instances so that we can check that
+// `CallableOnce` neither leaks nor double destroys callables.
+struct Counted
+{
+  Counted(int* count) : count(count) { (*count)++; }
+  Counted(const Counted& that) : count(that.count) { (*count)++; }
+  Counted(Counted&& that) noexcept : count(that.count) { (*count)++; }
+  ~Counted() { (*count)--; }
+
+  int* count;
+};
+
+
+TEST(CallableOnceTest, Small)
+{
+  int count = 0;
+
+  {
+    Counted counted(&count);
+
+    lambda::CallableOnce<int(int)> f(
+        [counted](int i) { return i + 1; });
+
+    EXPECT_EQ(2, count);
+
+    // Move the callable around, the number of live instances should
+    // not change.
+    lambda::CallableOnce<int(int)> g(std::move(f));
+    EXPECT_EQ(2, count);
+
+    lambda::CallableOnce<int(int)> h([](int i) { return i; });
+    h = std::move(g);
+    EXPECT_EQ(2, count);
+
+    EXPECT_EQ(42, std::move(h)(41));
+  }
+
+  EXPECT_EQ(0, count);
+}
+
+
+TEST(CallableOnceTest, Large)
+{
+  int count = 0;
+
+  {
+    Counted counted(&count);
+
+    // A callable that is too large to be stored inline.
+    std::array<int, 128> data;
+    data.fill(1);
+
+    lambda::CallableOnce<int()> f([counted, data]() {
+      return std::accumulate(data.begin(), data.end(), 0);
+    });
+
+    EXPECT_EQ(2, count);
+
+    lambda::CallableOnce<int()> g(std::move(f));
+    EXPECT_EQ(2, count);
+
+    lambda::CallableOnce<int()> h([]() { return 0; });
+    h = std::move(g);
+    EXPECT_EQ(2, count);
+
+    EXPECT_EQ(128, std::move(h)());
+  }
+
+  EXPECT_EQ(0, count);
+}
+
+
+TEST(CallableOnceTest, MoveOnly)
+{
+  lambda::CallableOnce<bool()> f(lambda::partial(
+      [](OnlyMoveable&& m) { return m.valid; },
+      OnlyMoveable(1)));
+
+  lambda::CallableOnce<bool()> g(std::move(f));
+
+  EXPECT_TRUE(std::move(g)());
+}
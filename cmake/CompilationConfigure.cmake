@@ -94,6 +94,16 @@ option(
   "Build libprocess with lock free run queue."
   FALSE)
 
+option(
+  ENABLE_WORK_STEALING_RUN_QUEUE
+  "Build libprocess with work stealing run queue."
+  FALSE)
+
+option(
+  ENABLE_IO_URING
+  "Build libprocess with io_uring based file I/O."
+  FALSE)
+
 option(
   ENABLE_LOCK_FREE_EVENT_QUEUE
   "Build libprocess with lock free event queue."
@@ -218,6 +228,12 @@ if (ENABLE_SSL AND (NOT ENABLE_LIBEVENT))
     "'ENABLE_SSL' currently requires 'ENABLE_LIBEVENT'.")
 endif ()
 
+if (ENABLE_IO_URING AND (NOT LINUX))
+  message(
+    FATAL_ERROR
+    "'ENABLE_IO_URING' is only supported on Linux.")
+endif ()
+
 
 # SYSTEM CHECKS.
 ################
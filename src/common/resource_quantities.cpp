@@ -0,0 +1,257 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "common/resource_quantities.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+#include <mesos/values.hpp>
+
+#include <stout/foreach.hpp>
+
+using std::pair;
+using std::string;
+
+namespace mesos {
+namespace internal {
+
+// NOTE: This conversion must match the one used by the arithmetic of
+// `Value::Scalar` (see "common/values.cpp"), so that the quantities
+// agree with the corresponding `Resources`.
+static int64_t convertToFixed(double floatValue)
+{
+  return std::llround(floatValue * 1000);
+}
+
+
+static bool compareName(const pair<string, int64_t>& left, const string& name)
+{
+  return left.first < name;
+}
+
+
+ResourceQuantities ResourceQuantities::fromScalarResources(
+    const Resources& resources)
+{
+  ResourceQuantities result;
+
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      result.add(resource.name(), convertToFixed(resource.scalar().value()));
+    }
+  }
+
+  return result;
+}
+
+
+ResourceQuantities::ResourceQuantities()
+{
+  fixed.fill(0);
+}
+
+
+bool ResourceQuantities::empty() const
+{
+  return others.empty() &&
+         std::all_of(fixed.begin(), fixed.end(), [](int64_t quantity) {
+           return quantity == 0;
+         });
+}
+
+
+Value::Scalar ResourceQuantities::get(const string& name) const
+{
+  Value::Scalar scalar;
+
+  const size_t index = slot(name);
+
+  if (index != SLOTS) {
+    scalar.set_value(toDouble(fixed[index]));
+    return scalar;
+  }
+
+  auto it = std::lower_bound(others.begin(), others.end(), name, compareName);
+
+  scalar.set_value(
+      it != others.end() && it->first == name
+        ? toDouble(it->second)
+        : 0.0);
+
+  return scalar;
+}
+
+
+bool ResourceQuantities::contains(const ResourceQuantities& that) const
+{
+  // NOTE: We deliberately avoid short-circuiting here so that the
+  // loop over the fixed slots can be vectorized.
+  bool result = true;
+  for (size_t i = 0; i < SLOTS; ++i) {
+    result &= fixed[i] >= that.fixed[i];
+  }
+
+  if (!result) {
+    return false;
+  }
+
+  // Both sides are ordered by name, so a single merge pass suffices.
+  auto it = others.begin();
+
+  foreach (const auto& quantity, that.others) {
+    it = std::lower_bound(it, others.end(), quantity.first, compareName);
+
+    if (it == others.end() ||
+        it->first != quantity.first ||
+        it->second < quantity.second) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool ResourceQuantities::operator==(const ResourceQuantities& that) const
+{
+  return fixed == that.fixed && others == that.others;
+}
+
+
+bool ResourceQuantities::operator!=(const ResourceQuantities& that) const
+{
+  return !(*this == that);
+}
+
+
+ResourceQuantities ResourceQuantities::operator+(
+    const ResourceQuantities& that) const
+{
+  ResourceQuantities result = *this;
+  result += that;
+  return result;
+}
+
+
+ResourceQuantities ResourceQuantities::operator-(
+    const ResourceQuantities& that) const
+{
+  ResourceQuantities result = *this;
+  result -= that;
+  return result;
+}
+
+
+ResourceQuantities& ResourceQuantities::operator+=(
+    const ResourceQuantities& that)
+{
+  for (size_t i = 0; i < SLOTS; ++i) {
+    fixed[i] += that.fixed[i];
+  }
+
+  foreach (const auto& quantity, that.others) {
+    add(quantity.first, quantity.second);
+  }
+
+  return *this;
+}
+
+
+ResourceQuantities& ResourceQuantities::operator-=(
+    const ResourceQuantities& that)
+{
+  for (size_t i = 0; i < SLOTS; ++i) {
+    fixed[i] = std::max<int64_t>(fixed[i] - that.fixed[i], 0);
+  }
+
+  foreach (const auto& quantity, that.others) {
+    auto it = std::lower_bound(
+        others.begin(), others.end(), quantity.first, compareName);
+
+    if (it != others.end() && it->first == quantity.first) {
+      if (it->second > quantity.second) {
+        it->second -= quantity.second;
+      } else {
+        others.erase(it);
+      }
+    }
+  }
+
+  return *this;
+}
+
+
+size_t ResourceQuantities::slot(const string& name)
+{
+  for (size_t i = 0; i < SLOTS; ++i) {
+    if (name == ResourceQuantities::name(static_cast<Slot>(i))) {
+      return i;
+    }
+  }
+
+  return SLOTS;
+}
+
+
+void ResourceQuantities::add(const string& name, int64_t quantity)
+{
+  if (quantity <= 0) {
+    return;
+  }
+
+  const size_t index = slot(name);
+
+  if (index != SLOTS) {
+    fixed[index] += quantity;
+    return;
+  }
+
+  auto it = std::lower_bound(others.begin(), others.end(), name, compareName);
+
+  if (it != others.end() && it->first == name) {
+    it->second += quantity;
+  } else {
+    others.emplace(it, name, quantity);
+  }
+}
+
+
+std::ostream& operator<<(
+    std::ostream& stream,
+    const ResourceQuantities& quantities)
+{
+  bool first = true;
+
+  quantities.foreachQuantity([&](const string& name, double quantity) {
+    if (!first) {
+      stream << ";";
+    }
+
+    stream << name << ":" << quantity;
+    first = false;
+  });
+
+  return stream;
+}
+
+} // namespace internal {
+} // namespace mesos {
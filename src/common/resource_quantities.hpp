@@ -0,0 +1,179 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef __COMMON_RESOURCE_QUANTITIES_HPP__
+#define __COMMON_RESOURCE_QUANTITIES_HPP__
+
+#include <stdint.h>
+
+#include <array>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
+
+namespace mesos {
+namespace internal {
+
+// An aggregate of scalar resource quantities by name, e.g.,
+// "cpus:10;mem:2048". Unlike `Resources`, all other metadata of the
+// resources (reservations, revocability, disk info, etc.) is dropped,
+// which makes the arithmetic cheap enough for the hot paths of the
+// allocator (e.g., the sorter totals, DRF shares and quota headroom).
+//
+// Quantities are stored in the same fixed-point representation that
+// `Value::Scalar` arithmetic uses (three decimal digits). The well
+// known resources have a fixed slot in a small array, so that adding,
+// subtracting and comparing them are loops the compiler can vectorize.
+// Quantities of other resources are kept by name, in order.
+//
+// Like `Resources`, quantities are never negative: subtracting more
+// than is present leaves a quantity of zero, and zero quantities are
+// considered absent.
+class ResourceQuantities
+{
+public:
+  // The resources with a fixed slot.
+  enum Slot
+  {
+    CPUS,
+    MEM,
+    DISK,
+    GPUS,
+    SLOTS // Number of slots.
+  };
+
+  // Returns the aggregated quantities of the scalar resources. Any
+  // non-scalar resources are ignored.
+  static ResourceQuantities fromScalarResources(const Resources& resources);
+
+  ResourceQuantities();
+
+  bool empty() const;
+
+  // Returns the quantity of the named resource, which is zero if the
+  // resource is absent.
+  Value::Scalar get(const std::string& name) const;
+
+  // Returns the quantity of the resource in the given fixed slot.
+  double get(Slot slot) const
+  {
+    return toDouble(fixed[slot]);
+  }
+
+  // Returns true if each of the quantities of `that` is less than or
+  // equal to the corresponding quantity here.
+  bool contains(const ResourceQuantities& that) const;
+
+  // Calls `f(name, quantity)` for each present resource.
+  template <typename F>
+  void foreachQuantity(F&& f) const
+  {
+    for (size_t i = 0; i < SLOTS; ++i) {
+      if (fixed[i] != 0) {
+        f(name(static_cast<Slot>(i)), toDouble(fixed[i]));
+      }
+    }
+
+    for (const auto& quantity : others) {
+      f(quantity.first, toDouble(quantity.second));
+    }
+  }
+
+  // Calls `f(name, quantity, thatQuantity)` for each present resource,
+  // where `thatQuantity` is the quantity of the same resource in `that`
+  // (zero if absent). Both are walked in order, so that no lookups by
+  // name are needed, e.g., to compute the DRF share of an allocation.
+  template <typename F>
+  void foreachQuantity(const ResourceQuantities& that, F&& f) const
+  {
+    for (size_t i = 0; i < SLOTS; ++i) {
+      if (fixed[i] != 0) {
+        f(name(static_cast<Slot>(i)),
+          toDouble(fixed[i]),
+          toDouble(that.fixed[i]));
+      }
+    }
+
+    auto it = that.others.begin();
+
+    for (const auto& quantity : others) {
+      while (it != that.others.end() && it->first < quantity.first) {
+        ++it;
+      }
+
+      f(quantity.first,
+        toDouble(quantity.second),
+        it != that.others.end() && it->first == quantity.first
+          ? toDouble(it->second)
+          : 0.0);
+    }
+  }
+
+  bool operator==(const ResourceQuantities& that) const;
+  bool operator!=(const ResourceQuantities& that) const;
+
+  ResourceQuantities operator+(const ResourceQuantities& that) const;
+  ResourceQuantities operator-(const ResourceQuantities& that) const;
+  ResourceQuantities& operator+=(const ResourceQuantities& that);
+  ResourceQuantities& operator-=(const ResourceQuantities& that);
+
+  // Returns the name of the resource in the given fixed slot.
+  static const std::string& name(Slot slot)
+  {
+    static const std::string names[SLOTS] = {"cpus", "mem", "disk", "gpus"};
+    return names[slot];
+  }
+
+private:
+  // Returns the slot of the named resource, or `SLOTS` if the resource
+  // has no fixed slot.
+  static size_t slot(const std::string& name);
+
+  // Converts a fixed-point quantity back to floating point.
+  //
+  // NOTE: This must match the conversion used by the arithmetic of
+  // `Value::Scalar` (see "common/values.cpp"), so that the quantities
+  // agree with the corresponding `Resources`.
+  static double toDouble(int64_t fixedValue)
+  {
+    double quotient = static_cast<double>(fixedValue / 1000);
+    double remainder = static_cast<double>(fixedValue % 1000) / 1000.0;
+
+    return quotient + remainder;
+  }
+
+  void add(const std::string& name, int64_t quantity);
+
+  std::array<int64_t, SLOTS> fixed;
+
+  // Quantities of the resources without a fixed slot, ordered by name.
+  // Zero quantities are not stored.
+  std::vector<std::pair<std::string, int64_t>> others;
+};
+
+
+std::ostream& operator<<(
+    std::ostream& stream,
+    const ResourceQuantities& quantities);
+
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __COMMON_RESOURCE_QUANTITIES_HPP__
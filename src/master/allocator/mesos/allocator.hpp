@@ -44,6 +44,10 @@ public:
   // Factory to allow for typed tests.
   static Try<mesos::allocator::Allocator*> create();
 
+  // Factory for allocator processes that compute an allocation with
+  // the given number of threads, see `--allocation_threads`.
+  static Try<mesos::allocator::Allocator*> create(size_t allocationThreads);
+
   ~MesosAllocator();
 
   void initialize(
@@ -172,7 +176,7 @@ public:
       const std::vector<WeightInfo>& weightInfos);
 
 private:
-  MesosAllocator();
+  explicit MesosAllocator(AllocatorProcess* _process);
   MesosAllocator(const MesosAllocator&); // Not copyable.
   MesosAllocator& operator=(const MesosAllocator&); // Not assignable.
 
@@ -325,15 +329,26 @@ Try<mesos::allocator::Allocator*>
 MesosAllocator<AllocatorProcess>::create()
 {
   mesos::allocator::Allocator* allocator =
-    new MesosAllocator<AllocatorProcess>();
+    new MesosAllocator<AllocatorProcess>(new AllocatorProcess());
+  return CHECK_NOTNULL(allocator);
+}
+
+
+template <typename AllocatorProcess>
+Try<mesos::allocator::Allocator*>
+MesosAllocator<AllocatorProcess>::create(size_t allocationThreads)
+{
+  mesos::allocator::Allocator* allocator =
+    new MesosAllocator<AllocatorProcess>(
+        new AllocatorProcess(allocationThreads));
   return CHECK_NOTNULL(allocator);
 }
 
 
 template <typename AllocatorProcess>
-MesosAllocator<AllocatorProcess>::MesosAllocator()
+MesosAllocator<AllocatorProcess>::MesosAllocator(AllocatorProcess* _process)
+  : process(_process)
 {
-  process = new AllocatorProcess();
   process::spawn(process);
 }
 
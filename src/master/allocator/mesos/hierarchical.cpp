@@ -17,8 +17,13 @@
 #include "master/allocator/mesos/hierarchical.hpp"
 
 #include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <numeric>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -27,6 +32,7 @@
 #include <mesos/type_utils.hpp>
 
 #include <process/after.hpp>
+#include <process/clock.hpp>
 #include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/event.hpp>
@@ -41,6 +47,7 @@
 #include <stout/stringify.hpp>
 
 #include "common/protobuf_utils.hpp"
+#include "common/resource_quantities.hpp"
 
 using std::set;
 using std::string;
@@ -49,6 +56,7 @@ using std::vector;
 using mesos::allocator::InverseOfferStatus;
 
 using process::after;
+using process::Clock;
 using process::Continue;
 using process::ControlFlow;
 using process::Failure;
@@ -56,6 +64,7 @@ using process::Future;
 using process::loop;
 using process::Owned;
 using process::PID;
+using process::Time;
 using process::Timeout;
 
 using mesos::internal::protobuf::framework::Capabilities;
@@ -133,6 +142,117 @@ private:
 };
 
 
+// A fixed set of threads that run the workers of a parallel allocation
+// (see `HierarchicalAllocatorProcess::__allocate`), so that threads are
+// not created and joined on every allocation cycle.
+class AllocationWorkers
+{
+public:
+  explicit AllocationWorkers(size_t count)
+  {
+    for (size_t i = 0; i < count; i++) {
+      threads.emplace_back([this]() { run(); });
+    }
+  }
+
+  ~AllocationWorkers()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+
+    ready.notify_all();
+
+    foreach (std::thread& thread, threads) {
+      thread.join();
+    }
+  }
+
+  // Calls `task(i)` for each `i` in [0, count) and returns once all of
+  // the calls have returned. The calling thread takes part, starting
+  // with `task(0)`, so this does not depend on the number of threads.
+  void execute(size_t count, const std::function<void(size_t)>& task)
+  {
+    if (count == 0) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      CHECK(current == nullptr);
+
+      current = &task;
+      next = 1;
+      total = count;
+      pending = count - 1;
+    }
+
+    ready.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (next < total) {
+      size_t i = next++;
+
+      lock.unlock();
+      task(i);
+      lock.lock();
+
+      --pending;
+    }
+
+    done.wait(lock, [this]() { return pending == 0; });
+
+    current = nullptr;
+    next = total = 0;
+  }
+
+private:
+  void run()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true) {
+      ready.wait(lock, [this]() { return stopping || next < total; });
+
+      if (stopping) {
+        return;
+      }
+
+      size_t i = next++;
+      const std::function<void(size_t)>& task = *current;
+
+      lock.unlock();
+      task(i);
+      lock.lock();
+
+      if (--pending == 0) {
+        done.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable ready;
+  std::condition_variable done;
+
+  // The tasks of the ongoing `execute`, if any: `next` is the index of
+  // the next task to run, and `pending` the number of tasks other than
+  // the first that have not returned yet.
+  const std::function<void(size_t)>* current = nullptr;
+  size_t next = 0;
+  size_t total = 0;
+  size_t pending = 0;
+
+  bool stopping = false;
+};
+
+
 HierarchicalAllocatorProcess::Framework::Framework(
     const FrameworkInfo& frameworkInfo,
     const set<string>& _suppressedRoles,
@@ -143,6 +263,14 @@ HierarchicalAllocatorProcess::Framework::Framework(
     active(_active) {}
 
 
+HierarchicalAllocatorProcess::~HierarchicalAllocatorProcess()
+{
+  foreachvalue (const OfferFilterExpiry& expiry, offerFilterExpiries) {
+    delete expiry.offerFilter;
+  }
+}
+
+
 void HierarchicalAllocatorProcess::initialize(
     const Duration& _allocationInterval,
     const lambda::function<
@@ -166,6 +294,10 @@ void HierarchicalAllocatorProcess::initialize(
   initialized = true;
   paused = false;
 
+  if (allocationThreads > 1) {
+    workers.reset(new AllocationWorkers(allocationThreads - 1));
+  }
+
   // Resources for quota'ed roles are allocated separately and prior to
   // non-quota'ed roles, hence a dedicated sorter for quota'ed roles is
   // necessary.
@@ -322,6 +454,8 @@ void HierarchicalAllocatorProcess::removeFramework(
       continue;
     }
 
+    // NOTE: We copy the allocation since untracking the resources
+    // below removes them from the framework sorter.
     hashmap<SlaveID, Resources> allocation =
       frameworkSorters.at(role)->allocation(frameworkId.value());
 
@@ -336,9 +470,9 @@ void HierarchicalAllocatorProcess::removeFramework(
   }
 
   // Do not delete the filters contained in this
-  // framework's `offerFilters` hashset yet, see comments in
+  // framework's `offerFilters` yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
-  // HierarchicalAllocatorProcess::expire.
+  // HierarchicalAllocatorProcess::_expireOfferFilters.
   frameworks.erase(frameworkId);
 
   LOG(INFO) << "Removed framework " << frameworkId;
@@ -396,9 +530,9 @@ void HierarchicalAllocatorProcess::deactivateFramework(
   framework.active = false;
 
   // Do not delete the filters contained in this
-  // framework's `offerFilters` hashset yet, see comments in
+  // framework's `offerFilters` yet, see comments in
   // HierarchicalAllocatorProcess::reviveOffers and
-  // HierarchicalAllocatorProcess::expire.
+  // HierarchicalAllocatorProcess::_expireOfferFilters.
   framework.offerFilters.clear();
   framework.inverseOfferFilters.clear();
 
@@ -529,6 +663,10 @@ void HierarchicalAllocatorProcess::addSlave(
   // See comment at `quotaRoleSorter` declaration regarding non-revocable.
   quotaRoleSorter->add(slaveId, total.nonRevocable());
 
+  // The offer filters are not removed along with an agent, so some
+  // might remain from before the agent was removed and re-added.
+  updateOfferFilters(slaveId);
+
   foreachpair (const FrameworkID& frameworkId,
                const Resources& allocation,
                used) {
@@ -602,9 +740,9 @@ void HierarchicalAllocatorProcess::removeSlave(
   allocationCandidates.erase(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
-  // this slave, that will occur when the delayed
-  // HierarchicalAllocatorProcess::expire gets invoked (or the framework
-  // that applied the filters gets removed).
+  // this slave, that will occur when the filters expire in
+  // HierarchicalAllocatorProcess::_expireOfferFilters (they are
+  // removed earlier if the framework that applied them gets removed).
 
   LOG(INFO) << "Removed agent " << slaveId;
 }
@@ -727,7 +865,7 @@ void HierarchicalAllocatorProcess::removeFilters(const SlaveID& slaveId)
 
     // Need a typedef here, otherwise the preprocessor gets confused
     // by the comma in the template argument list.
-    typedef hashmap<SlaveID, hashset<OfferFilter*>> Filters;
+    typedef hashmap<SlaveID, Framework::OfferFilters> Filters;
     foreachpair(const string& role,
                 Filters& filters,
                 framework.offerFilters) {
@@ -1247,8 +1385,15 @@ void HierarchicalAllocatorProcess::recoverResources(
     unallocated.unallocate();
 
     OfferFilter* offerFilter = new RefusedOfferFilter(unallocated);
-    frameworks.at(frameworkId)
-      .offerFilters[role][slaveId].insert(offerFilter);
+
+    Framework::OfferFilters& offerFilters =
+      frameworks.at(frameworkId).offerFilters[role][slaveId];
+
+    offerFilters.filters.insert(offerFilter);
+
+    if (offerFilter->filter(slaves.at(slaveId).total)) {
+      offerFilters.refusingTotal.insert(offerFilter);
+    }
 
     // Expire the filter after both an `allocationInterval` and the
     // `timeout` have elapsed. This ensures that the filter does not
@@ -1256,28 +1401,25 @@ void HierarchicalAllocatorProcess::recoverResources(
     // see MESOS-4302 for more information.
     //
     // Because the next periodic allocation goes through a dispatch
-    // after `allocationInterval`, we do the same for `expire()`
-    // (with a helper `_expire()`) to achieve the above.
+    // after `allocationInterval`, we do the same for
+    // `expireOfferFilters()` (with a helper `_expireOfferFilters()`)
+    // to achieve the above.
     //
     // TODO(alexr): If we allocated upon resource recovery
     // (MESOS-3078), we would not need to increase the timeout here.
     timeout = std::max(allocationInterval, timeout.get());
 
-    // We need to disambiguate the function call to pick the correct
-    // `expire()` overload.
-    void (Self::*expireOffer)(
-        const FrameworkID&,
-        const string&,
-        const SlaveID&,
-        OfferFilter*) = &Self::expire;
-
-    delay(timeout.get(),
-          self(),
-          expireOffer,
-          frameworkId,
-          role,
-          slaveId,
-          offerFilter);
+    const Time deadline = Clock::now() + timeout.get();
+
+    offerFilterExpiries.emplace(
+        deadline,
+        OfferFilterExpiry{frameworkId, role, slaveId, offerFilter});
+
+    if (offerFilterExpiryTimer.isNone() ||
+        deadline < offerFilterExpiryTimer.get()) {
+      offerFilterExpiryTimer = deadline;
+      delay(timeout.get(), self(), &Self::expireOfferFilters);
+    }
   }
 }
 
@@ -1331,12 +1473,11 @@ void HierarchicalAllocatorProcess::reviveOffers(
     framework.suppressedRoles.erase(role);
   }
 
-  // We delete each actual `OfferFilter` when
-  // `HierarchicalAllocatorProcess::expire` gets invoked. If we delete the
+  // We delete each actual `OfferFilter` when it expires in
+  // `HierarchicalAllocatorProcess::_expireOfferFilters`. If we delete the
   // `OfferFilter` here it's possible that the same `OfferFilter` (i.e., same
-  // address) could get reused and `HierarchicalAllocatorProcess::expire`
-  // would expire that filter too soon. Note that this only works
-  // right now because ALL Filter types "expire".
+  // address) could get reused and would then be expired too soon. Note that
+  // this only works right now because ALL Filter types "expire".
 
   LOG(INFO) << "Revived offers for roles " << stringify(roles)
             << " of framework " << frameworkId;
@@ -1365,7 +1506,8 @@ void HierarchicalAllocatorProcess::setQuota(
 
   // Copy allocation information for the quota'ed role.
   if (roleSorter->contains(role)) {
-    hashmap<SlaveID, Resources> roleAllocation = roleSorter->allocation(role);
+    const hashmap<SlaveID, Resources>& roleAllocation =
+      roleSorter->allocation(role);
     foreachpair (
         const SlaveID& slaveId, const Resources& resources, roleAllocation) {
       // See comment at `quotaRoleSorter` declaration regarding non-revocable.
@@ -1657,7 +1799,7 @@ void HierarchicalAllocatorProcess::__allocate()
       getQuotaRoleAllocatedScalarQuantities(role);
 
     // Lastly subtract allocated reservations on each agent.
-    const hashmap<SlaveID, Resources> allocations =
+    const hashmap<SlaveID, Resources>& allocations =
       quotaRoleSorter->allocation(role);
 
     foreachvalue (const Resources& resources, allocations) {
@@ -1678,13 +1820,18 @@ void HierarchicalAllocatorProcess::__allocate()
   // Given the above, if a role has more reservations (which count towards
   // consumed quota) than quota guarantee, we don't need to hold back any
   // unreserved headroom for it.
-  Resources requiredHeadroom;
+  //
+  // NOTE: The headroom is tracked as `ResourceQuantities` rather than as
+  // `Resources`, since only the quantities by name matter and it is
+  // updated for every allocation made below.
+  ResourceQuantities requiredHeadroom;
   foreachpair (const string& role, const Quota& quota, quotas) {
     // We can safely subtract resources without checking inclusion. If the
     // minuend resource is less than the subtrahend resource, the result is an
     // empty resource.
-    requiredHeadroom += Resources(quota.info.guarantee()) -
-      rolesConsumedQuotaScalarQuantites.get(role).getOrElse(Resources());
+    requiredHeadroom += ResourceQuantities::fromScalarResources(
+        Resources(quota.info.guarantee()) -
+          rolesConsumedQuotaScalarQuantites.get(role).getOrElse(Resources()));
   }
 
   // We will allocate resources while ensuring that the required
@@ -1700,19 +1847,16 @@ void HierarchicalAllocatorProcess::__allocate()
   //                        unallocated reservations -
   //                        unallocated revocable resources
 
-  // NOTE: `totalScalarQuantities` omits dynamic reservation,
-  // persistent volume info, and allocation info. We additionally
-  // remove the static reservations here via `toUnreserved()`.
-  Resources availableHeadroom =
-    roleSorter->totalScalarQuantities().toUnreserved();
+  // NOTE: `ResourceQuantities` omit all metadata of the resources,
+  // including reservations, so there is no need for `toUnreserved()`.
+  ResourceQuantities availableHeadroom =
+    ResourceQuantities::fromScalarResources(
+        roleSorter->totalScalarQuantities());
 
   // Subtract allocated resources from the total.
   foreachkey (const string& role, roles) {
-    // NOTE: `totalScalarQuantities` omits dynamic reservation,
-    // persistent volume info, and allocation info. We additionally
-    // remove the static reservations here via `toUnreserved()`.
-    availableHeadroom -=
-      roleSorter->allocationScalarQuantities(role).toUnreserved();
+    availableHeadroom -= ResourceQuantities::fromScalarResources(
+        roleSorter->allocationScalarQuantities(role));
   }
 
   // Calculate total allocated reservations. Note that we need to ensure
@@ -1720,16 +1864,16 @@ void HierarchicalAllocatorProcess::__allocate()
   // we cannot simply loop over the reservations' roles.
   Resources totalAllocatedReservationScalarQuantities;
   foreachkey (const string& role, roles) {
-    hashmap<SlaveID, Resources> allocations;
+    const hashmap<SlaveID, Resources>* allocations;
     if (quotaRoleSorter->contains(role)) {
-      allocations = quotaRoleSorter->allocation(role);
+      allocations = &quotaRoleSorter->allocation(role);
     } else if (roleSorter->contains(role)) {
-      allocations = roleSorter->allocation(role);
+      allocations = &roleSorter->allocation(role);
     } else {
       continue; // This role has no allocation.
     }
 
-    foreachvalue (const Resources& resources, allocations) {
+    foreachvalue (const Resources& resources, *allocations) {
       // NOTE: `totalScalarQuantities` omits dynamic reservation,
       // persistent volume info, and allocation info. We additionally
       // remove the static reservations here via `toUnreserved()`.
@@ -1739,17 +1883,14 @@ void HierarchicalAllocatorProcess::__allocate()
   }
 
   // Subtract total unallocated reservations.
-  availableHeadroom -=
-    Resources::sum(reservationScalarQuantities) -
-    totalAllocatedReservationScalarQuantities;
+  availableHeadroom -= ResourceQuantities::fromScalarResources(
+      Resources::sum(reservationScalarQuantities) -
+      totalAllocatedReservationScalarQuantities);
 
   // Subtract revocable resources.
   foreachvalue (const Slave& slave, slaves) {
-    // NOTE: `totalScalarQuantities` omits dynamic reservation,
-    // persistent volume info, and allocation info. We additionally
-    // remove the static reservations here via `toUnreserved()`.
-    availableHeadroom -= slave.available().revocable()
-      .createStrippedScalarQuantity().toUnreserved();
+    availableHeadroom -= ResourceQuantities::fromScalarResources(
+        slave.available().revocable());
   }
 
   // Due to the two stages in the allocation algorithm and the nature of
@@ -1921,13 +2062,11 @@ void HierarchicalAllocatorProcess::__allocate()
           );
 
         // Allocation Limit = Available Headroom - Required Headroom
-        Resources headroomResourcesLimit = availableHeadroom - requiredHeadroom;
-
         hashmap<string, Value::Scalar> headroomScalarLimit;
-        foreach (const string& name, headroomResourcesLimit.names()) {
-          headroomScalarLimit[name] =
-            CHECK_NOTNONE(headroomResourcesLimit.get<Value::Scalar>(name));
-        }
+        (availableHeadroom - requiredHeadroom).foreachQuantity(
+            [&headroomScalarLimit](const string& name, double quantity) {
+              headroomScalarLimit[name].set_value(quantity);
+            });
 
         // If a resource type is absent in `headroomScalarLimit`, it means this
         // type of resource is already in quota headroom deficit and we make
@@ -2006,11 +2145,13 @@ void HierarchicalAllocatorProcess::__allocate()
         // role's guarantee should be subtracted. Allocation of reserved
         // resources or resources that this role has unset guarantee do not
         // affect `requiredHeadroom`.
-        requiredHeadroom -= newQuotaAllocation.createStrippedScalarQuantity();
+        requiredHeadroom -=
+          ResourceQuantities::fromScalarResources(newQuotaAllocation);
 
         // `availableHeadroom` counts total unreserved non-revocable resources
         // in the cluster.
-        availableHeadroom -= allocatedUnreserved;
+        availableHeadroom -=
+          ResourceQuantities::fromScalarResources(allocatedUnreserved);
 
         slave.allocated += toAllocate;
 
@@ -2027,149 +2168,196 @@ void HierarchicalAllocatorProcess::__allocate()
   // are not part of the headroom (and therefore can't be used to satisfy
   // quota guarantees).
 
-  foreach (const SlaveID& slaveId, slaveIds) {
-    foreach (const string& role, roleSorter->sort()) {
-      // In the second allocation stage, we only allocate
-      // for non-quota roles.
-      if (quotas.contains(role)) {
-        continue;
+  // The agents on which resources have been held back for the headroom.
+  hashset<SlaveID> heldBack;
+
+  // Allocates the resources on the agent to the framework under the
+  // non-quota role. If that would reduce the available headroom below
+  // the required headroom, the resources that count towards the
+  // headroom are held back.
+  auto allocateNonQuota = [&](
+      const SlaveID& slaveId,
+      const FrameworkID& frameworkId,
+      const string& role,
+      Resources toAllocate) {
+    // If allocating these resources would reduce the headroom
+    // below what is required, we will hold them back.
+    const Resources headroomToAllocate = toAllocate
+      .scalars().unreserved().nonRevocable();
+
+    const ResourceQuantities headroomQuantitiesToAllocate =
+      ResourceQuantities::fromScalarResources(headroomToAllocate);
+
+    bool sufficientHeadroom =
+      (availableHeadroom - headroomQuantitiesToAllocate)
+        .contains(requiredHeadroom);
+
+    if (!sufficientHeadroom) {
+      toAllocate -= headroomToAllocate;
+
+      if (!headroomToAllocate.empty()) {
+        heldBack.insert(slaveId);
       }
+    }
 
-      // NOTE: Suppressed frameworks are not included in the sort.
-      CHECK(frameworkSorters.contains(role));
-      const Owned<Sorter>& frameworkSorter = frameworkSorters.at(role);
+    // If the resources are not allocatable, ignore. We cannot break
+    // here, because another framework under the same role could accept
+    // revocable resources and breaking would skip all other frameworks.
+    if (!allocatable(toAllocate)) {
+      return;
+    }
 
-      foreach (const string& frameworkId_, frameworkSorter->sort()) {
-        FrameworkID frameworkId;
-        frameworkId.set_value(frameworkId_);
+    // If the framework filters these resources, ignore.
+    if (isFiltered(frameworkId, role, slaveId, toAllocate)) {
+      return;
+    }
 
-        CHECK(slaves.contains(slaveId));
-        CHECK(frameworks.contains(frameworkId));
+    VLOG(2) << "Allocating " << toAllocate << " on agent " << slaveId
+            << " to role " << role << " of framework " << frameworkId;
 
-        const Framework& framework = frameworks.at(frameworkId);
-        Slave& slave = slaves.at(slaveId);
+    toAllocate.allocate(role);
 
-        // Only offer resources from slaves that have GPUs to
-        // frameworks that are capable of receiving GPUs.
-        // See MESOS-5634.
-        if (filterGpuResources &&
-            !framework.capabilities.gpuResources &&
-            slave.total.gpus().getOrElse(0) > 0) {
-          continue;
-        }
+    // NOTE: We perform "coarse-grained" allocation, meaning that we always
+    // allocate the entire remaining slave resources to a single framework.
+    offerable[frameworkId][role][slaveId] += toAllocate;
+    offeredSharedResources[slaveId] += toAllocate.shared();
 
-        // If this framework is not region-aware, don't offer it
-        // resources on agents in remote regions.
-        if (!framework.capabilities.regionAware && isRemoteSlave(slave)) {
+    if (sufficientHeadroom) {
+      availableHeadroom -= headroomQuantitiesToAllocate;
+    }
+
+    Slave& slave = slaves.at(slaveId);
+    slave.allocated += toAllocate;
+
+    trackAllocatedResources(slaveId, frameworkId, toAllocate);
+  };
+
+  // Allocates the agents one after the other, each to the roles and
+  // frameworks in the current order of the sorters.
+  auto allocateAgents = [&](const vector<SlaveID>& slaveIds_) {
+    foreach (const SlaveID& slaveId, slaveIds_) {
+      foreach (const string& role, roleSorter->sort()) {
+        // In the second allocation stage, we only allocate
+        // for non-quota roles.
+        if (quotas.contains(role)) {
           continue;
         }
 
-        // Calculate the currently available resources on the slave, which
-        // is the difference in non-shared resources between total and
-        // allocated, plus all shared resources on the agent (if applicable).
-        Resources available = slave.available().nonShared();
+        // NOTE: Suppressed frameworks are not included in the sort.
+        CHECK(frameworkSorters.contains(role));
+        const Owned<Sorter>& frameworkSorter = frameworkSorters.at(role);
 
-        // Since shared resources are offerable even when they are in use, we
-        // make one copy of the shared resources available regardless of the
-        // past allocations. Offer a shared resource only if it has not been
-        // offered in this offer cycle to a framework.
-        if (framework.capabilities.sharedResources) {
-          available += slave.total.shared();
-          if (offeredSharedResources.contains(slaveId)) {
-            available -= offeredSharedResources[slaveId];
+        foreach (const string& frameworkId_, frameworkSorter->sort()) {
+          FrameworkID frameworkId;
+          frameworkId.set_value(frameworkId_);
+
+          CHECK(slaves.contains(slaveId));
+          CHECK(frameworks.contains(frameworkId));
+
+          const Slave& slave = slaves.at(slaveId);
+
+          Option<Resources> toAllocate = nonQuotaAllocation(
+              slaveId,
+              slave.available(),
+              offeredSharedResources.get(slaveId).getOrElse(Resources()),
+              frameworkId,
+              role);
+
+          // It is safe to break here, because all frameworks under a role
+          // would consider the same resources, so in case we don't have
+          // allocatable resources, we don't have to check for other
+          // frameworks under the same role. We only break out of the
+          // innermost loop, so the next step will use the same slaveId,
+          // but a different role.
+          if (toAllocate.isNone()) {
+            break;
           }
+
+          allocateNonQuota(slaveId, frameworkId, role, toAllocate.get());
         }
+      }
+    }
+  };
 
-        // The resources we offer are the unreserved resources as well as the
-        // reserved resources for this particular role and all its ancestors
-        // in the role hierarchy.
-        //
-        // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        //
-        // TODO(mpark): Offer unreserved resources as revocable beyond quota.
-        Resources toAllocate = available.allocatableTo(role);
+  const size_t shards = std::min(
+      allocationThreads,
+      slaveIds.size() / MIN_AGENTS_PER_ALLOCATION_SHARD);
 
-        // It is safe to break here, because all frameworks under a role would
-        // consider the same resources, so in case we don't have allocatable
-        // resources, we don't have to check for other frameworks under the
-        // same role. We only break out of the innermost loop, so the next step
-        // will use the same slaveId, but a different role.
-        //
-        // The difference to the second `allocatable` check is that here we also
-        // check for revocable resources, which can be disabled on a per frame-
-        // work basis, which requires us to go through all frameworks in case we
-        // have allocatable revocable resources.
-        if (!allocatable(toAllocate)) {
-          break;
-        }
+  if (shards > 1) {
+    // In a parallel allocation, the agents are split into shards whose
+    // allocations are proposed concurrently by worker threads, based on
+    // the order of the roles and frameworks at the start of this stage
+    // (the sorters are not updated until the allocations are made).
+    // The proposals are then reconciled with the quota headroom here,
+    // interleaving the shards so that the headroom is not consumed by
+    // the proposals of a single shard.
+    vector<std::pair<string, vector<FrameworkID>>> order;
 
-        // Remove revocable resources if the framework has not opted for them.
-        if (!framework.capabilities.revocableResources) {
-          toAllocate = toAllocate.nonRevocable();
-        }
+    foreach (const string& role, roleSorter->sort()) {
+      if (quotas.contains(role)) {
+        continue;
+      }
 
-        // When reservation refinements are present, old frameworks without the
-        // RESERVATION_REFINEMENT capability won't be able to understand the
-        // new format. While it's possible to translate the refined reservations
-        // into the old format by "hiding" the intermediate reservations in the
-        // "stack", this leads to ambiguity when processing RESERVE / UNRESERVE
-        // operations. This is due to the loss of information when we drop the
-        // intermediate reservations. Therefore, for now we simply filter out
-        // resources with refined reservations if the framework does not have
-        // the capability.
-        if (!framework.capabilities.reservationRefinement) {
-          toAllocate = toAllocate.filter([](const Resource& resource) {
-            return !Resources::hasRefinedReservations(resource);
-          });
-        }
+      // NOTE: Suppressed frameworks are not included in the sort.
+      CHECK(frameworkSorters.contains(role));
+      const Owned<Sorter>& frameworkSorter = frameworkSorters.at(role);
 
-        // If allocating these resources would reduce the headroom
-        // below what is required, we will hold them back.
-        const Resources headroomToAllocate = toAllocate
-          .scalars().unreserved().nonRevocable();
+      vector<FrameworkID> frameworkIds;
+      foreach (const string& frameworkId_, frameworkSorter->sort()) {
+        FrameworkID frameworkId;
+        frameworkId.set_value(frameworkId_);
+        frameworkIds.push_back(frameworkId);
+      }
 
-        bool sufficientHeadroom =
-          (availableHeadroom -
-            headroomToAllocate.createStrippedScalarQuantity())
-            .contains(requiredHeadroom);
+      order.emplace_back(role, std::move(frameworkIds));
+    }
 
-        if (!sufficientHeadroom) {
-          toAllocate -= headroomToAllocate;
-        }
+    // The agents are already shuffled, so we can simply deal them out.
+    vector<vector<SlaveID>> partitions(shards);
+    for (size_t i = 0; i < slaveIds.size(); i++) {
+      partitions[i % shards].push_back(slaveIds[i]);
+    }
 
-        // If the resources are not allocatable, ignore. We cannot break
-        // here, because another framework under the same role could accept
-        // revocable resources and breaking would skip all other frameworks.
-        if (!allocatable(toAllocate)) {
-          continue;
-        }
+    vector<vector<Proposal>> proposals(shards);
 
-        // If the framework filters these resources, ignore.
-        if (isFiltered(frameworkId, role, slaveId, toAllocate)) {
-          continue;
-        }
+    CHECK_NOTNULL(workers.get())->execute(shards, [&](size_t i) {
+      proposals[i] = propose(partitions[i], order, i, offeredSharedResources);
+    });
 
-        VLOG(2) << "Allocating " << toAllocate << " on agent " << slaveId
-                << " to role " << role << " of framework " << frameworkId;
+    for (size_t i = 0, remaining = shards; remaining > 0; i++) {
+      remaining = 0;
 
-        toAllocate.allocate(role);
+      foreach (const vector<Proposal>& shard, proposals) {
+        if (i < shard.size()) {
+          const Proposal& proposal = shard[i];
 
-        // NOTE: We perform "coarse-grained" allocation, meaning that we always
-        // allocate the entire remaining slave resources to a single framework.
-        offerable[frameworkId][role][slaveId] += toAllocate;
-        offeredSharedResources[slaveId] += toAllocate.shared();
+          allocateNonQuota(
+              proposal.slaveId,
+              proposal.frameworkId,
+              proposal.role,
+              proposal.resources);
 
-        if (sufficientHeadroom) {
-          availableHeadroom -=
-            headroomToAllocate.createStrippedScalarQuantity();
+          ++remaining;
         }
+      }
+    }
 
-        slave.allocated += toAllocate;
-
-        trackAllocatedResources(slaveId, frameworkId, toAllocate);
+    // A proposal assumes that the framework gets all of the resources
+    // on the agent, so the resources held back for the headroom were
+    // not proposed to any other framework. To not leave them idle for
+    // this cycle, the agents on which resources were held back are
+    // allocated again like in a serial allocation, which offers them
+    // unless they are still needed for the headroom.
+    vector<SlaveID> heldBackSlaveIds;
+    foreach (const SlaveID& slaveId, slaveIds) {
+      if (heldBack.contains(slaveId)) {
+        heldBackSlaveIds.push_back(slaveId);
       }
     }
+
+    allocateAgents(heldBackSlaveIds);
+  } else {
+    allocateAgents(slaveIds);
   }
 
   if (offerable.empty()) {
@@ -2183,6 +2371,181 @@ void HierarchicalAllocatorProcess::__allocate()
 }
 
 
+Option<Resources> HierarchicalAllocatorProcess::nonQuotaAllocation(
+    const SlaveID& slaveId,
+    const Resources& available,
+    const Resources& offeredShared,
+    const FrameworkID& frameworkId,
+    const string& role) const
+{
+  CHECK(slaves.contains(slaveId));
+  CHECK(frameworks.contains(frameworkId));
+
+  const Framework& framework = frameworks.at(frameworkId);
+  const Slave& slave = slaves.at(slaveId);
+
+  // If the framework has refused the entire agent, any resources would
+  // be filtered, so we skip the framework before computing them.
+  auto roleFilters = framework.offerFilters.find(role);
+  if (roleFilters != framework.offerFilters.end()) {
+    auto agentFilters = roleFilters->second.find(slaveId);
+
+    if (agentFilters != roleFilters->second.end() &&
+        !agentFilters->second.refusingTotal.empty()) {
+      return Resources();
+    }
+  }
+
+  // Only offer resources from slaves that have GPUs to
+  // frameworks that are capable of receiving GPUs.
+  // See MESOS-5634.
+  if (filterGpuResources &&
+      !framework.capabilities.gpuResources &&
+      slave.total.gpus().getOrElse(0) > 0) {
+    return Resources();
+  }
+
+  // If this framework is not region-aware, don't offer it
+  // resources on agents in remote regions.
+  if (!framework.capabilities.regionAware && isRemoteSlave(slave)) {
+    return Resources();
+  }
+
+  // Calculate the currently available resources on the slave, which
+  // is the difference in non-shared resources between total and
+  // allocated, plus all shared resources on the agent (if applicable).
+  Resources unallocated = available.nonShared();
+
+  // Since shared resources are offerable even when they are in use, we
+  // make one copy of the shared resources available regardless of the
+  // past allocations. Offer a shared resource only if it has not been
+  // offered in this offer cycle to a framework.
+  if (framework.capabilities.sharedResources) {
+    unallocated += slave.total.shared();
+    unallocated -= offeredShared;
+  }
+
+  // The resources we offer are the unreserved resources as well as the
+  // reserved resources for this particular role and all its ancestors
+  // in the role hierarchy.
+  //
+  // NOTE: Currently, frameworks are allowed to have '*' role.
+  // Calling reserved('*') returns an empty Resources object.
+  //
+  // TODO(mpark): Offer unreserved resources as revocable beyond quota.
+  Resources toAllocate = unallocated.allocatableTo(role);
+
+  // The difference to the second `allocatable` check (done by the
+  // caller) is that here we also check for revocable resources, which
+  // can be disabled on a per framework basis, which requires us to go
+  // through all frameworks in case we have allocatable revocable
+  // resources.
+  if (!allocatable(toAllocate)) {
+    return None();
+  }
+
+  // Remove revocable resources if the framework has not opted for them.
+  if (!framework.capabilities.revocableResources) {
+    toAllocate = toAllocate.nonRevocable();
+  }
+
+  // When reservation refinements are present, old frameworks without the
+  // RESERVATION_REFINEMENT capability won't be able to understand the
+  // new format. While it's possible to translate the refined reservations
+  // into the old format by "hiding" the intermediate reservations in the
+  // "stack", this leads to ambiguity when processing RESERVE / UNRESERVE
+  // operations. This is due to the loss of information when we drop the
+  // intermediate reservations. Therefore, for now we simply filter out
+  // resources with refined reservations if the framework does not have
+  // the capability.
+  if (!framework.capabilities.reservationRefinement) {
+    toAllocate = toAllocate.filter([](const Resource& resource) {
+      return !Resources::hasRefinedReservations(resource);
+    });
+  }
+
+  return toAllocate;
+}
+
+
+vector<HierarchicalAllocatorProcess::Proposal>
+HierarchicalAllocatorProcess::propose(
+    const vector<SlaveID>& slaveIds,
+    const vector<std::pair<string, vector<FrameworkID>>>& order,
+    size_t offset,
+    const hashmap<SlaveID, Resources>& offeredSharedResources) const
+{
+  vector<Proposal> proposals;
+
+  if (order.empty()) {
+    return proposals;
+  }
+
+  // Since the sorters do not see the proposed allocations, we emulate
+  // their effect within the shard: a role (and framework) that gets an
+  // allocation moves to the back of the order. Hence the roles take
+  // turns starting from the order they had at the start of the stage.
+  vector<size_t> roles(order.size());
+  std::iota(roles.begin(), roles.end(), 0);
+  std::rotate(
+      roles.begin(), roles.begin() + offset % roles.size(), roles.end());
+
+  vector<vector<size_t>> frameworkIds(order.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    frameworkIds[i].resize(order[i].second.size());
+    std::iota(frameworkIds[i].begin(), frameworkIds[i].end(), 0);
+  }
+
+  auto moveToBack = [](vector<size_t>* indices, size_t index) {
+    auto it = std::find(indices->begin(), indices->end(), index);
+    CHECK(it != indices->end());
+    std::rotate(it, it + 1, indices->end());
+  };
+
+  foreach (const SlaveID& slaveId, slaveIds) {
+    CHECK(slaves.contains(slaveId));
+
+    Resources available = slaves.at(slaveId).available();
+    Resources offeredShared =
+      offeredSharedResources.get(slaveId).getOrElse(Resources());
+
+    // NOTE: We iterate over copies since the orders change as we go.
+    foreach (size_t role, vector<size_t>(roles)) {
+      foreach (size_t framework, vector<size_t>(frameworkIds[role])) {
+        const string& role_ = order[role].first;
+        const FrameworkID& frameworkId = order[role].second[framework];
+
+        Option<Resources> toAllocate = nonQuotaAllocation(
+            slaveId, available, offeredShared, frameworkId, role_);
+
+        if (toAllocate.isNone()) {
+          break;
+        }
+
+        // The allocator re-checks these once the headroom has been
+        // accounted for, but this is needed to decide whether the
+        // resources are left for the next framework.
+        if (!allocatable(toAllocate.get()) ||
+            isFiltered(frameworkId, role_, slaveId, toAllocate.get())) {
+          continue;
+        }
+
+        proposals.push_back(
+            Proposal{slaveId, frameworkId, role_, toAllocate.get()});
+
+        available -= toAllocate.get();
+        offeredShared += toAllocate->shared();
+
+        moveToBack(&roles, role);
+        moveToBack(&frameworkIds[role], framework);
+      }
+    }
+  }
+
+  return proposals;
+}
+
+
 void HierarchicalAllocatorProcess::deallocate()
 {
   // If no frameworks are currently registered, no work to do.
@@ -2283,56 +2646,94 @@ void HierarchicalAllocatorProcess::deallocate()
 }
 
 
-void HierarchicalAllocatorProcess::_expire(
-    const FrameworkID& frameworkId,
-    const string& role,
-    const SlaveID& slaveId,
-    OfferFilter* offerFilter)
+void HierarchicalAllocatorProcess::_expireOfferFilters()
 {
-  // The filter might have already been removed (e.g., if the
-  // framework no longer exists or in `reviveOffers()`) but not
-  // yet deleted (to keep the address from getting reused
-  // possibly causing premature expiration).
-  //
-  // Since this is a performance-sensitive piece of code,
-  // we use find to avoid the doing any redundant lookups.
+  const Time now = Clock::now();
 
-  auto frameworkIterator = frameworks.find(frameworkId);
-  if (frameworkIterator != frameworks.end()) {
-    Framework& framework = frameworkIterator->second;
+  if (offerFilterExpiryTimer.isSome() && offerFilterExpiryTimer.get() <= now) {
+    offerFilterExpiryTimer = None();
+  }
 
-    auto roleFilters = framework.offerFilters.find(role);
-    if (roleFilters != framework.offerFilters.end()) {
-      auto agentFilters = roleFilters->second.find(slaveId);
+  const auto due = offerFilterExpiries.upper_bound(now);
 
-      if (agentFilters != roleFilters->second.end()) {
-        // Erase the filter (may be a no-op per the comment above).
-        agentFilters->second.erase(offerFilter);
+  for (auto it = offerFilterExpiries.begin(); it != due; ++it) {
+    const OfferFilterExpiry& expiry = it->second;
 
-        if (agentFilters->second.empty()) {
-          roleFilters->second.erase(slaveId);
+    // The filter might have already been removed (e.g., if the
+    // framework no longer exists or in `reviveOffers()`) but not
+    // yet deleted (to keep the address from getting reused
+    // possibly causing premature expiration).
+    //
+    // Since this is a performance-sensitive piece of code,
+    // we use find to avoid the doing any redundant lookups.
+    auto frameworkIterator = frameworks.find(expiry.frameworkId);
+    if (frameworkIterator != frameworks.end()) {
+      Framework& framework = frameworkIterator->second;
+
+      auto roleFilters = framework.offerFilters.find(expiry.role);
+      if (roleFilters != framework.offerFilters.end()) {
+        auto agentFilters = roleFilters->second.find(expiry.slaveId);
+
+        if (agentFilters != roleFilters->second.end()) {
+          // Erase the filter (may be a no-op per the comment above).
+          agentFilters->second.filters.erase(expiry.offerFilter);
+          agentFilters->second.refusingTotal.erase(expiry.offerFilter);
+
+          if (agentFilters->second.filters.empty()) {
+            roleFilters->second.erase(expiry.slaveId);
+          }
         }
       }
     }
+
+    delete expiry.offerFilter;
   }
 
-  delete offerFilter;
+  offerFilterExpiries.erase(offerFilterExpiries.begin(), due);
+
+  // Schedule the timer for the next filter to expire, unless an
+  // earlier timer is scheduled already.
+  if (!offerFilterExpiries.empty()) {
+    const Time next = offerFilterExpiries.begin()->first;
+
+    if (offerFilterExpiryTimer.isNone() ||
+        next < offerFilterExpiryTimer.get()) {
+      offerFilterExpiryTimer = next;
+      delay(next - now, self(), &Self::expireOfferFilters);
+    }
+  }
 }
 
 
-void HierarchicalAllocatorProcess::expire(
-    const FrameworkID& frameworkId,
-    const string& role,
-    const SlaveID& slaveId,
-    OfferFilter* offerFilter)
+void HierarchicalAllocatorProcess::expireOfferFilters()
 {
-  dispatch(
-      self(),
-      &Self::_expire,
-      frameworkId,
-      role,
-      slaveId,
-      offerFilter);
+  dispatch(self(), &Self::_expireOfferFilters);
+}
+
+
+void HierarchicalAllocatorProcess::updateOfferFilters(const SlaveID& slaveId)
+{
+  CHECK(slaves.contains(slaveId));
+
+  const Resources& total = slaves.at(slaveId).total;
+
+  foreachvalue (Framework& framework, frameworks) {
+    foreachvalue (auto& roleFilters, framework.offerFilters) {
+      auto agentFilters = roleFilters.find(slaveId);
+
+      if (agentFilters != roleFilters.end()) {
+        Framework::OfferFilters& offerFilters = agentFilters->second;
+
+        offerFilters.refusingTotal.clear();
+
+        foreach (OfferFilter* offerFilter, offerFilters.filters) {
+          if (offerFilter->filter(total)) {
+            offerFilters.refusingTotal.insert(offerFilter);
+          }
+        }
+      }
+    }
+  }
 }
 
 
@@ -2430,7 +2831,21 @@ bool HierarchicalAllocatorProcess::isFiltered(
     return false;
   }
 
-  foreach (OfferFilter* offerFilter, agentFilters->second) {
+  const Framework::OfferFilters& offerFilters = agentFilters->second;
+
+  // The offered resources are always a subset of the total of the
+  // agent, so they are filtered without evaluating each filter if a
+  // filter refuses the entire total.
+  if (!offerFilters.refusingTotal.empty()) {
+    VLOG(1) << "Filtered offer with " << resources
+            << " on agent " << slaveId
+            << " for role " << role
+            << " of framework " << frameworkId;
+
+    return true;
+  }
+
+  foreach (OfferFilter* offerFilter, offerFilters.filters) {
     if (offerFilter->filter(resources)) {
       VLOG(1) << "Filtered offer with " << resources
               << " on agent " << slaveId
@@ -2539,7 +2954,7 @@ double HierarchicalAllocatorProcess::_offer_filters_active(
     }
 
     foreachkey (const SlaveID& slaveId, framework.offerFilters.at(role)) {
-      result += framework.offerFilters.at(role).at(slaveId).size();
+      result += framework.offerFilters.at(role).at(slaveId).filters.size();
     }
   }
 
@@ -2692,6 +3107,10 @@ bool HierarchicalAllocatorProcess::updateSlaveTotal(
   quotaRoleSorter->remove(slaveId, oldTotal.nonRevocable());
   quotaRoleSorter->add(slaveId, total.nonRevocable());
 
+  // The offer filters that refused the entire old total might not
+  // refuse the new one, and vice versa.
+  updateOfferFilters(slaveId);
+
   return true;
 }
 
@@ -17,14 +17,18 @@
 #ifndef __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 #define __MASTER_ALLOCATOR_MESOS_HIERARCHICAL_HPP__
 
+#include <map>
 #include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <mesos/mesos.hpp>
 
 #include <process/future.hpp>
 #include <process/id.hpp>
 #include <process/owned.hpp>
+#include <process/time.hpp>
 
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
@@ -66,6 +70,7 @@ namespace internal {
 // Forward declarations.
 class OfferFilter;
 class InverseOfferFilter;
+class AllocationWorkers;
 
 
 // Implements the basic allocator algorithm - first pick a role by
@@ -76,15 +81,17 @@ public:
   HierarchicalAllocatorProcess(
       const std::function<Sorter*()>& roleSorterFactory,
       const std::function<Sorter*()>& _frameworkSorterFactory,
-      const std::function<Sorter*()>& quotaRoleSorterFactory)
+      const std::function<Sorter*()>& quotaRoleSorterFactory,
+      size_t _allocationThreads = 1)
     : initialized(false),
       paused(true),
       metrics(*this),
+      allocationThreads(_allocationThreads),
       roleSorter(roleSorterFactory()),
       quotaRoleSorter(quotaRoleSorterFactory()),
       frameworkSorterFactory(_frameworkSorterFactory) {}
 
-  virtual ~HierarchicalAllocatorProcess() {}
+  virtual ~HierarchicalAllocatorProcess();
 
   process::PID<HierarchicalAllocatorProcess> self() const
   {
@@ -244,18 +251,13 @@ protected:
   // Helper for `_allocate()` that deallocates resources for inverse offers.
   void deallocate();
 
-  // Remove an offer filter for the specified role of the framework.
-  void expire(
-      const FrameworkID& frameworkId,
-      const std::string& role,
-      const SlaveID& slaveId,
-      OfferFilter* offerFilter);
+  // Remove the offer filters that are due, see `offerFilterExpiries`.
+  void expireOfferFilters();
+  void _expireOfferFilters();
 
-  void _expire(
-      const FrameworkID& frameworkId,
-      const std::string& role,
-      const SlaveID& slaveId,
-      OfferFilter* offerFilter);
+  // Re-evaluates which of the offer filters for the agent refuse its
+  // entire total, e.g., after the total has changed.
+  void updateOfferFilters(const SlaveID& slaveId);
 
   // Remove an inverse offer filter for the specified framework.
   void expire(
@@ -282,6 +284,49 @@ protected:
 
   static bool allocatable(const Resources& resources);
 
+  // An allocation of the second stage (see `__allocate`) proposed by a
+  // worker of a parallel allocation, which is only performed once the
+  // proposals of all workers have been reconciled with the headroom.
+  struct Proposal
+  {
+    SlaveID slaveId;
+    FrameworkID frameworkId;
+    std::string role;
+    Resources resources;
+  };
+
+  // Returns the resources on the agent that the second allocation stage
+  // would allocate to the framework under the (non-quota) role, before
+  // holding back quota headroom. `available` are the unallocated
+  // resources of the agent and `offeredShared` the shared resources of
+  // the agent already offered in this allocation cycle. Returns None if
+  // nothing on the agent can be allocated to the role, in which case
+  // the other frameworks of the role do not need to be considered.
+  //
+  // NOTE: This only reads the allocator state, so that the workers of
+  // a parallel allocation can call it concurrently.
+  Option<Resources> nonQuotaAllocation(
+      const SlaveID& slaveId,
+      const Resources& available,
+      const Resources& offeredShared,
+      const FrameworkID& frameworkId,
+      const std::string& role) const;
+
+  // Proposes the second stage allocations on the agents of one shard
+  // of a parallel allocation, see `__allocate`. `order` contains the
+  // non-quota roles and their frameworks as sorted at the start of the
+  // stage, which is rotated by `offset` so that the workers start with
+  // different roles.
+  //
+  // NOTE: This runs on a worker thread and only reads the allocator
+  // state.
+  std::vector<Proposal> propose(
+      const std::vector<SlaveID>& slaveIds,
+      const std::vector<std::pair<std::string, std::vector<FrameworkID>>>&
+        order,
+      size_t offset,
+      const hashmap<SlaveID, Resources>& offeredSharedResources) const;
+
   bool initialized;
   bool paused;
 
@@ -316,10 +361,21 @@ protected:
 
     protobuf::framework::Capabilities capabilities;
 
+    // The offer filters of a role of the framework for an agent.
+    struct OfferFilters
+    {
+      hashset<OfferFilter*> filters;
+
+      // The subset of `filters` that refuse the entire total of the
+      // agent. While there is any, the agent is filtered whatever the
+      // offered resources are, without evaluating each filter.
+      hashset<OfferFilter*> refusingTotal;
+    };
+
     // Active offer and inverse offer filters for the framework.
     // Offer filters are tied to the role the filtered resources
     // were allocated to.
-    hashmap<std::string, hashmap<SlaveID, hashset<OfferFilter*>>> offerFilters;
+    hashmap<std::string, hashmap<SlaveID, OfferFilters>> offerFilters;
     hashmap<SlaveID, hashset<InverseOfferFilter*>> inverseOfferFilters;
 
     bool active;
@@ -467,6 +523,31 @@ protected:
   // The master's domain, if any.
   Option<DomainInfo> domain;
 
+  // The number of threads used to allocate the agents of a cycle.
+  const size_t allocationThreads;
+
+  // The threads (other than the allocator's own) that propose the
+  // allocations of a parallel allocation, if `allocationThreads` > 1.
+  process::Owned<AllocationWorkers> workers;
+
+  struct OfferFilterExpiry
+  {
+    FrameworkID frameworkId;
+    std::string role;
+    SlaveID slaveId;
+    OfferFilter* offerFilter;
+  };
+
+  // All offer filters by the time they expire. Rather than a timer for
+  // each of the (possibly hundreds of thousands of) filters, a single
+  // timer is scheduled for the earliest expiry, which removes all the
+  // filters that are due at once. The filters are only deleted here,
+  // even if they have been removed from their framework before.
+  std::multimap<process::Time, OfferFilterExpiry> offerFilterExpiries;
+
+  // When the scheduled expiry timer fires, if any.
+  Option<process::Time> offerFilterExpiryTimer;
+
   // There are two stages of allocation:
   //
   //   Stage 1: Allocate to satisfy quota guarantees.
@@ -612,14 +693,15 @@ class HierarchicalAllocatorProcess
   : public internal::HierarchicalAllocatorProcess
 {
 public:
-  HierarchicalAllocatorProcess()
+  explicit HierarchicalAllocatorProcess(size_t allocationThreads = 1)
     : ProcessBase(process::ID::generate("hierarchical-allocator")),
       internal::HierarchicalAllocatorProcess(
           [this]() -> Sorter* {
             return new RoleSorter(this->self(), "allocator/mesos/roles/");
           },
           []() -> Sorter* { return new FrameworkSorter(); },
-          []() -> Sorter* { return new QuotaRoleSorter(); }) {}
+          []() -> Sorter* { return new QuotaRoleSorter(); },
+          allocationThreads) {}
 };
 
 } // namespace allocator {
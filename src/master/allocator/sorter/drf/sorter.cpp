@@ -16,6 +16,9 @@
 
 #include "master/allocator/sorter/drf/sorter.hpp"
 
+#include <algorithm>
+#include <functional>
+#include <iterator>
 #include <set>
 #include <string>
 #include <vector>
@@ -110,6 +113,18 @@ void DRFSorter::add(const string& clientPath)
       parent->addChild(internal);
       internal->allocation = current->allocation;
 
+      // Unlike the leaf, the internal node keys its allocation by the
+      // index of the agent.
+      internal->allocation.resources.clear();
+      foreachpair (const SlaveID& slaveId,
+                   const Resources& resources,
+                   current->allocation.resources) {
+        const Option<size_t> agent = lookup(slaveId);
+        CHECK_SOME(agent) << "Unknown agent " << slaveId;
+
+        internal->allocation.indexedResources[agent.get()] = resources;
+      }
+
       CHECK_EQ(current->path, internal->path);
 
       // Update `current` to become a virtual leaf node and a child of
@@ -215,7 +230,10 @@ void DRFSorter::remove(const string& clientPath)
       foreachpair (const SlaveID& slaveId,
                    const Resources& resources,
                    leafAllocation) {
-        parent->allocation.subtract(slaveId, resources);
+        const Option<size_t> agent = lookup(slaveId);
+        CHECK_SOME(agent) << "Unknown agent " << slaveId;
+
+        parent->subtract(agent.get(), slaveId, resources);
       }
     }
 
@@ -237,6 +255,12 @@ void DRFSorter::remove(const string& clientPath)
         current->kind = child->kind;
         current->removeChild(child);
 
+        // What is left allocated to `current` is the allocation of
+        // `child`, which is keyed by `SlaveID` as `current` is a leaf
+        // again.
+        current->allocation.resources = child->allocation.resources;
+        current->allocation.indexedResources.clear();
+
         // `current` has changed kind (from `INTERNAL` to a leaf,
         // which might be active or inactive). Hence we might need to
         // change its position in the `children` list.
@@ -256,6 +280,14 @@ void DRFSorter::remove(const string& clientPath)
     current = parent;
   }
 
+  // The client no longer refers to the agents it had allocations on.
+  foreachkey (const SlaveID& slaveId, leafAllocation) {
+    const Option<size_t> agent = lookup(slaveId);
+    CHECK_SOME(agent) << "Unknown agent " << slaveId;
+
+    release(agent.get());
+  }
+
   // TODO(neilc): Avoid dirtying the tree in some circumstances.
   dirty = true;
 
@@ -272,19 +304,36 @@ void DRFSorter::activate(const string& clientPath)
   if (client->kind == Node::INACTIVE_LEAF) {
     client->kind = Node::ACTIVE_LEAF;
 
-    // `client` has been activated, so move it to the beginning of its
-    // parent's list of children. We mark the tree dirty, so that the
-    // client's share is updated correctly and it is sorted properly.
-    //
-    // TODO(neilc): We could instead calculate share here and insert
-    // the client into the appropriate place here, which would avoid
-    // dirtying the whole tree.
-    CHECK_NOTNULL(client->parent);
-
-    client->parent->removeChild(client);
-    client->parent->addChild(client);
-
-    dirty = true;
+    // `client` has been activated, so move it out of the inactive
+    // leaves at the end of its parent's list of children. Unless the
+    // tree is dirty anyway, we calculate the client's share and insert
+    // it directly at its position among the active children. The
+    // share of the parent is unaffected, since its allocation already
+    // includes the allocation of inactive clients.
+    Node* parent = CHECK_NOTNULL(client->parent);
+
+    parent->removeChild(client);
+
+    if (dirty) {
+      parent->addChild(client);
+    } else {
+      client->share = calculateShare(client);
+
+      auto active = std::partition_point(
+          parent->children.begin(),
+          parent->children.end(),
+          [](const Node* child) {
+            return child->kind != Node::INACTIVE_LEAF;
+          });
+
+      parent->children.insert(
+          std::lower_bound(
+              parent->children.begin(),
+              active,
+              client,
+              DRFSorter::Node::compareDRF),
+          client);
+    }
   }
 }
 
@@ -320,18 +369,16 @@ void DRFSorter::allocated(
     const SlaveID& slaveId,
     const Resources& resources)
 {
-  Node* current = CHECK_NOTNULL(find(clientPath));
+  Node* client = CHECK_NOTNULL(find(clientPath));
+  const size_t agent = intern(slaveId);
 
-  // NOTE: We don't currently update the `allocation` for the root
-  // node. This is debatable, but the current implementation doesn't
-  // require looking at the allocation of the root node.
-  while (current != root) {
-    current->allocation.add(slaveId, resources);
-    current = CHECK_NOTNULL(current->parent);
+  if (!client->allocation.resources.contains(slaveId)) {
+    ++agents[agent].references;
   }
 
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
+  updateAllocation(client, [&](Node* node) {
+    node->add(agent, slaveId, resources);
+  });
 }
 
 
@@ -343,21 +390,15 @@ void DRFSorter::update(
 {
   // TODO(bmahler): Check invariants between old and new allocations.
   // Namely, the roles and quantities of resources should be the same!
-  // Otherwise, we need to ensure we re-calculate the shares, as
-  // is being currently done, for safety.
-
-  Node* current = CHECK_NOTNULL(find(clientPath));
+  // Until then, the shares of the client and its ancestors are
+  // recalculated, for safety.
 
-  // NOTE: We don't currently update the `allocation` for the root
-  // node. This is debatable, but the current implementation doesn't
-  // require looking at the allocation of the root node.
-  while (current != root) {
-    current->allocation.update(slaveId, oldAllocation, newAllocation);
-    current = CHECK_NOTNULL(current->parent);
-  }
+  const Option<size_t> agent = lookup(slaveId);
+  CHECK_SOME(agent) << "Unknown agent " << slaveId;
 
-  // Just assume the total has changed, per the TODO above.
-  dirty = true;
+  updateAllocation(CHECK_NOTNULL(find(clientPath)), [&](Node* node) {
+    node->update(agent.get(), slaveId, oldAllocation, newAllocation);
+  });
 }
 
 
@@ -366,18 +407,18 @@ void DRFSorter::unallocated(
     const SlaveID& slaveId,
     const Resources& resources)
 {
-  Node* current = CHECK_NOTNULL(find(clientPath));
+  Node* client = CHECK_NOTNULL(find(clientPath));
 
-  // NOTE: We don't currently update the `allocation` for the root
-  // node. This is debatable, but the current implementation doesn't
-  // require looking at the allocation of the root node.
-  while (current != root) {
-    current->allocation.subtract(slaveId, resources);
-    current = CHECK_NOTNULL(current->parent);
-  }
+  const Option<size_t> agent = lookup(slaveId);
+  CHECK_SOME(agent) << "Unknown agent " << slaveId;
 
-  // TODO(neilc): Avoid dirtying the tree in some circumstances.
-  dirty = true;
+  updateAllocation(client, [&](Node* node) {
+    node->subtract(agent.get(), slaveId, resources);
+  });
+
+  if (!client->allocation.resources.contains(slaveId)) {
+    release(agent.get());
+  }
 }
 
 
@@ -446,23 +487,27 @@ const Resources& DRFSorter::totalScalarQuantities() const
 void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
 {
   if (!resources.empty()) {
+    Agent& agent = agents[intern(slaveId)];
+
+    if (agent.total.empty()) {
+      ++agent.references;
+    }
+
     // Add shared resources to the total quantities when the same
     // resources don't already exist in the total.
     const Resources newShared = resources.shared()
-      .filter([this, slaveId](const Resource& resource) {
-        return !total_.resources[slaveId].contains(resource);
+      .filter([&agent](const Resource& resource) {
+        return !agent.total.contains(resource);
       });
 
-    total_.resources[slaveId] += resources;
+    agent.total += resources;
 
     const Resources scalarQuantities =
       (resources.nonShared() + newShared).createStrippedScalarQuantity();
 
     total_.scalarQuantities += scalarQuantities;
 
-    foreach (const Resource& resource, scalarQuantities) {
-      total_.totals[resource.name()] += resource.scalar();
-    }
+    total_.totals += ResourceQuantities::fromScalarResources(scalarQuantities);
 
     // We have to recalculate all shares when the total resources
     // change, but we put it off until `sort` is called so that if
@@ -476,31 +521,33 @@ void DRFSorter::add(const SlaveID& slaveId, const Resources& resources)
 void DRFSorter::remove(const SlaveID& slaveId, const Resources& resources)
 {
   if (!resources.empty()) {
-    CHECK(total_.resources.contains(slaveId));
-    CHECK(total_.resources[slaveId].contains(resources))
-      << total_.resources[slaveId] << " does not contain " << resources;
+    const Option<size_t> index = lookup(slaveId);
+    CHECK_SOME(index) << "Unknown agent " << slaveId;
+
+    Agent& agent = agents[index.get()];
 
-    total_.resources[slaveId] -= resources;
+    CHECK(agent.total.contains(resources))
+      << agent.total << " does not contain " << resources;
+
+    agent.total -= resources;
 
     // Remove shared resources from the total quantities when there
     // are no instances of same resources left in the total.
     const Resources absentShared = resources.shared()
-      .filter([this, slaveId](const Resource& resource) {
-        return !total_.resources[slaveId].contains(resource);
+      .filter([&agent](const Resource& resource) {
+        return !agent.total.contains(resource);
       });
 
     const Resources scalarQuantities =
       (resources.nonShared() + absentShared).createStrippedScalarQuantity();
 
-    foreach (const Resource& resource, scalarQuantities) {
-      total_.totals[resource.name()] -= resource.scalar();
-    }
+    total_.totals -= ResourceQuantities::fromScalarResources(scalarQuantities);
 
     CHECK(total_.scalarQuantities.contains(scalarQuantities));
     total_.scalarQuantities -= scalarQuantities;
 
-    if (total_.resources[slaveId].empty()) {
-      total_.resources.erase(slaveId);
+    if (agent.total.empty()) {
+      release(index.get());
     }
 
     dirty = true;
@@ -598,23 +645,17 @@ double DRFSorter::calculateShare(const Node* node) const
   // currently does not take into account resources that are not
   // scalars.
 
-  foreachpair (const string& resourceName,
-               const Value::Scalar& scalar,
-               total_.totals) {
-    // Filter out the resources excluded from fair sharing.
-    if (fairnessExcludeResourceNames.isSome() &&
-        fairnessExcludeResourceNames->count(resourceName) > 0) {
-      continue;
-    }
-
-    if (scalar.value() > 0.0 &&
-        node->allocation.totals.contains(resourceName)) {
-      const double allocation =
-        node->allocation.totals.at(resourceName).value();
+  total_.totals.foreachQuantity(
+      node->allocation.totals,
+      [&](const string& name, double total, double allocation) {
+        // Filter out the resources excluded from fair sharing.
+        if (fairnessExcludeResourceNames.isSome() &&
+            fairnessExcludeResourceNames->count(name) > 0) {
+          return;
+        }
 
-      share = std::max(share, allocation / scalar.value());
-    }
-  }
+        share = std::max(share, allocation / total);
+      });
 
   return share / findWeight(node);
 }
@@ -647,6 +688,101 @@ DRFSorter::Node* DRFSorter::find(const string& clientPath) const
   return client;
 }
 
+
+void DRFSorter::updateAllocation(
+    Node* client,
+    const std::function<void(Node*)>& change)
+{
+  // NOTE: We don't currently update the `allocation` for the root
+  // node. This is debatable, but the current implementation doesn't
+  // require looking at the allocation of the root node.
+  for (Node* current = client; current != root; current = current->parent) {
+    Node* parent = CHECK_NOTNULL(current->parent);
+
+    // Inactive leaves are not sorted, and if the tree is dirty, sort()
+    // will recalculate all shares anyway.
+    if (dirty || current->kind == Node::INACTIVE_LEAF) {
+      change(current);
+      continue;
+    }
+
+    // The active children of `parent` are sorted by `compareDRF`, which
+    // is a total order since sibling paths are unique. We locate
+    // `current` before changing its allocation, i.e., while its share
+    // and allocation count still match its position.
+    vector<Node*>& children = parent->children;
+
+    auto begin = children.begin();
+    auto end = std::partition_point(
+        begin,
+        children.end(),
+        [](const Node* child) { return child->kind != Node::INACTIVE_LEAF; });
+
+    auto it = std::lower_bound(begin, end, current, Node::compareDRF);
+    CHECK(it != end && *it == current);
+
+    change(current);
+    current->share = calculateShare(current);
+
+    // Move `current` towards the end or the beginning of the active
+    // children, past the siblings that now compare before or after it.
+    if (std::next(it) != end && Node::compareDRF(*std::next(it), current)) {
+      std::rotate(
+          it,
+          std::next(it),
+          std::lower_bound(std::next(it), end, current, Node::compareDRF));
+    } else if (it != begin && Node::compareDRF(current, *std::prev(it))) {
+      std::rotate(
+          std::upper_bound(begin, it, current, Node::compareDRF),
+          it,
+          std::next(it));
+    }
+  }
+}
+
+
+size_t DRFSorter::intern(const SlaveID& slaveId)
+{
+  Option<size_t> index = agentIndices.get(slaveId);
+
+  if (index.isNone()) {
+    if (freeAgents.empty()) {
+      index = agents.size();
+      agents.emplace_back();
+    } else {
+      index = freeAgents.back();
+      freeAgents.pop_back();
+    }
+
+    agents[index.get()].id = slaveId;
+    agentIndices[slaveId] = index.get();
+  }
+
+  return index.get();
+}
+
+
+Option<size_t> DRFSorter::lookup(const SlaveID& slaveId) const
+{
+  return agentIndices.get(slaveId);
+}
+
+
+void DRFSorter::release(size_t index)
+{
+  Agent& agent = agents.at(index);
+
+  CHECK_GT(agent.references, 0u);
+
+  if (--agent.references == 0) {
+    CHECK(agent.total.empty());
+
+    agentIndices.erase(agent.id);
+    agent = Agent();
+    freeAgents.push_back(index);
+  }
+}
+
 } // namespace allocator {
 } // namespace master {
 } // namespace internal {
@@ -18,6 +18,7 @@
 #define __MASTER_ALLOCATOR_SORTER_DRF_SORTER_HPP__
 
 #include <algorithm>
+#include <functional>
 #include <set>
 #include <string>
 #include <vector>
@@ -30,6 +31,8 @@
 #include <stout/hashmap.hpp>
 #include <stout/option.hpp>
 
+#include "common/resource_quantities.hpp"
+
 #include "master/allocator/sorter/drf/metrics.hpp"
 
 #include "master/allocator/sorter/sorter.hpp"
@@ -122,10 +125,34 @@ private:
   // internal node in the tree (not a client).
   Node* find(const std::string& clientPath) const;
 
+  // Applies `change` to the allocation of the client and each of its
+  // ancestors (except the root). Unless the tree is dirty, the share
+  // of each of these nodes is then recalculated and the node is moved
+  // to its new position among its siblings, so that a change to the
+  // allocation of one client does not require sort() to recalculate
+  // every share and resort the whole tree.
+  void updateAllocation(
+      Node* client,
+      const std::function<void(Node*)>& change);
+
+  // Returns the index of the agent, assigning an unused one if the
+  // agent is not known yet. The index remains valid as long as the
+  // agent is referenced (see `Agent::references`).
+  size_t intern(const SlaveID& slaveId);
+
+  // Returns the index of the agent, if the agent is known.
+  Option<size_t> lookup(const SlaveID& slaveId) const;
+
+  // Drops a reference to the agent with the given index, releasing
+  // the index for reuse once the agent is no longer referenced.
+  void release(size_t index);
+
   // Resources (by name) that will be excluded from fair sharing.
   Option<std::set<std::string>> fairnessExcludeResourceNames;
 
   // If true, sort() will recalculate all shares and resort the tree.
+  // Otherwise the active children of each node are kept sorted as
+  // allocations change (see `updateAllocation`).
   bool dirty = false;
 
   // The root node in the sorter tree.
@@ -144,16 +171,36 @@ private:
   // currently in the sorter tree.
   hashmap<std::string, double> weights;
 
+  // Agents are interned into dense indices, so that the allocations
+  // of internal nodes are keyed by integers rather than by `SlaveID`s,
+  // which are hashed and compared by their string value. The `SlaveID`
+  // is only looked up once per call at the boundary of the sorter, and
+  // once more in the client's leaf node.
+  struct Agent
+  {
+    SlaveID id;
+
+    // The total resources of the agent. We need to keep track of the
+    // resources (and not just scalar quantities) to account for
+    // multiple copies of the same shared resources. We need to ensure
+    // that we do not update the scalar quantities for shared resources
+    // when the change is only in the number of copies in the sorter.
+    Resources total;
+
+    // The number of clients with an allocation on the agent, plus one
+    // if the agent has a non-empty total.
+    size_t references = 0;
+  };
+
+  // Indexed by the agent index. Released indices are kept in
+  // `freeAgents` to be reused.
+  std::vector<Agent> agents;
+  std::vector<size_t> freeAgents;
+  hashmap<SlaveID, size_t> agentIndices;
+
   // Total resources.
   struct Total
   {
-    // We need to keep track of the resources (and not just scalar
-    // quantities) to account for multiple copies of the same shared
-    // resources. We need to ensure that we do not update the scalar
-    // quantities for shared resources when the change is only in the
-    // number of copies in the sorter.
-    hashmap<SlaveID, Resources> resources;
-
     // NOTE: Scalars can be safely aggregated across slaves. We keep
     // that to speed up the calculation of shares. See MESOS-2891 for
     // the reasons why we want to do that.
@@ -168,14 +215,15 @@ private:
     // identities of resources and not quantities.
     Resources scalarQuantities;
 
-    // We also store a map version of `scalarQuantities`, mapping
-    // the `Resource::name` to aggregated scalar. This improves the
-    // performance of calculating shares. See MESOS-4694.
+    // We also store a `ResourceQuantities` version of
+    // `scalarQuantities`, aggregating the scalars by `Resource::name`.
+    // This improves the performance of calculating shares. See
+    // MESOS-4694.
     //
     // TODO(bmahler): Ideally we do not store `scalarQuantities`
     // redundantly here, investigate performance improvements to
     // `Resources` to make this unnecessary.
-    hashmap<std::string, Value::Scalar> totals;
+    ResourceQuantities totals;
   } total_;
 
   // Metrics are optionally exposed by the sorter.
@@ -316,68 +364,119 @@ struct DRFSorter::Node
     }
   }
 
+  // Adds, subtracts or updates the resources allocated to the node on
+  // the agent, which is identified by both its `SlaveID` and its index
+  // as leaves and internal nodes key their allocations differently
+  // (see `Allocation::resources`).
+  void add(size_t agent, const SlaveID& slaveId, const Resources& toAdd)
+  {
+    if (isLeaf()) {
+      allocation.add(&allocation.resources, slaveId, toAdd);
+    } else {
+      allocation.add(&allocation.indexedResources, agent, toAdd);
+    }
+  }
+
+  void subtract(
+      size_t agent,
+      const SlaveID& slaveId,
+      const Resources& toRemove)
+  {
+    if (isLeaf()) {
+      allocation.subtract(&allocation.resources, slaveId, toRemove);
+    } else {
+      allocation.subtract(&allocation.indexedResources, agent, toRemove);
+    }
+  }
+
+  void update(
+      size_t agent,
+      const SlaveID& slaveId,
+      const Resources& oldAllocation,
+      const Resources& newAllocation)
+  {
+    if (isLeaf()) {
+      allocation.update(
+          &allocation.resources, slaveId, oldAllocation, newAllocation);
+    } else {
+      allocation.update(
+          &allocation.indexedResources, agent, oldAllocation, newAllocation);
+    }
+  }
+
   // Allocation for a node.
   struct Allocation
   {
     Allocation() : count(0) {}
 
-    void add(const SlaveID& slaveId, const Resources& toAdd)
+    template <typename Key>
+    void add(
+        hashmap<Key, Resources>* resources,
+        const Key& key,
+        const Resources& toAdd)
     {
+      Resources& allocated = (*resources)[key];
+
       // Add shared resources to the allocated quantities when the same
       // resources don't already exist in the allocation.
       const Resources sharedToAdd = toAdd.shared()
-        .filter([this, slaveId](const Resource& resource) {
-            return !resources[slaveId].contains(resource);
+        .filter([&allocated](const Resource& resource) {
+            return !allocated.contains(resource);
         });
 
       const Resources quantitiesToAdd =
         (toAdd.nonShared() + sharedToAdd).createStrippedScalarQuantity();
 
-      resources[slaveId] += toAdd;
+      allocated += toAdd;
       scalarQuantities += quantitiesToAdd;
 
-      foreach (const Resource& resource, quantitiesToAdd) {
-        totals[resource.name()] += resource.scalar();
-      }
+      totals += ResourceQuantities::fromScalarResources(quantitiesToAdd);
 
       count++;
     }
 
-    void subtract(const SlaveID& slaveId, const Resources& toRemove)
+    template <typename Key>
+    void subtract(
+        hashmap<Key, Resources>* resources,
+        const Key& key,
+        const Resources& toRemove)
     {
-      CHECK(resources.contains(slaveId));
-      CHECK(resources.at(slaveId).contains(toRemove))
-        << "Resources " << resources.at(slaveId) << " at agent " << slaveId
+      CHECK(resources->contains(key));
+
+      Resources& allocated = resources->at(key);
+
+      CHECK(allocated.contains(toRemove))
+        << "Resources " << allocated << " at agent " << key
         << " does not contain " << toRemove;
 
-      resources[slaveId] -= toRemove;
+      allocated -= toRemove;
 
       // Remove shared resources from the allocated quantities when there
       // are no instances of same resources left in the allocation.
       const Resources sharedToRemove = toRemove.shared()
-        .filter([this, slaveId](const Resource& resource) {
-            return !resources[slaveId].contains(resource);
+        .filter([&allocated](const Resource& resource) {
+            return !allocated.contains(resource);
         });
 
       const Resources quantitiesToRemove =
         (toRemove.nonShared() + sharedToRemove).createStrippedScalarQuantity();
 
-      foreach (const Resource& resource, quantitiesToRemove) {
-        totals[resource.name()] -= resource.scalar();
-      }
+      totals -= ResourceQuantities::fromScalarResources(quantitiesToRemove);
 
       CHECK(scalarQuantities.contains(quantitiesToRemove))
         << scalarQuantities << " does not contain " << quantitiesToRemove;
 
       scalarQuantities -= quantitiesToRemove;
 
-      if (resources[slaveId].empty()) {
-        resources.erase(slaveId);
+      if (allocated.empty()) {
+        resources->erase(key);
       }
     }
 
+    template <typename Key>
     void update(
-        const SlaveID& slaveId,
+        hashmap<Key, Resources>* resources,
+        const Key& key,
         const Resources& oldAllocation,
         const Resources& newAllocation)
     {
@@ -386,27 +485,25 @@ struct DRFSorter::Node
       const Resources newAllocationQuantity =
         newAllocation.createStrippedScalarQuantity();
 
-      CHECK(resources.contains(slaveId));
-      CHECK(resources[slaveId].contains(oldAllocation))
-        << "Resources " << resources[slaveId] << " at agent " << slaveId
+      CHECK(resources->contains(key));
+
+      Resources& allocated = resources->at(key);
+
+      CHECK(allocated.contains(oldAllocation))
+        << "Resources " << allocated << " at agent " << key
         << " does not contain " << oldAllocation;
 
       CHECK(scalarQuantities.contains(oldAllocationQuantity))
         << scalarQuantities << " does not contain " << oldAllocationQuantity;
 
-      resources[slaveId] -= oldAllocation;
-      resources[slaveId] += newAllocation;
+      allocated -= oldAllocation;
+      allocated += newAllocation;
 
       scalarQuantities -= oldAllocationQuantity;
       scalarQuantities += newAllocationQuantity;
 
-      foreach (const Resource& resource, oldAllocationQuantity) {
-        totals[resource.name()] -= resource.scalar();
-      }
-
-      foreach (const Resource& resource, newAllocationQuantity) {
-        totals[resource.name()] += resource.scalar();
-      }
+      totals -= ResourceQuantities::fromScalarResources(oldAllocationQuantity);
+      totals += ResourceQuantities::fromScalarResources(newAllocationQuantity);
     }
 
     // We store the number of times this client has been chosen for
@@ -422,21 +519,29 @@ struct DRFSorter::Node
     // to a client, where the number of copies represents the number
     // of times this shared resource has been allocated to (and has
     // not been recovered from) a specific client.
+    //
+    // Only leaf nodes key their allocation by `SlaveID`, so that
+    // `allocation(clientPath)` can return it by reference. Internal
+    // nodes, which are updated for every allocation to a client in
+    // their subtree, key it by the index of the agent instead (see
+    // `DRFSorter::Agent`) and leave `resources` empty.
     hashmap<SlaveID, Resources> resources;
+    hashmap<size_t, Resources> indexedResources;
 
     // Similarly, we aggregate scalars across slaves and omit information
     // about dynamic reservations, persistent volumes and sharedness of
     // the corresponding resource. See notes above.
     Resources scalarQuantities;
 
-    // We also store a map version of `scalarQuantities`, mapping
-    // the `Resource::name` to aggregated scalar. This improves the
-    // performance of calculating shares. See MESOS-4694.
+    // We also store a `ResourceQuantities` version of
+    // `scalarQuantities`, aggregating the scalars by `Resource::name`.
+    // This improves the performance of calculating shares. See
+    // MESOS-4694.
     //
     // TODO(bmahler): Ideally we do not store `scalarQuantities`
     // redundantly here, investigate performance improvements to
     // `Resources` to make this unnecessary.
-    hashmap<std::string, Value::Scalar> totals;
+    ResourceQuantities totals;
   } allocation;
 
   // Compares two nodes according to DRF share.
@@ -47,6 +47,11 @@ constexpr double MIN_CPUS = 0.01;
 // Minimum amount of memory per offer.
 constexpr Bytes MIN_MEM = Megabytes(32);
 
+// Minimum number of agents in each shard of a parallel allocation,
+// below which spreading the agents across more of the allocation
+// worker threads is not worth the cost of handing off a shard.
+constexpr size_t MIN_AGENTS_PER_ALLOCATION_SHARD = 100;
+
 // Default interval the master uses to send heartbeats to an HTTP
 // scheduler.
 constexpr Duration DEFAULT_HEARTBEAT_INTERVAL = Seconds(15);
@@ -474,6 +474,24 @@ mesos::internal::master::Flags::Flags()
       "  https://issues.apache.org/jira/browse/MESOS-7576",
       true);
 
+  add(&Flags::allocation_threads,
+      "allocation_threads",
+      "The number of threads used by the allocator to compute the offers\n"
+      "of an allocation cycle. With more than one thread, the hierarchical\n"
+      "allocator splits the agents into shards that are allocated\n"
+      "concurrently. The roles without quota are then allocated according\n"
+      "to their fair share at the start of the cycle rather than to their\n"
+      "shares as they change during the cycle. This shortens cycles in large\n"
+      "clusters at the expense of the fairness of the offers of a single\n"
+      "cycle. This only applies to the built-in allocator.",
+      1,
+      [](size_t value) -> Option<Error> {
+        if (value < 1) {
+          return Error("Expected --allocation_threads to be at least 1");
+        }
+        return None();
+      });
+
   add(&Flags::hooks,
       "hooks",
       "A comma-separated list of hook modules to be\n"
@@ -328,9 +328,14 @@ int main(int argc, char** argv)
     }
   }
 
-  // Create an instance of allocator.
+  // Create an instance of allocator. The built-in allocator is created
+  // directly, since the number of allocation threads is not part of the
+  // allocator module interface.
   const string allocatorName = flags.allocator;
-  Try<Allocator*> allocator = Allocator::create(allocatorName);
+  Try<Allocator*> allocator = allocatorName == DEFAULT_ALLOCATOR
+    ? mesos::internal::master::allocator::HierarchicalDRFAllocator::create(
+          flags.allocation_threads)
+    : Allocator::create(allocatorName);
 
   if (allocator.isError()) {
     EXIT(EXIT_FAILURE)
@@ -156,6 +156,7 @@ using process::Break;
 using process::Clock;
 using process::Continue;
 using process::ControlFlow;
+using process::EventPriority;
 using process::Failure;
 using process::Future;
 using process::Owned;
@@ -755,6 +756,10 @@ void Slave::initialize()
       &Slave::ping,
       &PingSlaveMessage::connected);
 
+  // Serve pings ahead of any other queued events so that a busy agent
+  // does not get marked unreachable by the master.
+  prioritize(PingSlaveMessage().GetTypeName(), EventPriority::HIGH);
+
   // Setup the '/api/v1' handler for streaming requests.
   RouteOptions options;
   options.requestStreaming = true;
@@ -218,6 +218,15 @@ mesos::allocator::Allocator* createAllocator()
   return CHECK_NOTNULL(instance.get());
 }
 
+
+template <typename T = master::allocator::HierarchicalDRFAllocator>
+mesos::allocator::Allocator* createAllocator(size_t allocationThreads)
+{
+  Try<mesos::allocator::Allocator*> instance = T::create(allocationThreads);
+  CHECK_SOME(instance);
+  return CHECK_NOTNULL(instance.get());
+}
+
 template <typename T = master::allocator::HierarchicalDRFAllocator>
 class TestAllocator : public mesos::allocator::Allocator
 {
@@ -133,7 +133,8 @@ Try<process::Owned<Master>> Master::start(
   // If the allocator is not provided, create a default one.
   if (allocator.isNone()) {
     Try<mesos::allocator::Allocator*> _allocator =
-      master::allocator::HierarchicalDRFAllocator::create();
+      master::allocator::HierarchicalDRFAllocator::create(
+          flags.allocation_threads);
 
     if (_allocator.isError()) {
       return Error(
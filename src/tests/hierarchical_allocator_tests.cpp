@@ -152,6 +152,14 @@ protected:
   {
     flags = _flags;
 
+    // The number of allocation threads is fixed when the allocator is
+    // created, so we start over with a new allocator if needed.
+    if (flags.allocation_threads != 1) {
+      delete allocator;
+      allocator = createAllocator<HierarchicalDRFAllocator>(
+          flags.allocation_threads);
+    }
+
     if (offerCallback.isNone()) {
       offerCallback =
         [this](const FrameworkID& frameworkId,
@@ -904,6 +912,67 @@ TEST_F(HierarchicalAllocatorTest, OfferFilter)
 }
 
 
+// This test ensures that an offer filter that refused all resources
+// of an agent no longer filters them once the total of the agent has
+// grown beyond the refused resources.
+TEST_F(HierarchicalAllocatorTest, OfferFilterUpdatedTotal)
+{
+  Clock::pause();
+
+  const string ROLE{"role"};
+
+  initialize();
+
+  FrameworkInfo framework = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  SlaveInfo agent = createSlaveInfo("cpus:1;mem:512;disk:0");
+  allocator->addSlave(
+      agent.id(),
+      agent,
+      AGENT_CAPABILITIES(),
+      None(),
+      agent.resources(),
+      {});
+
+  Allocation expected = Allocation(
+      framework.id(),
+      {{ROLE, {{agent.id(), agent.resources()}}}});
+
+  Future<Allocation> allocation = allocations.get();
+  AWAIT_EXPECT_EQ(expected, allocation);
+
+  // `framework` declines all resources of the agent for a long time.
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds(Days(1).secs());
+
+  allocator->recoverResources(
+      framework.id(),
+      agent.id(),
+      allocation->resources.at(ROLE).at(agent.id()),
+      offerFilter);
+
+  // There should be no allocation due to the offer filter.
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  allocation = allocations.get();
+  EXPECT_TRUE(allocation.isPending());
+
+  // Once the agent has more resources than were refused, they are
+  // offered to `framework`.
+  const Resources total = agent.resources() + Resources::parse("cpus:1").get();
+
+  allocator->updateSlave(agent.id(), agent, total);
+
+  expected = Allocation(
+      framework.id(),
+      {{ROLE, {{agent.id(), total}}}});
+
+  AWAIT_EXPECT_EQ(expected, allocation);
+}
+
+
 // This test ensures that an offer filter is not removed earlier than
 // the next batch allocation. See MESOS-4302 for more information.
 //
@@ -6006,6 +6075,241 @@ TEST_P(HierarchicalAllocatorTestWithParam, AllocateSharedResources)
 }
 
 
+class HierarchicalAllocatorTestWithThreads
+  : public HierarchicalAllocatorTestBase,
+    public WithParamInterface<size_t>
+{
+protected:
+  struct OfferedResources
+  {
+    FrameworkID frameworkId;
+    SlaveID slaveId;
+    Resources resources;
+  };
+
+  // Initializes the allocator with the number of allocation threads
+  // of the test, collecting the offers in `offers`.
+  void initializeWithThreads()
+  {
+    master::Flags flags_;
+    flags_.allocation_threads = GetParam();
+
+    initialize(
+        flags_,
+        [this](const FrameworkID& frameworkId,
+               const hashmap<string, hashmap<SlaveID, Resources>>& offered) {
+          foreachkey (const string& role, offered) {
+            foreachpair (const SlaveID& slaveId,
+                         const Resources& resources,
+                         offered.at(role)) {
+              offers.push_back(
+                  OfferedResources{frameworkId, slaveId, resources});
+            }
+          }
+        });
+  }
+
+  void addAgents(size_t count, const string& resources)
+  {
+    for (size_t i = 0; i < count; i++) {
+      SlaveInfo agent = createSlaveInfo(resources);
+
+      allocator->addSlave(
+          agent.id(),
+          agent,
+          AGENT_CAPABILITIES(),
+          None(),
+          agent.resources(),
+          {});
+    }
+  }
+
+  // Declines all offers without a filter and triggers a batch
+  // allocation, in which all the agents are allocated at once.
+  // Returns the offers of that allocation.
+  vector<OfferedResources> allocateAll()
+  {
+    Clock::settle();
+
+    foreach (const OfferedResources& offer, offers) {
+      allocator->recoverResources(
+          offer.frameworkId, offer.slaveId, offer.resources, None());
+    }
+
+    Clock::settle();
+    offers.clear();
+
+    Clock::advance(flags.allocation_interval);
+    Clock::settle();
+
+    return offers;
+  }
+
+  // Enough agents for the allocation to be split into as many shards
+  // as there are allocation threads.
+  const size_t agentCount = 4 * master::MIN_AGENTS_PER_ALLOCATION_SHARD;
+
+  vector<OfferedResources> offers;
+};
+
+
+// The HierarchicalAllocatorTestWithThreads tests are parameterized by
+// the number of allocation threads (see `--allocation_threads`). With
+// more than one thread, the agents are allocated in parallel shards.
+INSTANTIATE_TEST_CASE_P(
+    AllocationThreads,
+    HierarchicalAllocatorTestWithThreads,
+    ::testing::Values<size_t>(1, 2, 4));
+
+
+// Tests that every agent is offered in an allocation cycle, and that
+// identical roles get about the same number of agents.
+TEST_P(HierarchicalAllocatorTestWithThreads, AllAgentsOfferedFairly)
+{
+  Clock::pause();
+
+  initializeWithThreads();
+
+  const size_t frameworkCount = 4;
+
+  vector<FrameworkInfo> frameworks;
+  for (size_t i = 0; i < frameworkCount; i++) {
+    FrameworkInfo framework = createFrameworkInfo({"role" + stringify(i)});
+    allocator->addFramework(framework.id(), framework, {}, true, {});
+
+    frameworks.push_back(framework);
+  }
+
+  addAgents(agentCount, "cpus:1;mem:1024");
+
+  hashset<SlaveID> offeredAgents;
+  hashmap<FrameworkID, size_t> offerCounts;
+
+  foreach (const OfferedResources& offer, allocateAll()) {
+    EXPECT_FALSE(offeredAgents.contains(offer.slaveId))
+      << "Agent " << offer.slaveId << " was offered more than once";
+
+    offeredAgents.insert(offer.slaveId);
+    offerCounts[offer.frameworkId]++;
+  }
+
+  EXPECT_EQ(agentCount, offeredAgents.size());
+
+  // The agents are identical, so DRF offers each framework the same
+  // number of agents. A parallel allocation only approximates the
+  // order of the sorters, so we allow for some deviation.
+  const double expected = agentCount / frameworkCount;
+  const double deviation = GetParam() == 1 ? 0 : expected / 10;
+
+  foreach (const FrameworkInfo& framework, frameworks) {
+    EXPECT_NEAR(expected, offerCounts[framework.id()], deviation)
+      << "Framework " << framework.id();
+  }
+}
+
+
+// Tests that the quota headroom is held back in an allocation cycle,
+// however the agents are split between the allocation threads.
+TEST_P(HierarchicalAllocatorTestWithThreads, QuotaHeadroom)
+{
+  Clock::pause();
+
+  initializeWithThreads();
+
+  const string QUOTA_ROLE{"quota-role"};
+  const string NO_QUOTA_ROLE{"no-quota-role"};
+
+  // The quota role has no frameworks, so its entire guarantee has to
+  // be held back as headroom.
+  const size_t guaranteedAgents = 50;
+
+  const Quota quota = createQuota(
+      QUOTA_ROLE,
+      "cpus:" + stringify(guaranteedAgents) +
+      ";mem:" + stringify(guaranteedAgents * 1024));
+
+  allocator->setQuota(QUOTA_ROLE, quota);
+
+  FrameworkInfo framework = createFrameworkInfo({NO_QUOTA_ROLE});
+  allocator->addFramework(framework.id(), framework, {}, true, {});
+
+  addAgents(agentCount, "cpus:1;mem:1024");
+
+  Resources offered;
+  hashset<SlaveID> offeredAgents;
+
+  foreach (const OfferedResources& offer, allocateAll()) {
+    EXPECT_EQ(framework.id(), offer.frameworkId);
+
+    offered += offer.resources;
+    offeredAgents.insert(offer.slaveId);
+  }
+
+  // The agents are identical, so all but the agents needed for the
+  // guarantee are offered.
+  EXPECT_EQ(agentCount - guaranteedAgents, offeredAgents.size());
+
+  EXPECT_EQ(
+      Resources::parse(
+          "cpus:" + stringify(agentCount - guaranteedAgents) +
+          ";mem:" + stringify((agentCount - guaranteedAgents) * 1024)).get(),
+      offered.createStrippedScalarQuantity());
+}
+
+
+// Tests that the agents refused by a framework are offered to the
+// other framework of the role, and not to the refusing framework.
+TEST_P(HierarchicalAllocatorTestWithThreads, OfferFilters)
+{
+  Clock::pause();
+
+  initializeWithThreads();
+
+  const string ROLE{"role"};
+
+  FrameworkInfo framework1 = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework1.id(), framework1, {}, true, {});
+
+  FrameworkInfo framework2 = createFrameworkInfo({ROLE});
+  allocator->addFramework(framework2.id(), framework2, {}, true, {});
+
+  addAgents(agentCount, "cpus:1;mem:1024");
+
+  // `framework1` declines the agents it is offered for a long time,
+  // while `framework2` keeps its offers.
+  Filters offerFilter;
+  offerFilter.set_refuse_seconds(Days(1).secs());
+
+  hashset<SlaveID> refusedAgents;
+
+  foreach (const OfferedResources& offer, allocateAll()) {
+    if (offer.frameworkId == framework1.id()) {
+      allocator->recoverResources(
+          offer.frameworkId, offer.slaveId, offer.resources, offerFilter);
+
+      refusedAgents.insert(offer.slaveId);
+    }
+  }
+
+  EXPECT_FALSE(refusedAgents.empty());
+
+  Clock::settle();
+  offers.clear();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  hashset<SlaveID> offeredAgents;
+
+  foreach (const OfferedResources& offer, offers) {
+    EXPECT_EQ(framework2.id(), offer.frameworkId);
+    offeredAgents.insert(offer.slaveId);
+  }
+
+  EXPECT_EQ(refusedAgents, offeredAgents);
+}
+
+
 // Resource sharing types used for the PersistentVolumes benchmark test:
 //
 // 1. `REGULAR` uses no shared resources.
@@ -6505,6 +6809,109 @@ TEST_P(HierarchicalAllocator_BENCHMARK_Test, DeclineOffers)
 }
 
 
+// This benchmark measures the duration of allocation cycles as the
+// number of allocation threads grows, see `--allocation_threads`.
+TEST_P(HierarchicalAllocator_BENCHMARK_Test, ParallelAllocation)
+{
+  size_t slaveCount = std::get<0>(GetParam());
+  size_t frameworkCount = std::get<1>(GetParam());
+
+  // Pause the clock because we want to manually drive the allocations.
+  Clock::pause();
+
+  struct OfferedResources
+  {
+    FrameworkID   frameworkId;
+    SlaveID       slaveId;
+    Resources     resources;
+  };
+
+  vector<OfferedResources> offers;
+
+  auto offerCallback = [&offers](
+      const FrameworkID& frameworkId,
+      const hashmap<string, hashmap<SlaveID, Resources>>& resources_)
+  {
+    foreachkey (const string& role, resources_) {
+      foreachpair (const SlaveID& slaveId,
+                   const Resources& resources,
+                   resources_.at(role)) {
+        offers.push_back(OfferedResources{frameworkId, slaveId, resources});
+      }
+    }
+  };
+
+  cout << "Using " << slaveCount << " agents and "
+       << frameworkCount << " frameworks" << endl;
+
+  const Resources agentResources = Resources::parse(
+      "cpus:24;mem:4096;disk:4096;ports:[31000-32000]").get();
+
+  for (size_t threads : {1, 2, 4, 8}) {
+    // Start over with a new allocator for each number of threads.
+    delete allocator;
+    allocator = createAllocator<HierarchicalDRFAllocator>();
+
+    master::Flags flags;
+    flags.allocation_threads = threads;
+
+    initialize(flags, offerCallback);
+
+    // Each framework gets its own role, which is the most expensive
+    // case for an allocation cycle.
+    for (size_t i = 0; i < frameworkCount; i++) {
+      FrameworkInfo framework = createFrameworkInfo({"role" + stringify(i)});
+      allocator->addFramework(framework.id(), framework, {}, true, {});
+    }
+
+    for (size_t i = 0; i < slaveCount; i++) {
+      SlaveInfo slave = createSlaveInfo(agentResources);
+
+      allocator->addSlave(
+          slave.id(),
+          slave,
+          AGENT_CAPABILITIES(),
+          None(),
+          slave.resources(),
+          {});
+    }
+
+    // Wait for all the `addSlave` operations to be processed.
+    Clock::settle();
+
+    for (size_t round = 0; round < 3; round++) {
+      // Decline all offers without a filter so that each cycle
+      // allocates all the agents again.
+      foreach (const OfferedResources& offer, offers) {
+        allocator->recoverResources(
+            offer.frameworkId, offer.slaveId, offer.resources, None());
+      }
+
+      // Wait for the declined offers.
+      Clock::settle();
+      offers.clear();
+
+      Stopwatch watch;
+      watch.start();
+
+      // Advance the clock and trigger a background allocation cycle.
+      Clock::advance(flags.allocation_interval);
+      Clock::settle();
+
+      watch.stop();
+
+      cout << "round " << round << " with " << threads << " threads"
+           << " allocate() took " << watch.elapsed()
+           << " to make " << offers.size() << " offers" << endl;
+    }
+
+    offers.clear();
+  }
+
+  Clock::resume();
+}
+
+
 // Returns the requested number of labels:
 //   [{"<key>_1": "<value>_1"}, ..., {"<key>_<count>":"<value>_<count>"}]
 static Labels createLabels(
@@ -31,6 +31,7 @@
 
 #include <mesos/v1/resources.hpp>
 
+#include "common/resource_quantities.hpp"
 #include "common/resources_utils.hpp"
 
 #include "internal/evolve.hpp"
@@ -3557,6 +3558,112 @@ TEST(AllocatedResourcesTest, Allocations)
 }
 
 
+TEST(ResourceQuantitiesTest, Arithmetic)
+{
+  Resources resources = Resources::parse(
+      "cpus:1;mem:512;gpus:1;cpus(role):2;foo:3;ports:[1-10]").get();
+
+  ResourceQuantities quantities =
+    ResourceQuantities::fromScalarResources(resources);
+
+  EXPECT_DOUBLE_EQ(3, quantities.get("cpus").value());
+  EXPECT_DOUBLE_EQ(512, quantities.get("mem").value());
+  EXPECT_DOUBLE_EQ(1, quantities.get("gpus").value());
+  EXPECT_DOUBLE_EQ(3, quantities.get("foo").value());
+  EXPECT_DOUBLE_EQ(0, quantities.get("disk").value());
+  EXPECT_DOUBLE_EQ(0, quantities.get("ports").value());
+
+  ResourceQuantities sum = quantities + quantities;
+  EXPECT_DOUBLE_EQ(6, sum.get("cpus").value());
+  EXPECT_DOUBLE_EQ(6, sum.get("foo").value());
+  EXPECT_EQ(quantities, sum - quantities);
+
+  // Quantities do not become negative.
+  ResourceQuantities small = ResourceQuantities::fromScalarResources(
+      Resources::parse("cpus:0.1;foo:1").get());
+
+  ResourceQuantities difference = small - quantities;
+  EXPECT_TRUE(difference.empty());
+  EXPECT_EQ(ResourceQuantities(), difference);
+
+  // The fixed point representation of `Value::Scalar` is preserved.
+  ResourceQuantities tenth;
+  for (int i = 0; i < 10; ++i) {
+    tenth += small;
+  }
+
+  EXPECT_DOUBLE_EQ(1, tenth.get("cpus").value());
+  EXPECT_EQ(
+      "cpus:1;foo:10",
+      stringify(tenth - ResourceQuantities::fromScalarResources(
+          Resources::parse("mem:1").get())));
+}
+
+
+TEST(ResourceQuantitiesTest, Contains)
+{
+  ResourceQuantities empty;
+
+  ResourceQuantities quantities = ResourceQuantities::fromScalarResources(
+      Resources::parse("cpus:2;mem:1024;foo:1;bar:2").get());
+
+  EXPECT_TRUE(empty.contains(empty));
+  EXPECT_TRUE(quantities.contains(empty));
+  EXPECT_FALSE(empty.contains(quantities));
+  EXPECT_TRUE(quantities.contains(quantities));
+
+  EXPECT_TRUE(quantities.contains(ResourceQuantities::fromScalarResources(
+      Resources::parse("cpus:1;bar:2").get())));
+
+  EXPECT_FALSE(quantities.contains(ResourceQuantities::fromScalarResources(
+      Resources::parse("cpus:3").get())));
+
+  EXPECT_FALSE(quantities.contains(ResourceQuantities::fromScalarResources(
+      Resources::parse("bar:3").get())));
+
+  EXPECT_FALSE(quantities.contains(ResourceQuantities::fromScalarResources(
+      Resources::parse("baz:1").get())));
+}
+
+
+TEST(ResourceQuantitiesTest, ForeachQuantity)
+{
+  ResourceQuantities total = ResourceQuantities::fromScalarResources(
+      Resources::parse("cpus:4;mem:1024;bar:2;foo:8").get());
+
+  ResourceQuantities allocation = ResourceQuantities::fromScalarResources(
+      Resources::parse("cpus:1;disk:10;foo:2;baz:1").get());
+
+  EXPECT_DOUBLE_EQ(4, total.get(ResourceQuantities::CPUS));
+  EXPECT_DOUBLE_EQ(0, total.get(ResourceQuantities::GPUS));
+
+  vector<string> names;
+  total.foreachQuantity([&names](const string& name, double) {
+    names.push_back(name);
+  });
+
+  EXPECT_EQ((vector<string>{"cpus", "mem", "bar", "foo"}), names);
+
+  // Only the resources present in `total` are visited, along with
+  // their quantity in `allocation`.
+  map<string, pair<double, double>> visited;
+  total.foreachQuantity(
+      allocation,
+      [&visited](const string& name, double quantity, double that) {
+        visited[name] = {quantity, that};
+      });
+
+  map<string, pair<double, double>> expected = {
+    {"cpus", {4, 1}},
+    {"mem", {1024, 0}},
+    {"bar", {2, 0}},
+    {"foo", {8, 2}}
+  };
+
+  EXPECT_EQ(expected, visited);
+}
+
+
 struct ScalarArithmeticParameter
 {
   Resources resources;
@@ -3720,6 +3827,57 @@ TEST_P(Resources_Scalar_Arithmetic_BENCHMARK_Test, Arithmetic)
 }
 
 
+// Performs the same arithmetic as above on the scalar quantities of
+// the resources, as the allocator does for the quota headroom and the
+// sorter does for the shares.
+TEST_P(Resources_Scalar_Arithmetic_BENCHMARK_Test, Quantities)
+{
+  const ResourceQuantities quantities =
+    ResourceQuantities::fromScalarResources(GetParam().resources);
+
+  size_t totalOperations = GetParam().totalOperations;
+
+  ResourceQuantities total;
+  Stopwatch watch;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    total += quantities;
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'total += q' operations"
+       << " on " << abbreviate(stringify(quantities), 50) << endl;
+
+  size_t contained = 0;
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    contained += total.contains(quantities);
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'total.contains(q)'"
+       << " operations on " << abbreviate(stringify(quantities), 50) << endl;
+
+  EXPECT_EQ(totalOperations, contained);
+
+  watch.start();
+  for (size_t i = 0; i < totalOperations; i++) {
+    total -= quantities;
+  }
+  watch.stop();
+
+  cout << "Took " << watch.elapsed()
+       << " to perform " << totalOperations << " 'total -= q' operations"
+       << " on " << abbreviate(stringify(quantities), 50) << endl;
+
+  ASSERT_TRUE(total.empty()) << total;
+}
+
+
 class Resources_Filter_BENCHMARK_Test : public ::testing::Test {};
 
 
@@ -1107,6 +1107,49 @@ TEST(SorterTest, MultipleSlaves)
 }
 
 
+// The sorter refers to agents by an index internally. This tests that
+// an agent stays known while a client has an allocation on it, even
+// after its total has been removed, and that the index of a removed
+// agent can be reused for another agent.
+TEST(SorterTest, RemoveAndAddSlaves)
+{
+  DRFSorter sorter;
+
+  SlaveID slaveA;
+  slaveA.set_value("agentA");
+
+  SlaveID slaveB;
+  slaveB.set_value("agentB");
+
+  sorter.add("framework");
+  sorter.activate("framework");
+
+  Resources slaveResources = Resources::parse("cpus:2;mem:512").get();
+
+  sorter.add(slaveA, slaveResources);
+  sorter.allocated("framework", slaveA, slaveResources);
+
+  sorter.remove(slaveA, slaveResources);
+
+  EXPECT_EQ(slaveResources, sorter.allocation("framework", slaveA));
+  EXPECT_EQ(1u, sorter.allocation(slaveA).size());
+
+  sorter.unallocated("framework", slaveA, slaveResources);
+
+  EXPECT_TRUE(sorter.allocation("framework").empty());
+  EXPECT_TRUE(sorter.allocation(slaveA).empty());
+
+  sorter.add(slaveB, slaveResources);
+  sorter.allocated("framework", slaveB, slaveResources);
+
+  EXPECT_EQ(1u, sorter.allocation("framework").size());
+  EXPECT_TRUE(sorter.allocation("framework").contains(slaveB));
+  EXPECT_EQ(slaveResources, sorter.allocation("framework", slaveB));
+  EXPECT_EQ(Resources(), sorter.allocation("framework", slaveA));
+  EXPECT_TRUE(sorter.allocation(slaveA).empty());
+}
+
+
 // We aggregate resources from multiple slaves into the sorter. Since
 // non-scalar resources don't aggregate well across slaves, we need to
 // keep track of the SlaveIDs of the resources. This tests that no
@@ -1661,6 +1704,28 @@ TEST_P(Sorter_BENCHMARK_Test, FullSort)
   cout << "No-op sort of " << clientCount << " clients took "
        << watch.elapsed() << endl;
 
+  Resources task = Resources::parse("cpus:1;mem:32").get();
+
+  watch.start();
+  {
+    // Launch and then finish a task for each client in turn, sorting
+    // after every change as the allocator does. Only the client and
+    // its ancestors need to be repositioned by these sorts.
+    for (size_t i = 0; i < clients.size(); i++) {
+      const SlaveID& slaveId = agents[i % agents.size()];
+
+      sorter.allocated(clients[i], slaveId, task);
+      sorter.sort();
+
+      sorter.unallocated(clients[i], slaveId, task);
+      sorter.sort();
+    }
+  }
+  watch.stop();
+
+  cout << "Incremental sorts after " << 2 * clients.size()
+       << " allocation changes took " << watch.elapsed() << endl;
+
   watch.start();
   {
     // Unallocate resources on all agents, round-robin through the clients.
@@ -1840,6 +1905,28 @@ TEST_P(HierarchicalSorter_BENCHMARK_Test, FullSort)
   cout << "No-op sort of " << clientCount << " clients took "
        << watch.elapsed() << endl;
 
+  Resources task = Resources::parse("cpus:1;mem:32").get();
+
+  watch.start();
+  {
+    // Launch and then finish a task for each client in turn, sorting
+    // after every change as the allocator does. Only the client and
+    // its ancestors need to be repositioned by these sorts.
+    for (size_t i = 0; i < clients.size(); i++) {
+      const SlaveID& slaveId = agents[i % agents.size()];
+
+      sorter.allocated(clients[i], slaveId, task);
+      sorter.sort();
+
+      sorter.unallocated(clients[i], slaveId, task);
+      sorter.sort();
+    }
+  }
+  watch.stop();
+
+  cout << "Incremental sorts after " << 2 * clients.size()
+       << " allocation changes took " << watch.elapsed() << endl;
+
   watch.start();
   {
     // Unallocate resources on all agents, round-robin through the clients.